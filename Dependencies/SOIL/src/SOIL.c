@@ -32,14 +32,15 @@
 
 #include "SOIL.h"
 #include "stb_image_aug.h"
+#include "stbi_QOI_aug.h"
 #include "image_helper.h"
 #include "image_DXT.h"
 
 #include <stdlib.h>
 #include <string.h>
 
-/*	error reporting	*/
-char *result_string_pointer = "SOIL initialized";
+/*	error reporting, per thread like stb_image's failure reason	*/
+static STBI_THREAD_LOCAL char *result_string_pointer = "SOIL initialized";
 
 /*	for loading cube maps	*/
 enum{
@@ -48,6 +49,17 @@ enum{
 	SOIL_CAPABILITY_PRESENT = 1
 };
 static int has_cubemap_capability = SOIL_CAPABILITY_UNKNOWN;
+
+/*	QOI is an add-on stbi loader, hook it in before the first load	*/
+static int has_registered_loaders = 0;
+static void register_loaders( void )
+{
+	if( !has_registered_loaders )
+	{
+		stbi_register_loader( &stbi_qoi_loader );
+		has_registered_loaders = 1;
+	}
+}
 int query_cubemap_capability( void );
 #define SOIL_TEXTURE_WRAP_R					0x8072
 #define SOIL_CLAMP_TO_EDGE					0x812F
@@ -1429,7 +1441,9 @@ unsigned char*
 		int force_channels
 	)
 {
-	unsigned char *result = stbi_load( filename,
+	unsigned char *result;
+	register_loaders();
+	result = stbi_load( filename,
 			width, height, channels, force_channels );
 	if( result == NULL )
 	{
@@ -1450,7 +1464,9 @@ unsigned char*
 		int force_channels
 	)
 {
-	unsigned char *result = stbi_load_from_memory(
+	unsigned char *result;
+	register_loaders();
+	result = stbi_load_from_memory(
 				buffer, buffer_length,
 				width, height, channels,
 				force_channels );
@@ -1498,6 +1514,11 @@ int
 		save_result = save_image_as_DDS( filename,
 				width, height, channels, (const unsigned char *const)data );
 	} else
+	if( image_type == SOIL_SAVE_TYPE_QOI )
+	{
+		save_result = stbi_write_qoi( filename,
+				width, height, channels, (void*)data );
+	} else
 	{
 		save_result = 0;
 	}
@@ -1529,6 +1550,15 @@ const char*
 	return result_string_pointer;
 }
 
+void
+	SOIL_register_loaders
+	(
+		void
+	)
+{
+	register_loaders();
+}
+
 unsigned int SOIL_direct_load_DDS_from_memory(
 		const unsigned char *const buffer,
 		int buffer_length,
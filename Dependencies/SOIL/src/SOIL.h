@@ -21,6 +21,7 @@
 	- BMP		load & save
 	- TGA		load & save
 	- DDS		load & save
+	- QOI		load & save
 	- PNG		load
 	- JPG		load
 
@@ -111,12 +112,14 @@ enum
 	(TGA supports uncompressed RGB / RGBA)
 	(BMP supports uncompressed RGB)
 	(DDS supports DXT1 and DXT5)
+	(QOI supports lossless RGB / RGBA)
 **/
 enum
 {
 	SOIL_SAVE_TYPE_TGA = 0,
 	SOIL_SAVE_TYPE_BMP = 1,
-	SOIL_SAVE_TYPE_DDS = 2
+	SOIL_SAVE_TYPE_DDS = 2,
+	SOIL_SAVE_TYPE_QOI = 3
 };
 
 /**
@@ -416,8 +419,8 @@ void
 
 /**
 	This function resturn a pointer to a string describing the last thing
-	that happened inside SOIL.  It can be used to determine why an image
-	failed to load.
+	that happened inside SOIL on the calling thread.  It can be used to
+	determine why an image failed to load.
 **/
 const char*
 	SOIL_last_result
@@ -425,6 +428,17 @@ const char*
 		void
 	);
 
+/**
+	Registers the add-on image loaders (QOI) with stb_image.  The load
+	functions do this on first use, which is not thread safe: call this
+	once before loading from several threads.
+**/
+void
+	SOIL_register_loaders
+	(
+		void
+	);
+
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,121 @@
+/*
+	QOI vs PNG decode benchmark
+
+	Usage: bench_QOI image.png [more.png ...]
+
+	Each image is loaded once, re-encoded to QOI in memory, and then
+	both encodings are decoded from memory repeatedly so the numbers
+	only measure the decoders, not the disk.
+*/
+
+#include "SOIL.h"
+#include "stb_image_aug.h"
+#include "stbi_QOI_aug.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_ITERATIONS 20
+
+static double now_ms( void )
+{
+	struct timespec ts;
+	timespec_get( &ts, TIME_UTC );
+	return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static unsigned char *read_file( const char *filename, int *len )
+{
+	unsigned char *buffer;
+	long size;
+	FILE *f = fopen( filename, "rb" );
+	if( f == NULL )
+		return NULL;
+	fseek( f, 0, SEEK_END );
+	size = ftell( f );
+	fseek( f, 0, SEEK_SET );
+	buffer = (unsigned char*)malloc( size );
+	if( (buffer != NULL) && (fread( buffer, 1, size, f ) != (size_t)size) )
+	{
+		free( buffer );
+		buffer = NULL;
+	}
+	fclose( f );
+	*len = (int)size;
+	return buffer;
+}
+
+static double time_decode( const unsigned char *buffer, int len )
+{
+	int i, w, h, c;
+	double start = now_ms();
+	for( i = 0; i < BENCH_ITERATIONS; ++i )
+	{
+		SOIL_free_image_data( SOIL_load_image_from_memory( buffer, len, &w, &h, &c, SOIL_LOAD_AUTO ) );
+	}
+	return (now_ms() - start) / BENCH_ITERATIONS;
+}
+
+int main( int argc, char **argv )
+{
+	int i;
+	double png_total = 0.0, qoi_total = 0.0;
+	long png_bytes = 0, qoi_bytes = 0;
+
+	if( argc < 2 )
+	{
+		printf( "usage: %s image.png [more.png ...]\n", argv[0] );
+		return 1;
+	}
+
+	printf( "%-32s %10s %10s %10s %10s\n", "image", "png KB", "qoi KB", "png ms", "qoi ms" );
+	for( i = 1; i < argc; ++i )
+	{
+		int png_len, qoi_len, w, h, c;
+		unsigned char *png, *pixels, *qoi;
+		double png_ms, qoi_ms;
+
+		png = read_file( argv[i], &png_len );
+		if( png == NULL )
+		{
+			printf( "%-32s could not be read\n", argv[i] );
+			continue;
+		}
+		pixels = SOIL_load_image_from_memory( png, png_len, &w, &h, &c, SOIL_LOAD_AUTO );
+		if( pixels == NULL )
+		{
+			printf( "%-32s %s\n", argv[i], SOIL_last_result() );
+			free( png );
+			continue;
+		}
+		qoi = stbi_qoi_encode( w, h, c, pixels, &qoi_len );
+		SOIL_free_image_data( pixels );
+		if( qoi == NULL )
+		{
+			printf( "%-32s QOI encoding failed\n", argv[i] );
+			free( png );
+			continue;
+		}
+
+		png_ms = time_decode( png, png_len );
+		qoi_ms = time_decode( qoi, qoi_len );
+		printf( "%-32s %10.1f %10.1f %10.3f %10.3f\n", argv[i],
+				png_len / 1024.0, qoi_len / 1024.0, png_ms, qoi_ms );
+
+		png_total += png_ms;
+		qoi_total += qoi_ms;
+		png_bytes += png_len;
+		qoi_bytes += qoi_len;
+		free( png );
+		free( qoi );
+	}
+
+	if( qoi_total > 0.0 )
+	{
+		printf( "total: png %.1f KB in %.3f ms, qoi %.1f KB in %.3f ms (%.2fx faster)\n",
+				png_bytes / 1024.0, png_total, qoi_bytes / 1024.0, qoi_total, png_total / qoi_total );
+	}
+	return 0;
+}
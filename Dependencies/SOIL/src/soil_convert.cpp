@@ -0,0 +1,426 @@
+/*
+	Batch image converter
+
+	Usage: soil_convert [options] input_dir output_dir
+
+	  -f tga|bmp|dds|qoi   output format (default tga)
+	  -c 0|1|2|3|4         force channel count, 0 keeps the source (default 0)
+	  -pot                 scale up to power-of-two sizes (up_scale_image)
+	  -max N               halve (mipmap_image) until no side is over N pixels
+	  -j N                 worker threads (default: hardware threads)
+	  -mem MB              decoded pixels allowed in flight (default 512)
+
+	Every file under input_dir is decoded with stb_image_aug, resized and
+	written with SOIL_save_image to the same relative path under output_dir.
+	Inputs that differ only by extension (a.png, a.jpg) keep it in the stem
+	(a.png.tga, a.jpg.tga) rather than overwrite each other.
+	Files are dealt out to per-worker deques; a worker pops from the back of
+	its own deque and steals from the front of the others once it runs dry.
+
+	Memory is bounded by a byte budget: before reading its next file a worker
+	waits until the pixels other workers still hold fit the budget, so at most
+	one image per worker can overshoot it (a single huge image still goes
+	through on its own).
+*/
+
+#include "SOIL.h"
+#include "stb_image_aug.h"
+#include "stbi_QOI_aug.h"
+#include "image_helper.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+enum Stage
+{
+	STAGE_READ,
+	STAGE_DECODE,
+	STAGE_RESIZE,
+	STAGE_ENCODE,
+	STAGE_COUNT
+};
+
+static const char *stage_names[STAGE_COUNT] = { "read", "decode", "resize", "encode" };
+
+struct Options
+{
+	int save_type = SOIL_SAVE_TYPE_TGA;
+	const char *extension = ".tga";
+	int channels = SOIL_LOAD_AUTO;
+	bool power_of_two = false;
+	int max_size = 0;
+	unsigned threads = 0;
+	size_t memory_limit = size_t( 512 ) << 20;
+};
+
+struct Job
+{
+	fs::path input;
+	fs::path output;
+};
+
+/*	one deque per worker, each behind its own lock so owners and thieves
+	only ever contend on the deque they touch	*/
+struct WorkQueue
+{
+	std::mutex lock;
+	std::deque<size_t> jobs;
+};
+
+struct Stats
+{
+	std::atomic<long long> stage_ns[STAGE_COUNT] = {};
+	std::atomic<long long> bytes_in{ 0 };
+	std::atomic<long long> bytes_out{ 0 };
+	std::atomic<int> converted{ 0 };
+	std::atomic<int> failed{ 0 };
+	std::atomic<int> stolen{ 0 };
+};
+
+/*	byte budget for decoded pixels that are currently held by workers	*/
+class MemoryGate
+{
+public:
+	explicit MemoryGate( size_t limit ) : limit_( limit ) {}
+
+	void wait_for_room()
+	{
+		std::unique_lock<std::mutex> guard( lock_ );
+		room_.wait( guard, [this] { return in_flight_ == 0 || in_flight_ < limit_; } );
+	}
+	void acquire( size_t bytes )
+	{
+		std::lock_guard<std::mutex> guard( lock_ );
+		in_flight_ += bytes;
+		if( in_flight_ > peak_ )
+			peak_ = in_flight_;
+	}
+	void release( size_t bytes )
+	{
+		{
+			std::lock_guard<std::mutex> guard( lock_ );
+			in_flight_ -= bytes;
+		}
+		room_.notify_all();
+	}
+	size_t peak() const { return peak_; }
+
+private:
+	std::mutex lock_;
+	std::condition_variable room_;
+	size_t limit_;
+	size_t in_flight_ = 0;
+	size_t peak_ = 0;
+};
+
+class StageTimer
+{
+public:
+	StageTimer( Stats &stats, Stage stage )
+		: stats_( stats ), stage_( stage ), start_( std::chrono::steady_clock::now() ) {}
+	~StageTimer()
+	{
+		auto elapsed = std::chrono::steady_clock::now() - start_;
+		stats_.stage_ns[stage_] += std::chrono::duration_cast<std::chrono::nanoseconds>( elapsed ).count();
+	}
+
+private:
+	Stats &stats_;
+	Stage stage_;
+	std::chrono::steady_clock::time_point start_;
+};
+
+static bool read_file( const fs::path &path, std::vector<unsigned char> &buffer )
+{
+	std::ifstream file( path, std::ios::binary | std::ios::ate );
+	if( !file )
+		return false;
+	buffer.resize( size_t( file.tellg() ) );
+	file.seekg( 0 );
+	return bool( file.read( (char*)buffer.data(), buffer.size() ) );
+}
+
+static int next_power_of_two( int value )
+{
+	int result = 1;
+	while( result < value )
+		result *= 2;
+	return result;
+}
+
+/*	the resize steps SOIL_internal_create_OGL_texture takes, minus GL, except
+	that -max keeps halving until the limit really holds	*/
+static unsigned char *resize_image( unsigned char *img, int &width, int &height, int channels,
+		const Options &options, MemoryGate &gate, size_t &held )
+{
+	if( options.power_of_two )
+	{
+		int new_width = next_power_of_two( width );
+		int new_height = next_power_of_two( height );
+		if( (new_width != width) || (new_height != height) )
+		{
+			size_t bytes = size_t( channels ) * new_width * new_height;
+			unsigned char *resampled = (unsigned char*)malloc( bytes );
+			gate.acquire( bytes );
+			up_scale_image( img, width, height, channels, resampled, new_width, new_height );
+			SOIL_free_image_data( img );
+			gate.release( held );
+			held = bytes;
+			img = resampled;
+			width = new_width;
+			height = new_height;
+		}
+	}
+	while( options.max_size > 0 && (width > options.max_size || height > options.max_size) )
+	{
+		/*	sides that already fit are left alone; halving keeps -pot sizes powers of two	*/
+		int block_x = width > options.max_size ? 2 : 1;
+		int block_y = height > options.max_size ? 2 : 1;
+		int new_width = width / block_x;
+		int new_height = height / block_y;
+		size_t bytes = size_t( channels ) * new_width * new_height;
+		unsigned char *resampled = (unsigned char*)malloc( bytes );
+		gate.acquire( bytes );
+		mipmap_image( img, width, height, channels, resampled, block_x, block_y );
+		SOIL_free_image_data( img );
+		gate.release( held );
+		held = bytes;
+		img = resampled;
+		width = new_width;
+		height = new_height;
+	}
+	return img;
+}
+
+static void convert( const Job &job, const Options &options, MemoryGate &gate, Stats &stats )
+{
+	std::vector<unsigned char> encoded;
+	unsigned char *img;
+	int width, height, channels;
+	size_t held;
+
+	gate.wait_for_room();
+	{
+		StageTimer timer( stats, STAGE_READ );
+		if( !read_file( job.input, encoded ) )
+		{
+			printf( "%s: could not be read\n", job.input.string().c_str() );
+			stats.failed++;
+			return;
+		}
+	}
+	stats.bytes_in += encoded.size();
+
+	{
+		StageTimer timer( stats, STAGE_DECODE );
+		img = stbi_load_from_memory( encoded.data(), (int)encoded.size(), &width, &height, &channels, options.channels );
+	}
+	encoded = std::vector<unsigned char>();
+	if( img == NULL )
+	{
+		printf( "%s: %s\n", job.input.string().c_str(), stbi_failure_reason() );
+		stats.failed++;
+		return;
+	}
+	if( options.channels != SOIL_LOAD_AUTO )
+		channels = options.channels;
+	held = size_t( channels ) * width * height;
+	gate.acquire( held );
+
+	{
+		StageTimer timer( stats, STAGE_RESIZE );
+		img = resize_image( img, width, height, channels, options, gate, held );
+	}
+
+	bool saved;
+	{
+		StageTimer timer( stats, STAGE_ENCODE );
+		std::error_code error;
+		fs::create_directories( job.output.parent_path(), error );
+		saved = SOIL_save_image( job.output.string().c_str(), options.save_type, width, height, channels, img ) != 0;
+	}
+	SOIL_free_image_data( img );
+	gate.release( held );
+
+	if( !saved )
+	{
+		printf( "%s: %s\n", job.output.string().c_str(), SOIL_last_result() );
+		stats.failed++;
+		return;
+	}
+	std::error_code error;
+	stats.bytes_out += (long long)fs::file_size( job.output, error );
+	stats.converted++;
+}
+
+static bool pop_or_steal( std::vector<WorkQueue> &queues, unsigned self, size_t &job, Stats &stats )
+{
+	{
+		std::lock_guard<std::mutex> guard( queues[self].lock );
+		if( !queues[self].jobs.empty() )
+		{
+			job = queues[self].jobs.back();
+			queues[self].jobs.pop_back();
+			return true;
+		}
+	}
+	for( unsigned i = 1; i < queues.size(); ++i )
+	{
+		WorkQueue &victim = queues[(self + i) % queues.size()];
+		std::lock_guard<std::mutex> guard( victim.lock );
+		if( !victim.jobs.empty() )
+		{
+			job = victim.jobs.front();
+			victim.jobs.pop_front();
+			stats.stolen++;
+			return true;
+		}
+	}
+	/*	nothing is ever queued after the start, so empty everywhere means done	*/
+	return false;
+}
+
+static bool parse_format( const char *name, Options &options )
+{
+	if( !strcmp( name, "tga" ) ) { options.save_type = SOIL_SAVE_TYPE_TGA; options.extension = ".tga"; }
+	else if( !strcmp( name, "bmp" ) ) { options.save_type = SOIL_SAVE_TYPE_BMP; options.extension = ".bmp"; }
+	else if( !strcmp( name, "dds" ) ) { options.save_type = SOIL_SAVE_TYPE_DDS; options.extension = ".dds"; }
+	else if( !strcmp( name, "qoi" ) ) { options.save_type = SOIL_SAVE_TYPE_QOI; options.extension = ".qoi"; }
+	else return false;
+	return true;
+}
+
+static int usage( const char *program )
+{
+	printf( "usage: %s [-f tga|bmp|dds|qoi] [-c channels] [-pot] [-max N] [-j threads] [-mem MB] input_dir output_dir\n", program );
+	return 1;
+}
+
+int main( int argc, char **argv )
+{
+	Options options;
+	const char *input_dir = NULL, *output_dir = NULL;
+
+	for( int i = 1; i < argc; ++i )
+	{
+		bool has_value = i + 1 < argc;
+		if( !strcmp( argv[i], "-f" ) && has_value )
+		{
+			if( !parse_format( argv[++i], options ) )
+				return usage( argv[0] );
+		}
+		else if( !strcmp( argv[i], "-c" ) && has_value ) options.channels = atoi( argv[++i] );
+		else if( !strcmp( argv[i], "-pot" ) ) options.power_of_two = true;
+		else if( !strcmp( argv[i], "-max" ) && has_value ) options.max_size = atoi( argv[++i] );
+		else if( !strcmp( argv[i], "-j" ) && has_value ) options.threads = (unsigned)atoi( argv[++i] );
+		else if( !strcmp( argv[i], "-mem" ) && has_value ) options.memory_limit = size_t( atoi( argv[++i] ) ) << 20;
+		else if( argv[i][0] != '-' && input_dir == NULL ) input_dir = argv[i];
+		else if( argv[i][0] != '-' && output_dir == NULL ) output_dir = argv[i];
+		else return usage( argv[0] );
+	}
+	if( (input_dir == NULL) || (output_dir == NULL) || (options.channels < 0) || (options.channels > 4) || (options.max_size < 0) )
+		return usage( argv[0] );
+	if( options.threads == 0 )
+		options.threads = std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 1;
+
+	std::vector<Job> jobs;
+	std::error_code error;
+	for( fs::recursive_directory_iterator it( input_dir, error ), end; !error && it != end; it.increment( error ) )
+	{
+		if( !it->is_regular_file() )
+			continue;
+		Job job;
+		job.input = it->path();
+		job.output = fs::path( output_dir ) / fs::relative( job.input, input_dir );
+		job.output.replace_extension( options.extension );
+		jobs.push_back( job );
+	}
+	if( error )
+	{
+		printf( "%s: %s\n", input_dir, error.message().c_str() );
+		return 1;
+	}
+	if( jobs.empty() )
+	{
+		printf( "%s: no files to convert\n", input_dir );
+		return 0;
+	}
+
+	/*	replacing the extension can map several inputs onto one output, and two
+		workers writing the same file would leave whichever lost the race	*/
+	std::map<fs::path, int> outputs;
+	for( const Job &job : jobs )
+		++outputs[job.output];
+	for( Job &job : jobs )
+	{
+		if( outputs[job.output] > 1 )
+		{
+			job.output.replace_filename( job.input.filename() );
+			job.output += options.extension;
+		}
+	}
+	outputs.clear();
+	for( const Job &job : jobs )
+	{
+		if( ++outputs[job.output] > 1 )
+		{
+			printf( "%s: more than one input would be written here\n", job.output.string().c_str() );
+			return 1;
+		}
+	}
+
+	/*	registration is not thread safe, so it happens before any worker starts	*/
+	stbi_register_loader( &stbi_qoi_loader );
+
+	/*	contiguous runs per worker, so neighbouring (similar) files mostly
+		stay on one thread until someone has to steal	*/
+	std::vector<WorkQueue> queues( options.threads );
+	for( size_t i = 0; i < jobs.size(); ++i )
+		queues[i * options.threads / jobs.size()].jobs.push_back( i );
+
+	MemoryGate gate( options.memory_limit );
+	Stats stats;
+	auto start = std::chrono::steady_clock::now();
+
+	std::vector<std::thread> workers;
+	for( unsigned t = 0; t < options.threads; ++t )
+	{
+		workers.emplace_back( [&, t] {
+			size_t job;
+			while( pop_or_steal( queues, t, job, stats ) )
+				convert( jobs[job], options, gate, stats );
+		} );
+	}
+	for( std::thread &worker : workers )
+		worker.join();
+
+	double seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+
+	printf( "%d converted, %d failed in %.3f s on %u threads: %.1f images/s\n",
+			stats.converted.load(), stats.failed.load(), seconds, options.threads,
+			(stats.converted + stats.failed) / seconds );
+	printf( "%.1f MB in, %.1f MB out, peak %.1f MB of pixels in flight (budget %.0f MB), %d jobs stolen\n",
+			stats.bytes_in / 1048576.0, stats.bytes_out / 1048576.0, gate.peak() / 1048576.0,
+			options.memory_limit / 1048576.0, stats.stolen.load() );
+	printf( "%-8s %12s %12s\n", "stage", "thread ms", "ms/image" );
+	for( int s = 0; s < STAGE_COUNT; ++s )
+	{
+		double ms = stats.stage_ns[s] / 1000000.0;
+		printf( "%-8s %12.1f %12.3f\n", stage_names[s], ms, ms / jobs.size() );
+	}
+	return stats.failed > 0 ? 1 : 0;
+}
@@ -106,6 +106,10 @@ typedef unsigned char validate_uint32[sizeof(uint32)==4];
 #include "stbi_DDS_aug.h"
 #endif
 
+#ifndef STBI_NO_QOI
+#include "stbi_QOI_aug.h"
+#endif
+
 //	I (JLD) want full messages for SOIL
 #define STBI_FAILURE_USERMSG 1
 
@@ -114,8 +118,7 @@ typedef unsigned char validate_uint32[sizeof(uint32)==4];
 // Generic API that works on all image types
 //
 
-// this is not threadsafe
-static char *failure_reason;
+static STBI_THREAD_LOCAL char *failure_reason;
 
 char *stbi_failure_reason(void)
 {
@@ -1815,7 +1818,7 @@ static int parse_huffman_block(zbuf *a)
 static int compute_huffman_codes(zbuf *a)
 {
    static uint8 length_dezigzag[19] = { 16,17,18,0,8,7,9,6,10,5,11,4,12,3,13,2,14,1,15 };
-   static zhuffman z_codelength; // static just to save stack space
+   zhuffman z_codelength; // on the stack, a static would be shared by decoding threads
    uint8 lencodes[286+32+137];//padding for maximum single op
    uint8 codelength_sizes[19];
    int i,n;
@@ -1900,18 +1903,23 @@ static int parse_zlib_header(zbuf *a)
    return 1;
 }
 
-// @TODO: should statically initialize these for optimal thread safety
-static uint8 default_length[288], default_distance[32];
-static void init_defaults(void)
+// statically initialized so concurrent decodes never race on them
+static uint8 default_length[288] =
 {
-   int i;   // use <= to match clearly with spec
-   for (i=0; i <= 143; ++i)     default_length[i]   = 8;
-   for (   ; i <= 255; ++i)     default_length[i]   = 9;
-   for (   ; i <= 279; ++i)     default_length[i]   = 7;
-   for (   ; i <= 287; ++i)     default_length[i]   = 8;
-
-   for (i=0; i <=  31; ++i)     default_distance[i] = 5;
-}
+   8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,
+   8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,
+   8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,
+   8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,
+   8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,
+   9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,
+   9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,
+   9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,
+   7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,8,8,8,8,8,8,8,8
+};
+static uint8 default_distance[32] =
+{
+   5,5,5,5,5,5,5,5,5,5,5,5,5,5,5,5,5,5,5,5,5,5,5,5,5,5,5,5,5,5,5,5
+};
 
 static int parse_zlib(zbuf *a, int parse_header)
 {
@@ -1930,7 +1938,6 @@ static int parse_zlib(zbuf *a, int parse_header)
       } else {
          if (type == 1) {
             // use fixed code lengths
-            if (!default_distance[31]) init_defaults();
             if (!zbuild_huffman(&a->z_length  , default_length  , 288)) return 0;
             if (!zbuild_huffman(&a->z_distance, default_distance,  32)) return 0;
          } else {
@@ -2300,6 +2307,7 @@ static int parse_png_file(png *z, int scan, int req_comp)
             else
             #endif
             {
+               if (c.length > (uint32) (s->img_buffer_end - s->img_buffer)) return e("outofdata","Corrupt PNG");
                memcpy(z->idata+ioff, s->img_buffer, c.length);
                s->img_buffer += c.length;
             }
@@ -3680,3 +3688,8 @@ int stbi_write_tga(char const *filename, int x, int y, int comp, void *data)
 #ifndef STBI_NO_DDS
 #include "stbi_DDS_aug_c.h"
 #endif
+
+//	and QOI, which is hooked in through stbi_register_loader
+#ifndef STBI_NO_QOI
+#include "stbi_QOI_aug_c.h"
+#endif
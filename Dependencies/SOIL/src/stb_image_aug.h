@@ -71,7 +71,7 @@
 // Limitations:
 //    - no progressive/interlaced support (jpeg, png)
 //    - 8-bit samples only (jpeg, png)
-//    - not threadsafe
+//    - failure strings are per thread, registering loaders is not threadsafe
 //    - channel subsampling of at most 2 in each dimension (jpeg)
 //    - no delayed line count (jpeg) -- IJG doesn't support either
 //
@@ -160,6 +160,22 @@
 
 #define STBI_VERSION 1
 
+// storage for the failure strings, so threads decoding at the same time
+// each see their own
+#ifndef STBI_THREAD_LOCAL
+   #if defined(__cplusplus) && __cplusplus >= 201103L
+      #define STBI_THREAD_LOCAL thread_local
+   #elif defined(_MSC_VER)
+      #define STBI_THREAD_LOCAL __declspec(thread)
+   #elif defined(__GNUC__)
+      #define STBI_THREAD_LOCAL __thread
+   #elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+      #define STBI_THREAD_LOCAL _Thread_local
+   #else
+      #define STBI_THREAD_LOCAL
+   #endif
+#endif
+
 enum
 {
    STBI_default = 0, // only used for req_comp
@@ -212,8 +228,7 @@ extern void   stbi_ldr_to_hdr_scale(float scale);
 
 #endif // STBI_NO_HDR
 
-// get a VERY brief reason for failure
-// NOT THREADSAFE
+// get a VERY brief reason for failure on this thread
 extern char    *stbi_failure_reason  (void); 
 
 // free the loaded image -- this is just free()
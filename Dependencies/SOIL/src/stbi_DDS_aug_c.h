@@ -313,7 +313,7 @@ static stbi_uc *dds_load(stbi *s, int *x, int *y, int *comp, int req_comp)
 	/*	let the user know what's going on	*/
 	*x = s->img_x;
 	*y = s->img_y;
-	*comp = s->img_n;
+	if( comp ) *comp = s->img_n;
 	/*	is this uncompressed?	*/
 	if( is_compressed )
 	{
@@ -412,7 +412,7 @@ static stbi_uc *dds_load(stbi *s, int *x, int *y, int *comp, int req_comp)
 		{
 			s->img_n = 4;
 		}
-		*comp = s->img_n;
+		if( comp ) *comp = s->img_n;
 		sz = s->img_x*s->img_y*s->img_n*cubemap_faces;
 		dds_data = (unsigned char*)malloc( sz );
 		/*	do this once for each face	*/
@@ -469,7 +469,7 @@ static stbi_uc *dds_load(stbi *s, int *x, int *y, int *comp, int req_comp)
 		if( req_comp != s->img_n )
 		{
 			dds_data = convert_format( dds_data, s->img_n, req_comp, s->img_x, s->img_y );
-			*comp = s->img_n;
+			if( comp ) *comp = s->img_n;
 		}
 	} else
 	{
@@ -477,7 +477,7 @@ static stbi_uc *dds_load(stbi *s, int *x, int *y, int *comp, int req_comp)
 		if( (has_alpha == 0) && (s->img_n == 4) )
 		{
 			dds_data = convert_format( dds_data, 4, 3, s->img_x, s->img_y );
-			*comp = 3;
+			if( comp ) *comp = 3;
 		}
 	}
 	//	OK, done
@@ -0,0 +1,41 @@
+/*
+	adding QOI loading and saving support to stbi
+	(the "Quite OK Image" format, lossless, decodes much faster than PNG)
+*/
+
+#ifndef HEADER_STB_IMAGE_QOI_AUGMENTATION
+#define HEADER_STB_IMAGE_QOI_AUGMENTATION
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//	is it a QOI file?
+extern int      stbi_qoi_test_memory      (stbi_uc const *buffer, int len);
+
+extern stbi_uc *stbi_qoi_load             (char const *filename,     int *x, int *y, int *comp, int req_comp);
+extern stbi_uc *stbi_qoi_load_from_memory (stbi_uc const *buffer, int len, int *x, int *y, int *comp, int req_comp);
+#ifndef STBI_NO_STDIO
+extern int      stbi_qoi_test_file        (FILE *f);
+extern stbi_uc *stbi_qoi_load_from_file   (FILE *f,                  int *x, int *y, int *comp, int req_comp);
+#endif
+
+//	encode tightly packed 'comp' channel data (1 and 2 channels are
+//	expanded to RGB / RGBA), returns a malloc'd buffer and its length
+extern stbi_uc *stbi_qoi_encode           (int x, int y, int comp, void const *data, int *out_len);
+#if !defined(STBI_NO_WRITE) && !defined(STBI_NO_STDIO)
+extern int      stbi_write_qoi            (char const *filename,     int x, int y, int comp, void *data);
+#endif
+
+//	the QOI loader is not built into stbi_load, register it with
+//	stbi_register_loader( &stbi_qoi_loader ) (SOIL does this for you)
+extern stbi_loader stbi_qoi_loader;
+
+#ifdef __cplusplus
+}
+#endif
+
+//
+//
+////   end header file   /////////////////////////////////////////////////////
+#endif // HEADER_STB_IMAGE_QOI_AUGMENTATION
@@ -0,0 +1,316 @@
+
+///	QOI file support, lossless, both decoding and encoding
+///	spec: https://qoiformat.org/qoi-specification.pdf
+
+#define QOI_OP_INDEX	0x00	/* 00xxxxxx */
+#define QOI_OP_DIFF		0x40	/* 01xxxxxx */
+#define QOI_OP_LUMA		0x80	/* 10xxxxxx */
+#define QOI_OP_RUN		0xc0	/* 11xxxxxx */
+#define QOI_OP_RGB		0xfe	/* 11111110 */
+#define QOI_OP_RGBA		0xff	/* 11111111 */
+#define QOI_MASK_2		0xc0	/* 11000000 */
+
+#define QOI_HEADER_SIZE	14
+#define QOI_PADDING_SIZE	8
+//	guard against absurd headers (same limit as the reference decoder)
+#define QOI_PIXELS_MAX	((uint32)400000000)
+
+#define QOI_COLOR_HASH(c)	(((c)[0]*3 + (c)[1]*5 + (c)[2]*7 + (c)[3]*11) & 63)
+
+static const uint8 qoi_padding[QOI_PADDING_SIZE] = {0,0,0,0,0,0,0,1};
+
+static int qoi_test(stbi *s)
+{
+	//	check the magic number
+	if (get8(s) != 'q') return 0;
+	if (get8(s) != 'o') return 0;
+	if (get8(s) != 'i') return 0;
+	if (get8(s) != 'f') return 0;
+	return 1;
+}
+#ifndef STBI_NO_STDIO
+int      stbi_qoi_test_file        (FILE *f)
+{
+   stbi s;
+   int r,n = ftell(f);
+   start_file(&s,f);
+   r = qoi_test(&s);
+   fseek(f,n,SEEK_SET);
+   return r;
+}
+#endif
+
+int      stbi_qoi_test_memory      (stbi_uc const *buffer, int len)
+{
+   stbi s;
+   start_mem(&s,buffer, len);
+   return qoi_test(&s);
+}
+
+//	the decoder walks the chunk stream with a plain pointer instead of
+//	get8(), the per-byte call was most of the cost when reading from a FILE
+static stbi_uc *qoi_load(uint8 const *bytes, int len, int *x, int *y, int *comp, int req_comp)
+{
+	uint32 w, h, px_len, px_pos;
+	int channels, out_n, p, chunks_len, run = 0;
+	uint8 index[64][4];
+	uint8 px[4];
+	uint8 *out, *d;
+
+	if( (bytes == NULL) || (len < QOI_HEADER_SIZE + QOI_PADDING_SIZE) )
+		return epuc("not QOI", "QOI file is truncated");
+	if( (bytes[0] != 'q') || (bytes[1] != 'o') || (bytes[2] != 'i') || (bytes[3] != 'f') )
+		return epuc("not QOI", "Corrupt QOI header");
+	w = ((uint32)bytes[4] << 24) | (bytes[5] << 16) | (bytes[6] << 8) | bytes[7];
+	h = ((uint32)bytes[8] << 24) | (bytes[9] << 16) | (bytes[10] << 8) | bytes[11];
+	channels = bytes[12];
+	if( (w == 0) || (h == 0) || ((channels != 3) && (channels != 4)) || (bytes[13] > 1) )
+		return epuc("bad QOI", "Corrupt QOI header");
+	if( h >= QOI_PIXELS_MAX / w )
+		return epuc("too large", "QOI image is too large");
+
+	*x = (int)w;
+	*y = (int)h;
+	if( comp ) *comp = channels;
+	//	decode straight into the requested layout when we can
+	out_n = ((req_comp == 3) || (req_comp == 4)) ? req_comp : channels;
+	px_len = w * h;
+	out = (uint8*)malloc( px_len * out_n );
+	if( out == NULL )
+		return epuc("outofmem", "Out of memory");
+
+	memset( index, 0, sizeof(index) );
+	px[0] = px[1] = px[2] = 0;
+	px[3] = 255;
+	p = QOI_HEADER_SIZE;
+	chunks_len = len - QOI_PADDING_SIZE;
+	d = out;
+	for( px_pos = 0; px_pos < px_len; ++px_pos, d += out_n )
+	{
+		if( run > 0 )
+		{
+			--run;
+		} else if( p < chunks_len )
+		{
+			int b1 = bytes[p++];
+			if( b1 == QOI_OP_RGB )
+			{
+				px[0] = bytes[p++];
+				px[1] = bytes[p++];
+				px[2] = bytes[p++];
+			} else if( b1 == QOI_OP_RGBA )
+			{
+				px[0] = bytes[p++];
+				px[1] = bytes[p++];
+				px[2] = bytes[p++];
+				px[3] = bytes[p++];
+			} else if( (b1 & QOI_MASK_2) == QOI_OP_INDEX )
+			{
+				memcpy( px, index[b1], 4 );
+			} else if( (b1 & QOI_MASK_2) == QOI_OP_DIFF )
+			{
+				px[0] += ((b1 >> 4) & 0x03) - 2;
+				px[1] += ((b1 >> 2) & 0x03) - 2;
+				px[2] += ( b1       & 0x03) - 2;
+			} else if( (b1 & QOI_MASK_2) == QOI_OP_LUMA )
+			{
+				int b2 = bytes[p++];
+				int vg = (b1 & 0x3f) - 32;
+				px[0] += vg - 8 + ((b2 >> 4) & 0x0f);
+				px[1] += vg;
+				px[2] += vg - 8 +  (b2       & 0x0f);
+			} else if( (b1 & QOI_MASK_2) == QOI_OP_RUN )
+			{
+				run = (b1 & 0x3f);
+			}
+			memcpy( index[QOI_COLOR_HASH(px)], px, 4 );
+		}
+		d[0] = px[0];
+		d[1] = px[1];
+		d[2] = px[2];
+		if( out_n == 4 ) d[3] = px[3];
+	}
+
+	//	the rest (grey / grey-alpha) goes through the generic converter
+	if( (req_comp >= 1) && (req_comp <= 4) && (req_comp != out_n) )
+		out = convert_format( out, out_n, req_comp, w, h );
+	return out;
+}
+
+#ifndef STBI_NO_STDIO
+stbi_uc *stbi_qoi_load_from_file   (FILE *f,                  int *x, int *y, int *comp, int req_comp)
+{
+	//	slurp the rest of the file, then decode from memory
+	stbi_uc *buffer, *data;
+	long start = ftell(f), len;
+	fseek(f, 0, SEEK_END);
+	len = ftell(f) - start;
+	fseek(f, start, SEEK_SET);
+	if( len <= 0 )
+		return epuc("not QOI", "QOI file is truncated");
+	buffer = (stbi_uc*)malloc( len );
+	if( buffer == NULL )
+		return epuc("outofmem", "Out of memory");
+	if( fread(buffer, 1, len, f) != (size_t)len )
+	{
+		free( buffer );
+		return epuc("not QOI", "QOI file is truncated");
+	}
+	data = qoi_load( buffer, (int)len, x, y, comp, req_comp );
+	free( buffer );
+	return data;
+}
+
+stbi_uc *stbi_qoi_load             (char const *filename,     int *x, int *y, int *comp, int req_comp)
+{
+   stbi_uc *data;
+   FILE *f = fopen(filename, "rb");
+   if (!f) return NULL;
+   data = stbi_qoi_load_from_file(f,x,y,comp,req_comp);
+   fclose(f);
+   return data;
+}
+#endif
+
+stbi_uc *stbi_qoi_load_from_memory (stbi_uc const *buffer, int len, int *x, int *y, int *comp, int req_comp)
+{
+   return qoi_load(buffer,len,x,y,comp,req_comp);
+}
+
+stbi_uc *stbi_qoi_encode           (int x, int y, int comp, void const *data, int *out_len)
+{
+	uint8 index[64][4];
+	uint8 px[4], px_prev[4];
+	uint8 const *src = (uint8 const *)data;
+	uint8 *bytes, *o;
+	int channels, i, px_len, run = 0;
+	size_t max_size;
+
+	if( (x < 1) || (y < 1) || (comp < 1) || (comp > 4) || (data == NULL) || (out_len == NULL) )
+		return NULL;
+	if( (uint32)y >= QOI_PIXELS_MAX / (uint32)x )
+		return epuc("too large", "QOI image is too large");
+	//	grey is stored as RGB, grey-alpha as RGBA
+	channels = (comp == 2 || comp == 4) ? 4 : 3;
+	px_len = x * y;
+	max_size = (size_t)px_len * (channels + 1) + QOI_HEADER_SIZE + QOI_PADDING_SIZE;
+	bytes = (uint8*)malloc( max_size );
+	if( bytes == NULL )
+		return epuc("outofmem", "Out of memory");
+
+	o = bytes;
+	*o++ = 'q'; *o++ = 'o'; *o++ = 'i'; *o++ = 'f';
+	*o++ = (uint8)(x >> 24); *o++ = (uint8)(x >> 16); *o++ = (uint8)(x >> 8); *o++ = (uint8)x;
+	*o++ = (uint8)(y >> 24); *o++ = (uint8)(y >> 16); *o++ = (uint8)(y >> 8); *o++ = (uint8)y;
+	*o++ = (uint8)channels;
+	*o++ = 0;	/* sRGB with linear alpha */
+
+	memset( index, 0, sizeof(index) );
+	px_prev[0] = px_prev[1] = px_prev[2] = 0;
+	px_prev[3] = 255;
+	for( i = 0; i < px_len; ++i, src += comp )
+	{
+		if( comp < 3 )
+		{
+			px[0] = px[1] = px[2] = src[0];
+			px[3] = (comp == 2) ? src[1] : 255;
+		} else
+		{
+			px[0] = src[0];
+			px[1] = src[1];
+			px[2] = src[2];
+			px[3] = (comp == 4) ? src[3] : 255;
+		}
+
+		if( memcmp( px, px_prev, 4 ) == 0 )
+		{
+			++run;
+			if( (run == 62) || (i == px_len - 1) )
+			{
+				*o++ = (uint8)(QOI_OP_RUN | (run - 1));
+				run = 0;
+			}
+			continue;
+		}
+		if( run > 0 )
+		{
+			*o++ = (uint8)(QOI_OP_RUN | (run - 1));
+			run = 0;
+		}
+
+		{
+			int index_pos = QOI_COLOR_HASH(px);
+			if( memcmp( index[index_pos], px, 4 ) == 0 )
+			{
+				*o++ = (uint8)(QOI_OP_INDEX | index_pos);
+			} else
+			{
+				memcpy( index[index_pos], px, 4 );
+				if( px[3] == px_prev[3] )
+				{
+					signed char vr = (signed char)(px[0] - px_prev[0]);
+					signed char vg = (signed char)(px[1] - px_prev[1]);
+					signed char vb = (signed char)(px[2] - px_prev[2]);
+					signed char vg_r = (signed char)(vr - vg);
+					signed char vg_b = (signed char)(vb - vg);
+					if( (vr > -3) && (vr < 2) && (vg > -3) && (vg < 2) && (vb > -3) && (vb < 2) )
+					{
+						*o++ = (uint8)(QOI_OP_DIFF | ((vr + 2) << 4) | ((vg + 2) << 2) | (vb + 2));
+					} else if( (vg_r > -9) && (vg_r < 8) && (vg > -33) && (vg < 32) && (vg_b > -9) && (vg_b < 8) )
+					{
+						*o++ = (uint8)(QOI_OP_LUMA | (vg + 32));
+						*o++ = (uint8)(((vg_r + 8) << 4) | (vg_b + 8));
+					} else
+					{
+						*o++ = QOI_OP_RGB;
+						*o++ = px[0];
+						*o++ = px[1];
+						*o++ = px[2];
+					}
+				} else
+				{
+					*o++ = QOI_OP_RGBA;
+					*o++ = px[0];
+					*o++ = px[1];
+					*o++ = px[2];
+					*o++ = px[3];
+				}
+			}
+		}
+		memcpy( px_prev, px, 4 );
+	}
+	memcpy( o, qoi_padding, QOI_PADDING_SIZE );
+	o += QOI_PADDING_SIZE;
+
+	*out_len = (int)(o - bytes);
+	return bytes;
+}
+
+#if !defined(STBI_NO_WRITE) && !defined(STBI_NO_STDIO)
+int stbi_write_qoi(char const *filename, int x, int y, int comp, void *data)
+{
+	int len, ok = 0;
+	FILE *f;
+	stbi_uc *bytes = stbi_qoi_encode( x, y, comp, data, &len );
+	if( bytes == NULL )
+		return 0;
+	f = fopen(filename, "wb");
+	if( f )
+	{
+		ok = (fwrite( bytes, 1, len, f ) == (size_t)len);
+		fclose( f );
+	}
+	free( bytes );
+	return ok;
+}
+#endif
+
+stbi_loader stbi_qoi_loader =
+{
+	stbi_qoi_test_memory,
+	stbi_qoi_load_from_memory,
+	#ifndef STBI_NO_STDIO
+	stbi_qoi_test_file,
+	stbi_qoi_load_from_file,
+	#endif
+};
@@ -0,0 +1,267 @@
+#include "JobSystem.h"
+
+#include "../Scene/FrustumCulling.h"
+#include "../Scene/Transforms.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <thread>
+
+namespace {
+
+    using JobSystem::Counter;
+    using JobSystem::Job;
+
+    struct Entry {
+        Job job;
+        Counter* counter = nullptr;
+    };
+
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Entry> jobs;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+    std::atomic<bool> running{ false };
+    std::atomic<int> queued{ 0 };
+    std::atomic<unsigned> nextQueue{ 0 };
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    thread_local int workerIndex = -1;
+
+    // joins the workers if main returns early, before the globals above go away
+    struct Shutdown {
+        ~Shutdown() { JobSystem::stop(); }
+    } shutdown;
+
+    void push(Entry entry) {
+        // threads outside the pool spread their jobs round robin
+        const size_t index = workerIndex >= 0 ? size_t(workerIndex) : nextQueue++ % queues.size();
+        {
+            std::lock_guard<std::mutex> lock(queues[index]->mutex);
+            queues[index]->jobs.push_back(std::move(entry));
+        }
+        queued++;
+        { std::lock_guard<std::mutex> lock(sleepMutex); }
+        wake.notify_one();
+    }
+
+    bool tryGet(int self, Entry& entry) {
+        const int count = int(queues.size());
+        if (self >= 0) {
+            Queue& own = *queues[self];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.jobs.empty()) {
+                entry = std::move(own.jobs.back());
+                own.jobs.pop_back();
+                queued--;
+                return true;
+            }
+        }
+        for (int k = 1; k <= count; ++k) {
+            const int victim = (self + k + count) % count;
+            if (victim == self)
+                continue;
+            Queue& other = *queues[victim];
+            std::lock_guard<std::mutex> lock(other.mutex);
+            if (!other.jobs.empty()) {
+                entry = std::move(other.jobs.front());
+                other.jobs.pop_front();
+                queued--;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void finish(Counter* counter) {
+        // under the lock so a waiter can't return and destroy the counter mid-update
+        std::vector<std::pair<Job, Counter*>> ready;
+        {
+            std::lock_guard<std::mutex> lock(counter->mutex);
+            if (--counter->pending == 0)
+                ready.swap(counter->continuations);
+        }
+        for (auto& [job, next] : ready)
+            push({ std::move(job), next });
+    }
+
+    void execute(Entry& entry) {
+        entry.job();
+        if (entry.counter)
+            finish(entry.counter);
+    }
+
+    void workerLoop(int index) {
+        workerIndex = index;
+        while (running) {
+            Entry entry;
+            if (tryGet(index, entry)) {
+                execute(entry);
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            wake.wait_for(lock, std::chrono::milliseconds(1), []() { return queued > 0 || !running; });
+        }
+    }
+
+    // Repeats until the timing is long enough to mean something, returns ms per run
+    template<typename Work>
+    double timeRuns(Work work) {
+        int runs = 0;
+        double ms = 0.0;
+        auto start = std::chrono::high_resolution_clock::now();
+        while (runs < 3 || ms < 200.0) {
+            work();
+            runs++;
+            ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        }
+        return ms / runs;
+    }
+}
+
+void JobSystem::start(int threads) {
+    if (running)
+        stop();
+    const int count = threads > 0 ? threads : int(std::max(1u, std::thread::hardware_concurrency()));
+    for (int i = 0; i < count; ++i)
+        queues.push_back(std::make_unique<Queue>());
+    workerIndex = 0;
+    running = true;
+    for (int i = 1; i < count; ++i)
+        workers.emplace_back(workerLoop, i);
+}
+
+void JobSystem::stop() {
+    if (!running)
+        return;
+    running = false;
+    { std::lock_guard<std::mutex> lock(sleepMutex); }
+    wake.notify_all();
+    for (std::thread& worker : workers)
+        worker.join();
+    workers.clear();
+    queues.clear();
+    queued = 0;
+    workerIndex = -1;
+}
+
+int JobSystem::threadCount() {
+    return queues.empty() ? 1 : int(queues.size());
+}
+
+void JobSystem::run(Job job, Counter* counter) {
+    if (counter)
+        counter->pending++;
+    if (queues.empty()) {
+        Entry entry{ std::move(job), counter };
+        execute(entry);
+        return;
+    }
+    push({ std::move(job), counter });
+}
+
+void JobSystem::runAfter(Counter& dependency, Job job, Counter* counter) {
+    if (counter)
+        counter->pending++;
+    {
+        std::lock_guard<std::mutex> lock(dependency.mutex);
+        if (dependency.pending > 0) {
+            dependency.continuations.emplace_back(std::move(job), counter);
+            return;
+        }
+    }
+    Entry entry{ std::move(job), counter };
+    if (queues.empty())
+        execute(entry);
+    else
+        push(std::move(entry));
+}
+
+void JobSystem::wait(Counter& counter) {
+    while (counter.pending > 0) {
+        Entry entry;
+        if (!queues.empty() && tryGet(workerIndex, entry))
+            execute(entry);
+        else
+            std::this_thread::yield();
+    }
+    // the last finish() may still hold the lock
+    std::lock_guard<std::mutex> lock(counter.mutex);
+}
+
+void JobSystem::parallelFor(size_t count, size_t grain, const std::function<void(size_t begin, size_t end)>& body) {
+    grain = std::max<size_t>(grain, 1);
+    if (count <= grain || queues.empty()) {
+        if (count > 0)
+            body(0, count);
+        return;
+    }
+
+    // a few pieces per thread so stealing can even out uneven pieces
+    const size_t pieces = std::min((count + grain - 1) / grain, size_t(threadCount()) * 4);
+    const size_t size = (count + pieces - 1) / pieces;
+
+    Counter counter;
+    for (size_t begin = size; begin < count; begin += size) {
+        const size_t end = std::min(begin + size, count);
+        run([&body, begin, end]() { body(begin, end); }, &counter);
+    }
+    body(0, std::min(size, count));
+    wait(counter);
+}
+
+void JobSystem::benchmark() {
+    const int maxThreads = int(std::max(1u, std::thread::hardware_concurrency()));
+    std::cout << "Job system scaling, ms per run (" << maxThreads << " hardware threads)" << std::endl;
+
+    // 1024 roots with 255 children each, all moved every run
+    Transforms::Hierarchy hierarchy;
+    std::vector<uint32_t> roots;
+    for (int r = 0; r < 1024; ++r) {
+        roots.push_back(Transforms::add(hierarchy));
+        for (int c = 0; c < 255; ++c)
+            Transforms::setPosition(hierarchy, Transforms::add(hierarchy, roots.back()), glm::vec3(float(c), 0.0f, 0.0f));
+    }
+
+    const glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+    const glm::mat4 proj = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+    const FrustumCulling::Frustum frustum = FrustumCulling::extract(proj * view);
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+    FrustumCulling::Bounds bounds;
+    for (int i = 0; i < 1000000; ++i)
+        FrustumCulling::add(bounds, glm::vec3(position(random), position(random), position(random)), glm::vec3(0.5f));
+    std::vector<uint32_t> visible;
+
+    double transformBase = 0.0, cullingBase = 0.0;
+    for (int threads = 1; threads <= maxThreads; ++threads) {
+        start(threads);
+        const double transformMs = timeRuns([&]() {
+            for (size_t r = 0; r < roots.size(); ++r)
+                Transforms::setPosition(hierarchy, roots[r], glm::vec3(0.0f, float(r), 0.0f));
+            Transforms::update(hierarchy);
+        });
+        const double cullingMs = timeRuns([&]() {
+            FrustumCulling::cull(frustum, bounds, visible);
+        });
+        stop();
+
+        if (threads == 1) {
+            transformBase = transformMs;
+            cullingBase = cullingMs;
+        }
+        std::cout << "  " << threads << (threads == 1 ? " thread: " : " threads: ")
+                  << Transforms::size(hierarchy) << " transforms " << transformMs << " (x" << transformBase / transformMs << "), "
+                  << bounds.size() << " boxes culled " << cullingMs << " (x" << cullingBase / cullingMs << ")" << std::endl;
+    }
+}
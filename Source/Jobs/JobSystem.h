@@ -0,0 +1,47 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+// Worker threads for per-frame CPU work. Every worker owns a deque: it pushes
+// and pops its own jobs at the back, newest first while they're still in
+// cache, and when it runs dry it steals the oldest job from the front of
+// another worker's deque. The thread that calls start() is worker 0 and
+// helps out whenever it waits. Without start() everything runs inline.
+namespace JobSystem {
+
+    using Job = std::function<void()>;
+
+    // Counts unfinished jobs. Jobs queued with runAfter() start once it reaches zero.
+    struct Counter {
+        std::atomic<int> pending{ 0 };
+        std::mutex mutex;
+        std::vector<std::pair<Job, Counter*>> continuations;
+    };
+
+    // threads includes the calling thread, 0 uses every hardware thread
+    void start(int threads = 0);
+    void stop();
+
+    // Workers plus the thread that started them, 1 when not started
+    int threadCount();
+
+    // counter, when given, is incremented now and decremented when the job is done
+    void run(Job job, Counter* counter = nullptr);
+
+    // Queues the job once dependency has no pending jobs left
+    void runAfter(Counter& dependency, Job job, Counter* counter = nullptr);
+
+    // Runs other jobs until the counter reaches zero
+    void wait(Counter& counter);
+
+    // Calls body(begin, end) over [0, count) in pieces of at least grain and
+    // returns when all are done. The caller runs pieces too.
+    void parallelFor(size_t count, size_t grain, const std::function<void(size_t begin, size_t end)>& body);
+
+    // Transform and culling throughput with 1 to N threads
+    void benchmark();
+}
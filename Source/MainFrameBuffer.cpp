@@ -9,77 +9,52 @@
 
 #include <iostream>
 #include <chrono>
-
+#include <cmath>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <numeric>
+#include <string_view>
+#include <thread>
+
+#include "Shader/ShaderProgram.h"
+#include "Shader/UniformBlocks.h"
+#include "Jobs/JobSystem.h"
+#include "Render/CommandList.h"
+#include "Render/DrawBatch.h"
+#include "Render/DynamicResolution.h"
+#include "Render/FramePacer.h"
+#include "Render/FrameQueue.h"
+#include "Render/GLState.h"
+#include "Render/GpuCulling.h"
+#include "Render/OcclusionQuery.h"
+#include "Render/RenderGraph.h"
+#include "Render/SoftRaster.h"
+#include "Render/StreamBuffer.h"
+#include "Render/UniformRing.h"
 #include "Shader/VertexShaderStrings.h"
+#include "Scene/Bvh.h"
+#include "Scene/CubeField.h"
+#include "Scene/FixedTimestep.h"
+#include "Scene/FrustumCulling.h"
+#include "Scene/OcclusionCulling.h"
+#include "Scene/PlanarReflection.h"
+#include "Scene/Skybox.h"
+#include "Scene/Transforms.h"
+#include "Texture/Cubemap.h"
+#include "Texture/Ktx2.h"
+#include "Texture/Sampler.h"
+#include "Texture/TextureImport.h"
 #include "vertices.h"
 
-enum ShaderLogType {
-    COMPILE,
-    LINK
-};
-
-
-GLuint loadTexture(const GLchar* path) {
-    GLuint textureID;
-    glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_2D, textureID);
-
-    int width, height;
-    unsigned char* image = SOIL_load_image(path, &width, &height, 0, SOIL_LOAD_RGBA);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image);
-    SOIL_free_image_data(image);
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	
-    glBindTexture(GL_TEXTURE_2D, 0);
-
-	return textureID;
-}
-
-GLuint shaderLogCheck(GLuint shader, ShaderLogType type) {
-	GLint success = GL_TRUE;
-	GLchar infoLog[512];
-	
-    if(type == COMPILE) {
-		glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
-		if(!success) {
-			glGetShaderInfoLog(shader, 512, NULL, infoLog);
-			std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
-			return 0;
-		}
-	} else if(type == LINK) {
-		glGetProgramiv(shader, GL_LINK_STATUS, &success);
-		if(!success) {
-			glGetProgramInfoLog(shader, 512, NULL, infoLog);
-			std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
-			return 0;
-		}
-	}
-
-	return success;
-}
-
-int createShaderProgram(const GLchar* vertexSource, const GLchar* fragmentSource, GLuint& vertexShader, GLuint& fragmentShader, GLuint& shaderProgram) {
-    vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertexShader, 1, &vertexSource, NULL);
-    glCompileShader(vertexShader);
-    shaderLogCheck(vertexShader, COMPILE);
+GLuint loadTexture(const GLchar* path, TextureImport::Budget& budget) {
+    // cooked KTX2 files already hold the GPU format and mip chain
+    if (std::string_view(path).ends_with(".ktx2"))
+        return TextureImport::importKtx2(path, budget);
 
-    fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragmentShader, 1, &fragmentSource, NULL);
-    glCompileShader(fragmentShader);
-    shaderLogCheck(fragmentShader, COMPILE);
-
-    shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
-    shaderLogCheck(shaderProgram, LINK);
-
-    return 1;
+    // everything else gets the smallest format its pixels allow
+    return TextureImport::importTexture(path, budget);
 }
 
 void setSceneVertexAttributes(GLuint shaderProgram) {
@@ -106,35 +81,61 @@ void setScreenVertexAttributes(GLuint shaderProgram) {
     glVertexAttribPointer(texAttrib, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), (void*)(2 * sizeof(GLfloat)));
 }
 
-int main() {
-	auto start = std::chrono::high_resolution_clock::now();
-    GLFWwindow* window;
+// Everything the simulation steps. Rendering blends the last two.
+struct SimulationState {
+    double time = 0.0;
+    float cubeAngle = 0.0f;
+};
 
-    if(!glfwInit())
-        return -1;
+void simulate(SimulationState& state, double step) {
+    state.time += step;
+    state.cubeAngle += float(step) * glm::radians(180.0f);
+}
 
-    window = glfwCreateWindow(1280, 960, "Render", NULL, NULL);
-    if(!window) {
-		glfwTerminate();
-		return -2;
-	}
+// One mirror view and what was culled into it
+struct ReflectionSnapshot {
+    PlanarReflection::View view;
+    std::vector<DrawBatch::Instance> instances;
+};
 
+// Everything the render thread needs for one frame. Written by the main
+// thread, read-only once published.
+struct FrameSnapshot {
+    int width = 0, height = 0;
+    glm::mat4 view, proj;
+    float time = 0.0f;
+    glm::mat4 cubeWorld;
+    std::vector<DrawBatch::Instance> field;
+    std::vector<glm::mat4> mirrors;                 // each mirror is the floor mesh placed by its model
+    std::vector<ReflectionSnapshot> reflections;    // parents before children
+};
+
+// Command line choices the render thread acts on
+struct RenderOptions {
+    bool software = false;          // draw the scene with SoftRaster instead of GL
+    bool fixedResolution = false;   // keep the scene at window size
+    bool gpuCulling = false;        // the field arrives unculled, compute shaders cull it
+    bool timeScene = false;         // glFinish around the GL scene passes to time them on the CPU clock
+};
+
+// Owns the GL context: creates every GL object, draws the snapshots the
+// main thread publishes and deletes everything when the queue closes
+
+void renderThread(GLFWwindow* window, FrameQueue::Queue& frameQueue, FrameSnapshot* snapshots, FramePacer::Pacer& pacer, RenderOptions options) {
     glfwMakeContextCurrent(window);
 
-    if (glewInit() != GLEW_OK)
-        return -3;
+    if (glewInit() != GLEW_OK) {
+        std::cout << "ERROR::RENDER::GLEW_INIT_FAILED" << std::endl;
+        FrameQueue::close(frameQueue);
+        return;
+    }
 
-    GLuint vaoCube, vaoQuad;
-    glGenVertexArrays(1, &vaoCube);
+    GLuint vaoQuad;
     glGenVertexArrays(1, &vaoQuad);
 
-    GLuint vboCube, vboQuad;
-    glGenBuffers(1, &vboCube);
+    GLuint vboQuad;
     glGenBuffers(1, &vboQuad);
 
-    glBindBuffer(GL_ARRAY_BUFFER, vboCube);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(Vertices::cubeVertices), Vertices::cubeVertices, GL_STATIC_DRAW);
-    
     glBindBuffer(GL_ARRAY_BUFFER, vboQuad);
     glBufferData(GL_ARRAY_BUFFER, sizeof(Vertices::quadVertices), Vertices::quadVertices, GL_STATIC_DRAW);
 
@@ -146,95 +147,731 @@ int main() {
     GLuint screenVertexShader, screenFragmentShader, screenShaderProgram;
     createShaderProgram(shaderSources->screenVertexSource, shaderSources->screenFragmentSource, screenVertexShader, screenFragmentShader, screenShaderProgram);
 
-    glBindVertexArray(vaoCube);
-    glBindBuffer(GL_ARRAY_BUFFER, vboCube);
+    // per-frame geometry and draw data, three frames in flight
+    StreamBuffer::Buffer drawStream;
+    StreamBuffer::create(drawStream, 1024 * 1024);
+
+    // cube and floor share one vertex/index buffer, the scene is drawn in batches
+    DrawBatch::Geometry sceneGeometry;
+    int cubeMesh = DrawBatch::addMesh(sceneGeometry, Vertices::cubeVertices, 36, 8);
+    int floorMesh = DrawBatch::addMesh(sceneGeometry, Vertices::cubeVertices + 36 * 8, 6, 8);
+    DrawBatch::upload(sceneGeometry);
     setSceneVertexAttributes(sceneShaderProgram);
+    DrawBatch::setInstanceAttributes(sceneShaderProgram, drawStream.buffer);
+
+    DrawBatch::Batch opaqueBatch, mirrorBatch, reflectionBatch;
 
     glBindVertexArray(vaoQuad);
     glBindBuffer(GL_ARRAY_BUFFER, vboQuad);
     setScreenVertexAttributes(screenShaderProgram);
 
-    GLuint texKitten = loadTexture("Resource/kitten.png");
-    GLuint texPuppy = loadTexture("Resource/doggo.png");
+    TextureImport::Budget textureBudget;
+    GLuint texKitten = loadTexture("Resource/kitten.png", textureBudget);
+    GLuint texPuppy = loadTexture("Resource/doggo.png", textureBudget);
+    TextureImport::printReport(textureBudget);
 
     glUseProgram(sceneShaderProgram);
     glUniform1i(glGetUniformLocation(sceneShaderProgram, "texKitten"), 0);
     glUniform1i(glGetUniformLocation(sceneShaderProgram, "texPuppy"), 1);
-
+    glUniform1i(glGetUniformLocation(sceneShaderProgram, "reflection"), 2);
+    glUniform1f(glGetUniformLocation(sceneShaderProgram, "mirrorTint"), 0.3f);
+    GLint uniMirrorPixel = glGetUniformLocation(sceneShaderProgram, "mirrorPixel");
 
     glUseProgram(screenShaderProgram);
     glUniform1i(glGetUniformLocation(screenShaderProgram, "texFramebuffer"), 0);
+    GLint uniSourceSize = glGetUniformLocation(screenShaderProgram, "sourceSize");
+    GLint uniSharpness = glGetUniformLocation(screenShaderProgram, "sharpness");
+
+    // offscreen targets come from the render graph's pool each frame
+    RenderGraph::ResourcePool renderTargets;
+    bool printedGraphStats = false;
+
+    // scene resolution follows the GPU frame time
+    DynamicResolution::Controller resolution;
+    if (options.fixedResolution)
+        resolution.settings.minScale = resolution.settings.maxScale;
+    DynamicResolution::GpuTimer gpuTimer;
+    DynamicResolution::create(gpuTimer);
+
+    // per-frame and per-draw uniform blocks, streamed through one ring
+    UniformBlocks::Frame frameUniforms;
+
+    UniformRing::Ring uniformRing;
+    UniformRing::create(uniformRing, 64 * 1024);
+
+    Skybox::Pass skybox;
+    if (!Skybox::create(skybox, Cubemap::loadStrip("Resource/skybox.dds", SOIL_DDS_CUBEMAP_FACE_ORDER)))
+        std::cout << "ERROR::SKYBOX::NO_CUBEMAP" << std::endl;
+
+    // the field's culling on the GPU, against last frame's depth
+    GpuCulling::Culler gpuCuller;
+    const bool gpuCulling = options.gpuCulling && !options.software && GpuCulling::create(gpuCuller, *shaderSources);
+    GLuint fieldFirstInstance = 0, fieldCount = 0;
+
+    // reflections are only drawn while some mirror is
+    OcclusionQuery::Query mirrorQuery;
+    OcclusionQuery::create(mirrorQuery);
+
+    // everything above bound state directly
+    GLState::invalidate();
+
+    // CPU rasterizer with its own copies of the scene's meshes and textures
+    SoftRaster::Renderer softRenderer;
+    SoftRaster::Framebuffer softFramebuffer;
+    SoftRaster::Mesh softCube, softFloor;
+    std::vector<DrawBatch::Instance> softReflection;
+    Sampler::Image softKitten, softPuppy;
+    double softSetupMs = 0.0, softRasterMs = 0.0;
+    long long softFrames = 0;
+    bool software = options.software;
+    if (software) {
+        SoftRaster::addMesh(softCube, Vertices::cubeVertices, 36, 8);
+        SoftRaster::addMesh(softFloor, Vertices::cubeVertices + 36 * 8, 6, 8);
+        software = SoftRaster::loadTexture(softKitten, "Resource/kitten.png") && SoftRaster::loadTexture(softPuppy, "Resource/doggo.png");
+    }
 
-    GLint uniModel = glGetUniformLocation(sceneShaderProgram, "model");
+    std::vector<CommandList::List> fieldLists;
+    const size_t fieldChunkSize = 512;
+    double recordMs = 0.0, replayMs = 0.0;
+    // scene through skybox, comparable with SoftRaster's setup plus tiles
+    double glSceneMs = 0.0;
+    long long glSceneFrames = 0;
+    std::chrono::high_resolution_clock::time_point glSceneStart;
+    long long recordedFrames = 0;
+
+    FramePacer::begin(pacer);
+
+    for (;;) {
+        const int slot = FrameQueue::beginRead(frameQueue);
+        if (slot < 0)
+            break;
+        const FrameSnapshot& frame = snapshots[slot];
+        const int width = frame.width, height = frame.height;
+
+        int sceneWidth, sceneHeight;
+        DynamicResolution::scaledSize(resolution, width, height, sceneWidth, sceneHeight);
+
+        UniformRing::beginFrame(uniformRing);
+        StreamBuffer::beginFrame(drawStream);
+        frameUniforms.view = frame.view;
+        frameUniforms.proj = frame.proj;
+        frameUniforms.time = frame.time;
+        UniformRing::push(uniformRing, UniformBlocks::FrameBinding, &frameUniforms, sizeof(frameUniforms));
+
+        if (gpuCulling) {
+            // every row goes up, the compute pass decides what gets drawn
+            StreamBuffer::Allocation fieldInstances = StreamBuffer::allocate(drawStream, frame.field.size() * sizeof(DrawBatch::Instance), sizeof(DrawBatch::Instance));
+            fieldFirstInstance = GLuint(fieldInstances.offset / sizeof(DrawBatch::Instance));
+            fieldCount = fieldInstances.data ? GLuint(frame.field.size()) : 0;
+            JobSystem::parallelFor(fieldCount, 1024, [&](size_t begin, size_t end) {
+                memcpy(fieldInstances.data + begin * sizeof(DrawBatch::Instance), frame.field.data() + begin, (end - begin) * sizeof(DrawBatch::Instance));
+            });
+        } else if (!software) {
+            // the field is recorded on the job threads, a command list per chunk,
+            // and replayed in the scene pass
+            auto recordStart = std::chrono::high_resolution_clock::now();
+            const size_t fieldChunks = (frame.field.size() + fieldChunkSize - 1) / fieldChunkSize;
+            StreamBuffer::Allocation fieldInstances = StreamBuffer::allocate(drawStream, frame.field.size() * sizeof(DrawBatch::Instance), sizeof(DrawBatch::Instance));
+            fieldLists.resize(fieldInstances.data ? fieldChunks : 0);
+            JobSystem::parallelFor(fieldLists.size(), 1, [&](size_t first, size_t last) {
+                DrawBatch::Instance* rows = reinterpret_cast<DrawBatch::Instance*>(fieldInstances.data);
+                const GLuint firstInstance = GLuint(fieldInstances.offset / sizeof(DrawBatch::Instance));
+                const DrawBatch::Mesh& cube = sceneGeometry.meshes[cubeMesh];
+                for (size_t chunk = first; chunk < last; ++chunk) {
+                    const size_t begin = chunk * fieldChunkSize;
+                    const size_t end = std::min(begin + fieldChunkSize, frame.field.size());
+                    memcpy(rows + begin, frame.field.data() + begin, (end - begin) * sizeof(DrawBatch::Instance));
+
+                    CommandList::List& list = fieldLists[chunk];
+                    CommandList::reset(list);
+                    CommandList::useProgram(list, sceneShaderProgram);
+                    CommandList::bindVertexArray(list, sceneGeometry.vao);
+                    CommandList::bindTexture(list, 0, GL_TEXTURE_2D, texKitten);
+                    CommandList::bindTexture(list, 1, GL_TEXTURE_2D, texPuppy);
+                    CommandList::drawElements(list, cube.indexCount, GLuint(end - begin), cube.firstIndex, cube.baseVertex, firstInstance + GLuint(begin));
+                }
+            });
+            recordMs += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - recordStart).count();
+        }
 
-    GLuint framebuffer;
-    glGenFramebuffers(1, &framebuffer);
-    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        RenderGraph::Graph graph(renderTargets);
+        RenderGraph::Handle backbuffer = graph.importBackbuffer("backbuffer", width, height);
+        RenderGraph::Handle sceneColor, sceneDepth;
+        std::vector<RenderGraph::Handle> reflectionColor(frame.reflections.size(), RenderGraph::InvalidHandle);
+
+        // the surfaces of the mirrors seen from view parent (-1 for the
+        // camera), each showing its reflection at its own pixels
+        auto drawMirrors = [&](int parent, const RenderGraph::PassResources& resources, int targetWidth, int targetHeight) {
+            for (size_t r = 0; r < frame.reflections.size(); ++r) {
+                if (frame.reflections[r].view.parent != parent)
+                    continue;
+                GLState::bindTexture(2, GL_TEXTURE_2D, resources.texture(reflectionColor[r]));
+                glUniform2f(uniMirrorPixel, 1.0f / targetWidth, 1.0f / targetHeight);
+                DrawBatch::add(mirrorBatch, sceneGeometry, floorMesh, { frame.mirrors[frame.reflections[r].view.mirror], glm::vec4(1.0f) });
+                DrawBatch::submit(mirrorBatch, sceneGeometry, drawStream);
+            }
+            glUniform2f(uniMirrorPixel, 0.0f, 0.0f);
+        };
+
+        if (software) {
+            // same scene drawn on the CPU, then uploaded in place of the GL scene pass
+            graph.addPass("softwareScene",
+                [&](RenderGraph::PassBuilder& builder) {
+                    sceneColor = builder.create("sceneColor", { sceneWidth, sceneHeight, GL_RGBA8, false });
+                },
+                [&](const RenderGraph::PassResources& resources) {
+                    SoftRaster::resize(softFramebuffer, sceneWidth, sceneHeight);
+                    SoftRaster::clear(softFramebuffer, glm::vec4(1.0f));
+                    SoftRaster::begin(softRenderer, softFramebuffer, frame.proj * frame.view, softKitten, softPuppy);
+
+                    const DrawBatch::Instance cube = { frame.cubeWorld, glm::vec4(1.0f) };
+                    SoftRaster::draw(softRenderer, softCube, &cube, 1, SoftRaster::State());
+                    SoftRaster::draw(softRenderer, softCube, frame.field.data(), frame.field.size(), SoftRaster::State());
+
+                    // the first level of mirrors only: each surface writes its
+                    // stencil mask, not depth, and the scene is drawn mirrored
+                    // under the main camera where the mask is
+                    for (const ReflectionSnapshot& reflection : frame.reflections) {
+                        if (reflection.view.parent >= 0)
+                            continue;
+                        SoftRaster::State surfaceState;
+                        surfaceState.depthWrite = false;
+                        surfaceState.stencilTest = true;
+                        surfaceState.stencilRef = uint8_t(reflection.view.mirror + 1);
+                        surfaceState.stencilPass = SoftRaster::StencilOp::Replace;
+                        const DrawBatch::Instance surface = { frame.mirrors[reflection.view.mirror], glm::vec4(1.0f) };
+                        SoftRaster::draw(softRenderer, softFloor, &surface, 1, surfaceState);
+
+                        SoftRaster::State reflectionState;
+                        reflectionState.stencilTest = true;
+                        reflectionState.stencilFunc = SoftRaster::StencilFunc::Equal;
+                        reflectionState.stencilRef = surfaceState.stencilRef;
+                        reflectionState.stencilWriteMask = 0x00;
+                        softReflection.resize(reflection.instances.size());
+                        for (size_t i = 0; i < reflection.instances.size(); ++i)
+                            softReflection[i] = { reflection.view.reflection * reflection.instances[i].model, reflection.instances[i].color * glm::vec4(0.3f, 0.3f, 0.3f, 1.0f) };
+                        SoftRaster::draw(softRenderer, softCube, softReflection.data(), softReflection.size(), reflectionState);
+                    }
+
+                    SoftRaster::finish(softRenderer);
+                    softSetupMs += softRenderer.stats.setupMs;
+                    softRasterMs += softRenderer.stats.rasterMs;
+                    softFrames++;
+
+                    GLState::bindTexture(0, GL_TEXTURE_2D, resources.texture(sceneColor));
+                    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, sceneWidth, sceneHeight, GL_RGBA, GL_UNSIGNED_BYTE, softFramebuffer.color.data());
+                });
+        } else {
+            graph.addPass("scene",
+                [&](RenderGraph::PassBuilder& builder) {
+                    sceneColor = builder.create("sceneColor", { sceneWidth, sceneHeight, GL_RGBA8, false });
+                    // a texture when the Hi-Z pyramid is built from it
+                    sceneDepth = builder.create("sceneDepth", { sceneWidth, sceneHeight, GL_DEPTH24_STENCIL8, !gpuCulling });
+                },
+                [&](const RenderGraph::PassResources& resources) {
+                    if (options.timeScene) {
+                        glFinish();
+                        glSceneStart = std::chrono::high_resolution_clock::now();
+                    }
+                    if (gpuCulling) {
+                        StreamBuffer::flush(drawStream);
+                        GpuCulling::cull(gpuCuller, drawStream.buffer, fieldFirstInstance, fieldCount, sceneGeometry.meshes[cubeMesh],
+                                         glm::vec3(0.0f), glm::vec3(0.5f), frame.proj * frame.view);
+                    }
+
+                    GLState::enable(GL_DEPTH_TEST);
+                    glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
+                    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+                    GLState::useProgram(sceneShaderProgram);
+                    GLState::bindTexture(0, GL_TEXTURE_2D, texKitten);
+                    GLState::bindTexture(1, GL_TEXTURE_2D, texPuppy);
+
+                    DrawBatch::add(opaqueBatch, sceneGeometry, cubeMesh, { frame.cubeWorld, glm::vec4(1.0f) });
+                    DrawBatch::submit(opaqueBatch, sceneGeometry, drawStream);
+
+                    if (gpuCulling) {
+                        GLState::bindVertexArray(sceneGeometry.vao);
+                        GpuCulling::draw(gpuCuller);
+
+                        // the opaque depth is complete, next frame culls against it
+                        GpuCulling::buildPyramid(gpuCuller, resources.texture(sceneDepth), sceneWidth, sceneHeight, frame.proj * frame.view);
+                    } else {
+                        auto replayStart = std::chrono::high_resolution_clock::now();
+                        StreamBuffer::flush(drawStream);
+                        CommandList::replay(fieldLists);
+                        replayMs += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - replayStart).count();
+                        recordedFrames++;
+                    }
+                });
+
+            // the mirror quads against the finished depth, writing nothing: the
+            // reflections below are skipped when no mirror pixel passes
+            graph.addPass("mirrorQuery",
+                [&](RenderGraph::PassBuilder& builder) {
+                    sceneColor = builder.write(sceneColor);
+                    sceneDepth = builder.write(sceneDepth);
+                },
+                [&](const RenderGraph::PassResources&) {
+                    GLState::enable(GL_DEPTH_TEST);
+                    GLState::depthMask(GL_FALSE);
+                    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+                    GLState::useProgram(sceneShaderProgram);
+
+                    OcclusionQuery::begin(mirrorQuery);
+                    for (const ReflectionSnapshot& reflection : frame.reflections) {
+                        if (reflection.view.parent < 0)
+                            DrawBatch::add(mirrorBatch, sceneGeometry, floorMesh, { frame.mirrors[reflection.view.mirror], glm::vec4(1.0f) });
+                    }
+                    DrawBatch::submit(mirrorBatch, sceneGeometry, drawStream);
+                    OcclusionQuery::end(mirrorQuery);
+
+                    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+                    GLState::depthMask(GL_TRUE);
+                });
+
+            // deepest reflections first, every mirror surface samples the
+            // reflection rendered for it
+            for (int r = int(frame.reflections.size()) - 1; r >= 0; --r) {
+                const PlanarReflection::View& mirrorView = frame.reflections[r].view;
+                const int reflectionWidth = std::max(1, int(sceneWidth * mirrorView.resolutionScale));
+                const int reflectionHeight = std::max(1, int(sceneHeight * mirrorView.resolutionScale));
+                graph.addPass("reflection",
+                    [&, r](RenderGraph::PassBuilder& builder) {
+                        // nothing is sampled, this only orders the pass after the mirror query
+                        builder.read(sceneColor);
+                        reflectionColor[r] = builder.create("reflectionColor", { reflectionWidth, reflectionHeight, GL_RGBA8, false });
+                        builder.create("reflectionDepth", { reflectionWidth, reflectionHeight, GL_DEPTH24_STENCIL8, true });
+                        for (size_t child = 0; child < frame.reflections.size(); ++child) {
+                            if (frame.reflections[child].view.parent == r)
+                                builder.read(reflectionColor[child]);
+                        }
+                    },
+                    [&, r, reflectionWidth, reflectionHeight](const RenderGraph::PassResources& resources) {
+                        const ReflectionSnapshot& reflection = frame.reflections[r];
+                        UniformBlocks::Frame mirrorUniforms = frameUniforms;
+                        mirrorUniforms.view = reflection.view.view;
+                        mirrorUniforms.proj = reflection.view.proj;
+                        UniformRing::push(uniformRing, UniformBlocks::FrameBinding, &mirrorUniforms, sizeof(mirrorUniforms));
+
+                        // only the mirror's bounds on screen are shaded
+                        const glm::vec4 rect = reflection.view.rect * 0.5f + 0.5f;
+                        const int x0 = int(rect.x * reflectionWidth), y0 = int(rect.y * reflectionHeight);
+                        const int x1 = int(std::ceil(rect.z * reflectionWidth)), y1 = int(std::ceil(rect.w * reflectionHeight));
+                        GLState::enable(GL_SCISSOR_TEST);
+                        glScissor(x0, y0, x1 - x0, y1 - y0);
+
+                        // this frame's mirror query, the clear included
+                        OcclusionQuery::beginConditional(mirrorQuery);
+                        GLState::enable(GL_DEPTH_TEST);
+                        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+                        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+                        GLState::useProgram(sceneShaderProgram);
+                        GLState::bindTexture(0, GL_TEXTURE_2D, texKitten);
+                        GLState::bindTexture(1, GL_TEXTURE_2D, texPuppy);
+                        for (const DrawBatch::Instance& instance : reflection.instances)
+                            DrawBatch::add(reflectionBatch, sceneGeometry, cubeMesh, instance);
+                        DrawBatch::submit(reflectionBatch, sceneGeometry, drawStream);
+                        drawMirrors(r, resources, reflectionWidth, reflectionHeight);
+                        if (skybox.shaderProgram)
+                            Skybox::draw(skybox);
+                        OcclusionQuery::endConditional(mirrorQuery);
+
+                        GLState::disable(GL_SCISSOR_TEST);
+                    });
+            }
+
+            // the mirror surfaces, after the reflections they show
+            graph.addPass("mirrors",
+                [&](RenderGraph::PassBuilder& builder) {
+                    for (size_t r = 0; r < frame.reflections.size(); ++r) {
+                        if (frame.reflections[r].view.parent < 0)
+                            builder.read(reflectionColor[r]);
+                    }
+                    sceneColor = builder.write(sceneColor);
+                    sceneDepth = builder.write(sceneDepth);
+                },
+                [&](const RenderGraph::PassResources& resources) {
+                    // the reflection passes bound their own cameras
+                    if (!frame.reflections.empty())
+                        UniformRing::push(uniformRing, UniformBlocks::FrameBinding, &frameUniforms, sizeof(frameUniforms));
+
+                    GLState::enable(GL_DEPTH_TEST);
+                    GLState::useProgram(sceneShaderProgram);
+                    GLState::bindTexture(0, GL_TEXTURE_2D, texKitten);
+                    GLState::bindTexture(1, GL_TEXTURE_2D, texPuppy);
+                    drawMirrors(-1, resources, sceneWidth, sceneHeight);
+                });
+
+            // sky last, it only shades what the scene left uncovered
+            graph.addPass("skybox",
+                [&](RenderGraph::PassBuilder& builder) {
+                    sceneColor = builder.write(sceneColor);
+                    sceneDepth = builder.write(sceneDepth);
+                },
+                [&](const RenderGraph::PassResources&) {
+                    if (skybox.shaderProgram)
+                        Skybox::draw(skybox);
+                    if (options.timeScene) {
+                        glFinish();
+                        glSceneMs += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - glSceneStart).count();
+                        glSceneFrames++;
+                    }
+                });
+        }
 
-    GLuint texColorBuffer;
-    glGenTextures(1, &texColorBuffer);
-    glBindTexture(GL_TEXTURE_2D, texColorBuffer);
+        graph.addPass("screen",
+            [&](RenderGraph::PassBuilder& builder) {
+                builder.read(sceneColor);
+                builder.write(backbuffer);
+            },
+            [&](const RenderGraph::PassResources& resources) {
+                GLState::disable(GL_DEPTH_TEST);
+                GLState::bindVertexArray(vaoQuad);
+                GLState::useProgram(screenShaderProgram);
+                glUniform2f(uniSourceSize, float(sceneWidth), float(sceneHeight));
+                // nothing to restore at native resolution
+                glUniform1f(uniSharpness, sceneWidth < width ? 0.5f : 0.0f);
+                GLState::bindTexture(0, GL_TEXTURE_2D, resources.texture(sceneColor));
+                glDrawArrays(GL_TRIANGLES, 0, 6);
+            });
+
+        DynamicResolution::begin(gpuTimer);
+        if (graph.compile())
+            graph.execute();
+        DynamicResolution::end(gpuTimer);
+        UniformRing::endFrame(uniformRing);
+        StreamBuffer::endFrame(drawStream);
+
+        float gpuMs;
+        if (DynamicResolution::poll(gpuTimer, gpuMs) && DynamicResolution::update(resolution, gpuMs))
+            std::cout << "Resolution scale " << int(resolution.scale * 100.0f + 0.5f) << "% (GPU " << gpuMs << " ms)" << std::endl;
+        if (!printedGraphStats) {
+            graph.printStats();
+            printedGraphStats = true;
+        }
+        GLState::endFrame();
 
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, 1280, 960, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+        // the snapshot was only read by the passes, the main thread can have it back
+        FrameQueue::endRead(frameQueue);
 
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        FramePacer::wait(pacer);
+        glfwSwapBuffers(window);
+        FramePacer::presented(pacer);
+    }
 
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texColorBuffer, 0);
+    GpuCulling::printStats(gpuCuller);
+    GpuCulling::destroy(gpuCuller);
+    OcclusionQuery::printStats(mirrorQuery, "Reflection");
+    OcclusionQuery::destroy(mirrorQuery);
+    DrawBatch::destroy(sceneGeometry);
+    glDeleteVertexArrays(1, &vaoQuad);
+    glDeleteBuffers(1, &vboQuad);
+    glDeleteShader(sceneVertexShader);
+    glDeleteShader(sceneFragmentShader);
+    glDeleteProgram(sceneShaderProgram);
+    glDeleteShader(screenVertexShader);
+    glDeleteShader(screenFragmentShader);
+    glDeleteProgram(screenShaderProgram);
+    Skybox::destroy(skybox);
+    renderTargets.clear();
+    DynamicResolution::destroy(gpuTimer);
+    if (glSceneFrames > 0)
+        std::cout << "GL scene passes: " << glSceneMs / glSceneFrames << " ms per frame, scene through skybox between glFinish calls" << std::endl;
+    if (softFrames > 0)
+        std::cout << "Software raster: " << (softSetupMs + softRasterMs) / softFrames << " ms scene pass per frame (" << softSetupMs / softFrames
+                  << " setup, " << softRasterMs / softFrames << " binning and tiles, upload not included), " << softRenderer.stats.triangles << " triangles in "
+                  << softRenderer.stats.binned << " tile entries" << std::endl;
+    if (recordedFrames > 0)
+        std::cout << "Field command lists: " << recordMs / recordedFrames << " ms recording, " << replayMs / recordedFrames
+                  << " ms replaying per frame" << std::endl;
+    FramePacer::end(pacer);
+    FramePacer::printStats(pacer);
+    StreamBuffer::printStats(uniformRing.stream, "Uniform stream");
+    StreamBuffer::printStats(drawStream, "Draw stream");
+    UniformRing::destroy(uniformRing);
+    StreamBuffer::destroy(drawStream);
+    GLState::printStats();
 
-    GLuint rboDepthStencil;
-    glGenRenderbuffers(1, &rboDepthStencil);
-    glBindRenderbuffer(GL_RENDERBUFFER, rboDepthStencil);
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, 1280, 960);
-    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, rboDepthStencil);
+    delete shaderSources;
 
-    // projection
-    glm::mat4 proj = glm::perspective(glm::radians(45.0f), 1280.0f / 960.0f, 1.0f, 10.0f);
-    GLint uniProj = glGetUniformLocation(sceneShaderProgram, "proj");
-    glUniformMatrix4fv(uniProj, 1, GL_FALSE, glm::value_ptr(proj));
+    glfwMakeContextCurrent(NULL);
+}
 
-    GLint uniColor = glGetUniformLocation(sceneShaderProgram, "overrideColor");
+int main(int argc, char** argv) {
+    JobSystem::start();
+
+    FixedTimestep::Clock simulationClock;
+    FramePacer::Pacer pacer;
+    FrameQueue::Queue frameQueue;
+    RenderOptions renderOptions;
+    bool occlusionCulling = true;
+    PlanarReflection::Settings mirrorSettings;
+    for (int i = 1; i < argc; ++i) {
+        if (std::string_view(argv[i]) == "--software") {
+            renderOptions.software = true;
+            continue;
+        }
+        if (std::string_view(argv[i]) == "--fixed-resolution") {
+            renderOptions.fixedResolution = true;
+            continue;
+        }
+        if (std::string_view(argv[i]) == "--no-occlusion") {
+            occlusionCulling = false;
+            continue;
+        }
+        if (std::string_view(argv[i]) == "--gpu-culling") {
+            renderOptions.gpuCulling = true;
+            continue;
+        }
+        if (std::string_view(argv[i]) == "--time-scene") {
+            renderOptions.timeScene = true;
+            continue;
+        }
+        if (std::string_view(argv[i]) == "--mirror-depth" && i + 1 < argc) {
+            mirrorSettings.maxDepth = std::clamp(atoi(argv[++i]), 0, 4);
+            continue;
+        }
+        if (std::string_view(argv[i]) == "--mirror-scale" && i + 1 < argc) {
+            mirrorSettings.resolutionScale = std::clamp(float(atof(argv[++i])), 0.1f, 1.0f);
+            continue;
+        }
+        if (int used = FramePacer::parseArgument(pacer, argc, argv, i)) {
+            i += used - 1;
+            continue;
+        }
+        if (std::string_view(argv[i]) == "--sim-hz" && i + 1 < argc) {
+            FixedTimestep::setRate(simulationClock, atof(argv[++i]));
+            continue;
+        }
+        if (std::string_view(argv[i]) == "--snapshots" && i + 1 < argc) {
+            frameQueue.slots = std::clamp(atoi(argv[++i]), 2, FrameQueue::MaxSlots);
+            continue;
+        }
+        if (std::string_view(argv[i]) == "--bench-culling") {
+            FrustumCulling::benchmark();
+            return 0;
+        }
+        if (std::string_view(argv[i]) == "--bench-bvh") {
+            Bvh::benchmark();
+            return 0;
+        }
+        if (std::string_view(argv[i]) == "--bench-commands") {
+            CommandList::benchmark();
+            return 0;
+        }
+        if (std::string_view(argv[i]) == "--bench-jobs") {
+            JobSystem::benchmark();
+            return 0;
+        }
+        if (std::string_view(argv[i]) == "--bench-sampler") {
+            Sampler::benchmark();
+            return 0;
+        }
+    }
+
+    GLFWwindow* window;
+
+    if(!glfwInit())
+        return -1;
+
+    window = glfwCreateWindow(1280, 960, "Render", NULL, NULL);
+    if(!window) {
+		glfwTerminate();
+		return -2;
+	}
+
+    CubeField::Field cubeField;
+    CubeField::create(cubeField, 64, 0.25f, 1.25f);
+
+    // only what the frustum touches goes into the batch
+    FrustumCulling::Bounds fieldBounds;
+    std::vector<Bvh::Aabb> fieldBoxes;
+    for (int i = 0; i < int(cubeField.positions.size()); ++i) {
+        glm::vec3 center, extents;
+        CubeField::bounds(cubeField, i, center, extents);
+        FrustumCulling::add(fieldBounds, center, extents);
+        fieldBoxes.push_back({ center - extents, center + extents });
+    }
+    std::vector<uint32_t> visibleField;
+
+    // and of that, only what the cube in the middle does not hide
+    OcclusionCulling::Culler occlusionCuller;
+
+    // clicking a cube highlights it
+    Bvh::Tree fieldTree;
+    Bvh::build(fieldTree, fieldBoxes);
+    int pickedCube = -1;
+
+    Transforms::Hierarchy sceneTransforms;
+    uint32_t cubeNode = Transforms::add(sceneTransforms);
+    uint32_t fieldNode = Transforms::add(sceneTransforms);
+    std::vector<uint32_t> fieldNodes;
+    for (size_t i = 0; i < cubeField.positions.size(); ++i)
+        fieldNodes.push_back(Transforms::add(sceneTransforms, fieldNode));
+
+    const glm::mat4 view = glm::lookAt(
+        glm::vec3(2.5f, 2.5f, 2.0f),
+        glm::vec3(0.0f, 0.0f, 0.0f),
+        glm::vec3(0.0f, 0.0f, 1.0f)
+    );
+    bool printedSceneStats = false;
+
+    // the floor is a mirror, its corners are the floor mesh's
+    const std::vector<glm::mat4> mirrorModels = { glm::mat4(1.0f) };
+    std::vector<PlanarReflection::Mirror> mirrors(mirrorModels.size());
+    for (size_t m = 0; m < mirrors.size(); ++m) {
+        const glm::vec2 floorCorners[4] = { { -1.0f, -1.0f }, { 1.0f, -1.0f }, { 1.0f, 1.0f }, { -1.0f, 1.0f } };
+        for (int c = 0; c < 4; ++c)
+            mirrors[m].corners[c] = glm::vec3(mirrorModels[m] * glm::vec4(floorCorners[c], -0.5f, 1.0f));
+    }
+    std::vector<PlanarReflection::View> mirrorViews;
+    std::vector<std::vector<uint32_t>> reflectedField;
+    std::vector<uint32_t> posedField, mergedField;
+    size_t reflectedTotal = 0, reflectedFrames = 0;
+
+    // the GL context moves to the render thread, this one simulates and
+    // fills the next snapshot while the previous one is drawn
+    FrameSnapshot snapshots[FrameQueue::MaxSlots];
+    std::thread renderer(renderThread, window, std::ref(frameQueue), snapshots, std::ref(pacer), renderOptions);
+
+    SimulationState previousState, currentState;
+    auto lastFrame = std::chrono::high_resolution_clock::now();
 
     while (!glfwWindowShouldClose(window)) {
         
-        // calculate transformations
+        // step the simulation by the time the last frame took
         auto now = std::chrono::high_resolution_clock::now();
-        //float time = std::chrono::duration_cast<std::chrono::duration<float>>(now.time_since_epoch()).count() / 1000.0f;
-        float time = std::chrono::duration_cast<std::chrono::duration<float>>(now - start).count();
+        double frameSeconds = std::chrono::duration<double>(now - lastFrame).count();
+        lastFrame = now;
+        int steps = FixedTimestep::advance(simulationClock, frameSeconds);
+        for (int step = 0; step < steps; ++step) {
+            previousState = currentState;
+            simulate(currentState, simulationClock.step);
+        }
 
-        //custom framebuffer operations here
+        // render between the two latest states so motion stays smooth at any frame rate
+        float alpha = FixedTimestep::alpha(simulationClock);
+        float time = float(glm::mix(previousState.time, currentState.time, double(alpha)));
+        float cubeAngle = glm::mix(previousState.cubeAngle, currentState.cubeAngle, alpha);
+
+        int width, height;
+        glfwGetFramebufferSize(window, &width, &height);
+        if (width == 0 || height == 0) {
+            // minimized, nothing to render into: sleep until the window comes back
+            glfwWaitEvents();
+            continue;
+        }
 
-        {
+        const glm::mat4 proj = glm::perspective(glm::radians(45.0f), float(width) / float(height), 1.0f, 10.0f);
+        const glm::quat cubeRotation = glm::angleAxis(cubeAngle, glm::vec3(0.0f, 0.0f, 1.0f));
+        if (renderOptions.gpuCulling) {
+            // the render thread culls on the GPU, it gets the whole field
+            visibleField.resize(fieldBounds.size());
+            std::iota(visibleField.begin(), visibleField.end(), 0u);
+        } else {
+            FrustumCulling::cull(FrustumCulling::extract(proj * view), fieldBounds, visibleField);
+        }
+        if (occlusionCulling && !renderOptions.gpuCulling) {
+            OcclusionCulling::begin(occlusionCuller, proj * view);
+            OcclusionCulling::addOccluder(occlusionCuller, glm::mat4_cast(cubeRotation), Vertices::cubeVertices, 36, 8);
+            OcclusionCulling::finish(occlusionCuller);
+            OcclusionCulling::cull(occlusionCuller, fieldBounds, visibleField);
+        }
 
+        // every mirror view culls the field against its own narrowed frustum
+        PlanarReflection::build(mirrors, mirrorSettings, view, proj, mirrorViews);
+        reflectedField.resize(mirrorViews.size());
+        posedField = visibleField;
+        for (size_t r = 0; r < mirrorViews.size(); ++r) {
+            reflectedTotal += FrustumCulling::cull(mirrorViews[r].frustum, fieldBounds, reflectedField[r]);
+            mergedField.clear();
+            std::set_union(posedField.begin(), posedField.end(), reflectedField[r].begin(), reflectedField[r].end(), std::back_inserter(mergedField));
+            posedField.swap(mergedField);
+        }
+        reflectedFrames++;
+
+        // hidden field cubes keep their old pose, nothing reads it until they're visible again
+        Transforms::setRotation(sceneTransforms, cubeNode, cubeRotation);
+        JobSystem::parallelFor(posedField.size(), 256, [&](size_t begin, size_t end) {
+            for (size_t v = begin; v < end; ++v) {
+                const uint32_t i = posedField[v];
+                glm::vec3 position;
+                glm::quat rotation;
+                CubeField::pose(cubeField, i, time, position, rotation);
+                Transforms::setLocal(sceneTransforms, fieldNodes[i], position, rotation, glm::vec3(cubeField.size));
+            }
+        });
+        Transforms::update(sceneTransforms);
+
+        if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS) {
+            // cursor positions are in window units, which differ from pixels on high DPI screens
+            double cursorX, cursorY;
+            int windowWidth, windowHeight;
+            glfwGetCursorPos(window, &cursorX, &cursorY);
+            glfwGetWindowSize(window, &windowWidth, &windowHeight);
+            Bvh::Hit hit;
+            Bvh::Ray ray = Bvh::screenRay(view, proj, float(cursorX), float(cursorY), windowWidth, windowHeight);
+            pickedCube = Bvh::raycast(fieldTree, ray, hit) ? int(hit.object) : -1;
         }
 
-        ////set default framebuffer
-        ////glBindFramebuffer(GL_FRAMEBUFFER, 0);
-        //glBindVertexArray(vaoQuad);
-        ////glDisable(GL_DEPTH_TEST);
-        //glUseProgram(screenShaderProgram);
+        const int slot = FrameQueue::beginWrite(frameQueue);
+        if (slot < 0)
+            break;
+        FrameSnapshot& frame = snapshots[slot];
+        frame.width = width;
+        frame.height = height;
+        frame.view = view;
+        frame.proj = proj;
+        frame.time = time;
+        frame.cubeWorld = Transforms::world(sceneTransforms, cubeNode);
+        auto fieldInstance = [&](uint32_t i) {
+            return DrawBatch::Instance{ Transforms::world(sceneTransforms, fieldNodes[i]),
+                                        int(i) == pickedCube ? glm::vec4(1.0f, 0.2f, 0.2f, 1.0f) : CubeField::color(cubeField, i) };
+        };
+        frame.field.resize(visibleField.size());
+        JobSystem::parallelFor(visibleField.size(), 1024, [&](size_t begin, size_t end) {
+            for (size_t v = begin; v < end; ++v)
+                frame.field[v] = fieldInstance(visibleField[v]);
+        });
+        frame.mirrors = mirrorModels;
+        frame.reflections.resize(mirrorViews.size());
+        for (size_t r = 0; r < mirrorViews.size(); ++r) {
+            ReflectionSnapshot& reflection = frame.reflections[r];
+            reflection.view = mirrorViews[r];
+            reflection.instances.clear();
+            // the cube spins about z, its box is the swept one
+            if (PlanarReflection::visible(mirrorViews[r], glm::vec3(0.0f), glm::vec3(0.7072f, 0.7072f, 0.5f)))
+                reflection.instances.push_back({ frame.cubeWorld, glm::vec4(1.0f) });
+            for (uint32_t i : reflectedField[r])
+                reflection.instances.push_back(fieldInstance(i));
+        }
+        FrameQueue::endWrite(frameQueue);
 
-        //glDrawArrays(GL_TRIANGLES, 0, 6);
+        if (!printedSceneStats) {
+            std::cout << "Scene: " << visibleField.size() << " of " << fieldBounds.size() << " field cubes visible, "
+                      << sceneTransforms.lastUpdated << " of " << Transforms::size(sceneTransforms) << " transforms updated" << std::endl;
+            printedSceneStats = true;
+        }
+
+        glfwPollEvents();
 
-        //glfwSwapBuffers(window);
-        //glfwPollEvents();
-        
         if (glfwGetKey(window, GLFW_KEY_ESCAPE))
             glfwSetWindowShouldClose(window, GLFW_TRUE);
     }
 
-    glDeleteVertexArrays(1, &vaoCube);
-    glDeleteVertexArrays(1, &vaoQuad);
-    glDeleteBuffers(1, &vboCube);
-    glDeleteBuffers(1, &vboQuad);
-    glDeleteShader(sceneVertexShader);
-    glDeleteShader(sceneFragmentShader);
-    glDeleteProgram(sceneShaderProgram);
-    glDeleteShader(screenVertexShader);
-    glDeleteShader(screenFragmentShader);
-    glDeleteProgram(screenShaderProgram);
+    FrameQueue::close(frameQueue);
+    renderer.join();
 
-    delete shaderSources;
+    FrameQueue::printStats(frameQueue);
+    FixedTimestep::printStats(simulationClock);
+    OcclusionCulling::printStats(occlusionCuller);
+    if (reflectedFrames > 0)
+        std::cout << "Mirrors: " << reflectedTotal / reflectedFrames << " field cubes per frame in " << mirrorViews.size()
+                  << " reflected views (depth " << mirrorSettings.maxDepth << ", " << int(mirrorSettings.resolutionScale * 100.0f + 0.5f)
+                  << "% resolution)" << std::endl;
+    JobSystem::stop();
 
 	return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,152 @@
+#include "CommandList.h"
+
+#include "GLState.h"
+#include "../Jobs/JobSystem.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <thread>
+
+namespace {
+
+    using CommandList::Command;
+    using CommandList::List;
+    using CommandList::Op;
+
+    void push(List& list, Op op, uint32_t a = 0, uint32_t b = 0, uint32_t c = 0, uint32_t d = 0, uint32_t e = 0) {
+        list.commands.push_back({ op, { a, b, c, d, e } });
+    }
+}
+
+void CommandList::reset(List& list) {
+    list.commands.clear();
+    list.draws = 0;
+}
+
+void CommandList::useProgram(List& list, GLuint program) {
+    push(list, Op::UseProgram, program);
+}
+
+void CommandList::bindVertexArray(List& list, GLuint vao) {
+    push(list, Op::BindVertexArray, vao);
+}
+
+void CommandList::bindUniformRange(List& list, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size) {
+    // stream buffers are far smaller than 4 GB
+    push(list, Op::BindUniformRange, index, buffer, uint32_t(offset), uint32_t(size));
+}
+
+void CommandList::bindTexture(List& list, GLuint unit, GLenum target, GLuint texture) {
+    push(list, Op::BindTexture, unit, target, texture);
+}
+
+void CommandList::enable(List& list, GLenum cap) {
+    push(list, Op::Enable, cap);
+}
+
+void CommandList::disable(List& list, GLenum cap) {
+    push(list, Op::Disable, cap);
+}
+
+void CommandList::drawArrays(List& list, GLint first, GLsizei count) {
+    push(list, Op::DrawArrays, uint32_t(first), uint32_t(count));
+    list.draws++;
+}
+
+void CommandList::drawElements(List& list, GLuint count, GLuint instanceCount, GLuint firstIndex, GLint baseVertex, GLuint baseInstance) {
+    push(list, Op::DrawElements, count, instanceCount, firstIndex, uint32_t(baseVertex), baseInstance);
+    list.draws++;
+}
+
+void CommandList::replay(const List& list) {
+    for (const Command& command : list.commands) {
+        const uint32_t* arg = command.arg;
+        switch (command.op) {
+        case Op::UseProgram:
+            GLState::useProgram(arg[0]);
+            break;
+        case Op::BindVertexArray:
+            GLState::bindVertexArray(arg[0]);
+            break;
+        case Op::BindUniformRange:
+            GLState::bindBufferRange(GL_UNIFORM_BUFFER, arg[0], arg[1], GLintptr(arg[2]), GLsizeiptr(arg[3]));
+            break;
+        case Op::BindTexture:
+            GLState::bindTexture(arg[0], arg[1], arg[2]);
+            break;
+        case Op::Enable:
+            GLState::enable(arg[0]);
+            break;
+        case Op::Disable:
+            GLState::disable(arg[0]);
+            break;
+        case Op::DrawArrays:
+            glDrawArrays(GL_TRIANGLES, GLint(arg[0]), GLsizei(arg[1]));
+            break;
+        case Op::DrawElements:
+            glDrawElementsInstancedBaseVertexBaseInstance(GL_TRIANGLES, GLsizei(arg[0]), GL_UNSIGNED_INT,
+                (void*)(size_t(arg[2]) * sizeof(GLuint)), GLsizei(arg[1]), GLint(arg[3]), arg[4]);
+            break;
+        }
+    }
+}
+
+void CommandList::replay(const std::vector<List>& lists) {
+    for (const List& list : lists)
+        replay(list);
+}
+
+void CommandList::benchmark() {
+    // a draw per object with the binds a real object would bring along
+    const size_t objects = 1000000;
+    const size_t objectsPerList = 4096;
+    const size_t listCount = (objects + objectsPerList - 1) / objectsPerList;
+    std::vector<List> lists(listCount);
+
+    auto record = [&]() {
+        JobSystem::parallelFor(listCount, 1, [&](size_t first, size_t last) {
+            for (size_t l = first; l < last; ++l) {
+                List& list = lists[l];
+                reset(list);
+                useProgram(list, 1);
+                bindVertexArray(list, 1);
+                const size_t begin = l * objectsPerList;
+                const size_t end = std::min(begin + objectsPerList, objects);
+                for (size_t o = begin; o < end; ++o) {
+                    bindTexture(list, 0, GL_TEXTURE_2D, GLuint(1 + o % 8));
+                    bindUniformRange(list, 1, 1, GLintptr(o % 1024) * 256, 256);
+                    drawElements(list, 36, 1, 0, 0, GLuint(o));
+                }
+            }
+        });
+    };
+
+    const int maxThreads = int(std::max(1u, std::thread::hardware_concurrency()));
+    std::cout << "Command recording, " << objects << " draws in " << listCount << " lists (" << maxThreads << " hardware threads)" << std::endl;
+    double base = 0.0;
+    for (int threads = 1; threads <= maxThreads; ++threads) {
+        JobSystem::start(threads);
+        record();   // warm up, lists reach their full capacity
+
+        int runs = 0;
+        double ms = 0.0;
+        auto start = std::chrono::high_resolution_clock::now();
+        while (runs < 3 || ms < 200.0) {
+            record();
+            runs++;
+            ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        }
+        JobSystem::stop();
+
+        size_t commands = 0;
+        for (const List& list : lists)
+            commands += list.commands.size();
+        const double perRun = ms / runs;
+        if (threads == 1)
+            base = perRun;
+        std::cout << "  " << threads << (threads == 1 ? " thread: " : " threads: ") << perRun << " ms, "
+                  << std::lround(commands / perRun) << " commands per ms (x" << base / perRun << ")" << std::endl;
+    }
+}
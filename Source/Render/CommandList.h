@@ -0,0 +1,54 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstdint>
+#include <vector>
+
+// Recorded GL work. Any thread can fill a list, since recording only
+// appends fixed size commands to a vector; the context thread replays the
+// lists in order. Replay goes through GLState, so binds that repeat from one
+// list to the next cost nothing. Draws are triangles with 32-bit indices,
+// which is all the renderer uses.
+namespace CommandList {
+
+    enum class Op : uint32_t {
+        UseProgram,
+        BindVertexArray,
+        BindUniformRange,
+        BindTexture,
+        Enable,
+        Disable,
+        DrawArrays,
+        DrawElements,
+    };
+
+    struct Command {
+        Op op;
+        uint32_t arg[5];
+    };
+
+    struct List {
+        std::vector<Command> commands;
+        int draws = 0;
+    };
+
+    // Empties the list, keeping its memory
+    void reset(List& list);
+
+    void useProgram(List& list, GLuint program);
+    void bindVertexArray(List& list, GLuint vao);
+    void bindUniformRange(List& list, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size);
+    void bindTexture(List& list, GLuint unit, GLenum target, GLuint texture);
+    void enable(List& list, GLenum cap);
+    void disable(List& list, GLenum cap);
+    void drawArrays(List& list, GLint first, GLsizei count);
+    void drawElements(List& list, GLuint count, GLuint instanceCount, GLuint firstIndex, GLint baseVertex, GLuint baseInstance);
+
+    // Context thread only
+    void replay(const List& list);
+    void replay(const std::vector<List>& lists);
+
+    // Recording throughput with 1 to N job threads, no GL needed
+    void benchmark();
+}
@@ -0,0 +1,135 @@
+#include "DrawBatch.h"
+#include "GLState.h"
+
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <map>
+
+int DrawBatch::addMesh(Geometry& geometry, const float* vertices, int vertexCount, int floatsPerVertex) {
+    if (geometry.floatsPerVertex == 0)
+        geometry.floatsPerVertex = floatsPerVertex;
+    if (geometry.floatsPerVertex != floatsPerVertex) {
+        std::cout << "ERROR::DRAWBATCH::VERTEX_LAYOUT_MISMATCH\n" << floatsPerVertex << " floats per vertex, geometry has "
+                  << geometry.floatsPerVertex << std::endl;
+        return -1;
+    }
+
+    Mesh mesh;
+    mesh.firstIndex = GLuint(geometry.indices.size());
+    mesh.indexCount = GLuint(vertexCount);
+    mesh.baseVertex = GLint(geometry.vertices.size() / floatsPerVertex);
+
+    // indices are relative to baseVertex
+    std::map<std::vector<float>, GLuint> welded;
+    for (int i = 0; i < vertexCount; ++i) {
+        std::vector<float> vertex(vertices + i * floatsPerVertex, vertices + (i + 1) * floatsPerVertex);
+        auto found = welded.find(vertex);
+        if (found == welded.end()) {
+            found = welded.emplace(vertex, GLuint(welded.size())).first;
+            geometry.vertices.insert(geometry.vertices.end(), vertex.begin(), vertex.end());
+        }
+        geometry.indices.push_back(found->second);
+    }
+
+    geometry.meshes.push_back(mesh);
+    return int(geometry.meshes.size()) - 1;
+}
+
+void DrawBatch::upload(Geometry& geometry) {
+    glGenVertexArrays(1, &geometry.vao);
+    glGenBuffers(1, &geometry.vertexBuffer);
+    glGenBuffers(1, &geometry.indexBuffer);
+
+    glBindVertexArray(geometry.vao);
+    glBindBuffer(GL_ARRAY_BUFFER, geometry.vertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, geometry.vertices.size() * sizeof(float), geometry.vertices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, geometry.indexBuffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, geometry.indices.size() * sizeof(GLuint), geometry.indices.data(), GL_STATIC_DRAW);
+
+    // the GL copies are all that's needed from here on
+    geometry.vertices = std::vector<float>();
+    geometry.indices = std::vector<GLuint>();
+}
+
+void DrawBatch::setInstanceAttributes(GLuint program, GLuint instanceBuffer) {
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+
+    // a mat4 attribute takes four consecutive locations, one per column
+    GLint modelAttrib = glGetAttribLocation(program, "instanceModel");
+    for (int column = 0; column < 4; ++column) {
+        glEnableVertexAttribArray(modelAttrib + column);
+        glVertexAttribPointer(modelAttrib + column, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)(column * sizeof(glm::vec4)));
+        glVertexAttribDivisor(modelAttrib + column, 1);
+    }
+
+    GLint colorAttrib = glGetAttribLocation(program, "instanceColor");
+    glEnableVertexAttribArray(colorAttrib);
+    glVertexAttribPointer(colorAttrib, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)offsetof(Instance, color));
+    glVertexAttribDivisor(colorAttrib, 1);
+}
+
+void DrawBatch::add(Batch& batch, const Geometry& geometry, int mesh, const Instance& instance) {
+    const Mesh& source = geometry.meshes[mesh];
+    batch.instances.push_back(instance);
+
+    if (!batch.commands.empty()) {
+        Command& last = batch.commands.back();
+        if (last.firstIndex == source.firstIndex && last.baseVertex == source.baseVertex) {
+            last.instanceCount++;
+            return;
+        }
+    }
+
+    // baseInstance is relative to the batch until submit()
+    Command command = { source.indexCount, 1, source.firstIndex, source.baseVertex, GLuint(batch.instances.size() - 1) };
+    batch.commands.push_back(command);
+}
+
+void DrawBatch::submit(Batch& batch, const Geometry& geometry, StreamBuffer::Buffer& stream) {
+    batch.stats = Stats();
+    if (batch.commands.empty())
+        return;
+
+    // instance rows are aligned to their own size so an offset is an index
+    StreamBuffer::Allocation instances = StreamBuffer::allocate(stream, batch.instances.size() * sizeof(Instance), sizeof(Instance));
+    StreamBuffer::Allocation commands = StreamBuffer::allocate(stream, batch.commands.size() * sizeof(Command), sizeof(GLuint));
+    if (instances.data && commands.data) {
+        const GLuint firstInstance = GLuint(instances.offset / sizeof(Instance));
+        memcpy(instances.data, batch.instances.data(), instances.size);
+
+        Command* streamed = reinterpret_cast<Command*>(commands.data);
+        for (size_t i = 0; i < batch.commands.size(); ++i) {
+            streamed[i] = batch.commands[i];
+            streamed[i].baseInstance += firstInstance;
+        }
+        StreamBuffer::flush(stream);
+
+        GLState::bindVertexArray(geometry.vao);
+        const GLsizei count = GLsizei(batch.commands.size());
+        if (GLEW_ARB_multi_draw_indirect) {
+            GLState::bindBuffer(GL_DRAW_INDIRECT_BUFFER, stream.buffer);
+            glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)commands.offset, count, 0);
+            batch.stats.calls = 1;
+        } else {
+            // same commands one at a time, still no per-draw uniform uploads
+            for (const Command& command : batch.commands)
+                glDrawElementsInstancedBaseVertexBaseInstance(GL_TRIANGLES, command.count, GL_UNSIGNED_INT,
+                    (void*)(command.firstIndex * sizeof(GLuint)), command.instanceCount, command.baseVertex,
+                    command.baseInstance + firstInstance);
+            batch.stats.calls = count;
+        }
+        batch.stats.draws = int(batch.instances.size());
+        batch.stats.commands = count;
+    }
+
+    batch.commands.clear();
+    batch.instances.clear();
+}
+
+void DrawBatch::destroy(Geometry& geometry) {
+    GLState::deleteVertexArrays(1, &geometry.vao);
+    GLuint buffers[] = { geometry.vertexBuffer, geometry.indexBuffer };
+    GLState::deleteBuffers(2, buffers);
+    geometry = Geometry();
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+#include "StreamBuffer.h"
+
+// Batched submission. Every mesh lives in one shared vertex and index
+// buffer, per-draw data is an instance attribute, and a batch goes out as a
+// single glMultiDrawElementsIndirect. Each command's baseInstance points at
+// its row of instance data, so the instance attributes are set up once
+// against the stream buffer and never move.
+namespace DrawBatch {
+
+    // GL's DrawElementsIndirectCommand
+    struct Command {
+        GLuint count;
+        GLuint instanceCount;
+        GLuint firstIndex;
+        GLint baseVertex;
+        GLuint baseInstance;
+    };
+
+    // Per-draw data, read by the vertex shader as
+    //     in mat4 instanceModel; in vec4 instanceColor;
+    struct Instance {
+        glm::mat4 model;
+        glm::vec4 color;
+    };
+
+    struct Mesh {
+        GLuint firstIndex = 0;
+        GLuint indexCount = 0;
+        GLint baseVertex = 0;
+    };
+
+    struct Geometry {
+        GLuint vao = 0;
+        GLuint vertexBuffer = 0;
+        GLuint indexBuffer = 0;
+        int floatsPerVertex = 0;
+        std::vector<float> vertices;    // freed by upload()
+        std::vector<GLuint> indices;
+        std::vector<Mesh> meshes;
+    };
+
+    // Adds a non-indexed triangle list, welding identical vertices.
+    // Returns the mesh id.
+    int addMesh(Geometry& geometry, const float* vertices, int vertexCount, int floatsPerVertex);
+
+    // Creates the buffers and the VAO and leaves the VAO bound, so the caller
+    // can point the per-vertex attributes at GL_ARRAY_BUFFER
+    void upload(Geometry& geometry);
+
+    // Points the program's instanceModel/instanceColor at the stream buffer,
+    // with the geometry's VAO bound
+    void setInstanceAttributes(GLuint program, GLuint instanceBuffer);
+
+    struct Stats {
+        int draws = 0;      // instances added
+        int commands = 0;   // indirect commands after merging
+        int calls = 0;      // GL draw calls issued
+    };
+
+    struct Batch {
+        std::vector<Command> commands;
+        std::vector<Instance> instances;
+        Stats stats;
+    };
+
+    // Back to back adds of the same mesh become one instanced command
+    void add(Batch& batch, const Geometry& geometry, int mesh, const Instance& instance);
+
+    // Streams the commands and instances and draws them with the geometry's
+    // VAO, then empties the batch. The program and state are the caller's.
+    void submit(Batch& batch, const Geometry& geometry, StreamBuffer::Buffer& stream);
+
+    void destroy(Geometry& geometry);
+}
@@ -0,0 +1,90 @@
+#include "DynamicResolution.h"
+
+#include <algorithm>
+#include <cmath>
+
+bool DynamicResolution::update(Controller& controller, float frameMs) {
+    const Settings& settings = controller.settings;
+
+    if (controller.averageMs == 0.0f)
+        controller.averageMs = frameMs;
+    else
+        controller.averageMs += (frameMs - controller.averageMs) * settings.smoothing;
+
+    if (controller.averageMs > settings.targetMs * settings.dropAbove) {
+        controller.framesOver++;
+        controller.framesUnder = 0;
+    } else if (controller.averageMs < settings.targetMs * settings.raiseBelow) {
+        controller.framesUnder++;
+        controller.framesOver = 0;
+    } else {
+        // inside the band, hold
+        controller.framesOver = 0;
+        controller.framesUnder = 0;
+    }
+
+    float scale = controller.scale;
+    if (controller.framesOver >= settings.dropFrames)
+        scale -= settings.step;
+    else if (controller.framesUnder >= settings.raiseFrames)
+        scale += settings.step;
+    scale = std::clamp(scale, settings.minScale, settings.maxScale);
+
+    if (std::fabs(scale - controller.scale) < settings.step * 0.5f)
+        return false;
+
+    // the average still reflects the old size, restart the counting from here
+    controller.scale = scale;
+    controller.averageMs = 0.0f;
+    controller.framesOver = 0;
+    controller.framesUnder = 0;
+    controller.changes++;
+    return true;
+}
+
+void DynamicResolution::scaledSize(const Controller& controller, int width, int height, int& scaledWidth, int& scaledHeight) {
+    scaledWidth = std::max(1, int(std::lround(width * controller.scale)));
+    scaledHeight = std::max(1, int(std::lround(height * controller.scale)));
+}
+
+void DynamicResolution::create(GpuTimer& timer) {
+    timer.supported = GLEW_ARB_timer_query || GLEW_VERSION_3_3;
+    if (timer.supported)
+        glGenQueries(GpuTimer::Latency, timer.queries);
+    timer.frame = 0;
+}
+
+void DynamicResolution::begin(GpuTimer& timer) {
+    if (timer.supported)
+        glBeginQuery(GL_TIME_ELAPSED, timer.queries[timer.frame % GpuTimer::Latency]);
+}
+
+void DynamicResolution::end(GpuTimer& timer) {
+    if (!timer.supported)
+        return;
+    glEndQuery(GL_TIME_ELAPSED);
+    timer.frame++;
+}
+
+bool DynamicResolution::poll(GpuTimer& timer, float& milliseconds) {
+    // the slot the next begin() reuses is the oldest one in flight
+    if (!timer.supported || timer.frame < GpuTimer::Latency)
+        return false;
+
+    GLuint query = timer.queries[timer.frame % GpuTimer::Latency];
+    GLint available = 0;
+    glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available)
+        return false;
+
+    GLuint64 nanoseconds = 0;
+    glGetQueryObjectui64v(query, GL_QUERY_RESULT, &nanoseconds);
+    milliseconds = float(nanoseconds / 1.0e6);
+    return true;
+}
+
+void DynamicResolution::destroy(GpuTimer& timer) {
+    if (timer.supported)
+        glDeleteQueries(GpuTimer::Latency, timer.queries);
+    timer = GpuTimer();
+}
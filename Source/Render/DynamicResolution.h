@@ -0,0 +1,52 @@
+#pragma once
+
+#include <GL/glew.h>
+
+// Scales the offscreen targets between 50% and 100% of the window to hold a
+// GPU frame time target. Drops quickly when over budget, climbs back slowly,
+// and only moves in fixed steps so the render targets aren't reallocated
+// every frame.
+namespace DynamicResolution {
+
+    struct Settings {
+        float targetMs = 16.0f;
+        float minScale = 0.5f;
+        float maxScale = 1.0f;
+        float step = 0.05f;
+        float dropAbove = 1.05f;    // of targetMs
+        float raiseBelow = 0.85f;   // of targetMs
+        int dropFrames = 3;         // consecutive frames over before dropping
+        int raiseFrames = 30;       // consecutive frames under before raising
+        float smoothing = 0.1f;     // weight of the newest sample in the average
+    };
+
+    struct Controller {
+        Settings settings;
+        float scale = 1.0f;
+        float averageMs = 0.0f;
+        int framesOver = 0;
+        int framesUnder = 0;
+        int changes = 0;
+    };
+
+    // Feeds one frame time, returns true when the scale changed
+    bool update(Controller& controller, float frameMs);
+
+    void scaledSize(const Controller& controller, int width, int height, int& scaledWidth, int& scaledHeight);
+
+    // GL_TIME_ELAPSED around the frame's GPU work. Results are read a few
+    // frames late from a ring of queries so polling never stalls.
+    struct GpuTimer {
+        static const int Latency = 3;
+        GLuint queries[Latency] = {};
+        int frame = 0;
+        bool supported = false;
+    };
+
+    void create(GpuTimer& timer);
+    void begin(GpuTimer& timer);
+    void end(GpuTimer& timer);
+    // Returns false until the oldest query has a result
+    bool poll(GpuTimer& timer, float& milliseconds);
+    void destroy(GpuTimer& timer);
+}
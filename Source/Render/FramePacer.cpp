@@ -0,0 +1,143 @@
+#include "FramePacer.h"
+
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string_view>
+#include <thread>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <timeapi.h>
+#pragma comment(lib, "winmm.lib")
+#endif
+
+namespace {
+
+    double milliseconds(FramePacer::Clock::duration duration) {
+        return std::chrono::duration<double, std::milli>(duration).count();
+    }
+
+    FramePacer::Clock::duration period(const FramePacer::Pacer& pacer) {
+        return std::chrono::duration_cast<FramePacer::Clock::duration>(std::chrono::duration<double>(1.0 / pacer.targetFps));
+    }
+
+    const char* modeName(FramePacer::Mode mode) {
+        switch (mode) {
+        case FramePacer::Mode::Vsync: return "vsync";
+        case FramePacer::Mode::Target: return "target";
+        default: return "uncapped";
+        }
+    }
+}
+
+int FramePacer::parseArgument(Pacer& pacer, int argc, char** argv, int i) {
+    const std::string_view argument = argv[i];
+    if (argument == "--vsync") {
+        pacer.mode = Mode::Vsync;
+        return 1;
+    }
+    if (argument == "--uncapped") {
+        pacer.mode = Mode::Uncapped;
+        return 1;
+    }
+    if (argument == "--fps" && i + 1 < argc) {
+        pacer.mode = Mode::Target;
+        pacer.targetFps = std::max(atof(argv[i + 1]), 1.0);
+        return 2;
+    }
+    return 0;
+}
+
+void FramePacer::begin(Pacer& pacer) {
+    glfwSwapInterval(pacer.mode == Mode::Vsync ? 1 : 0);
+#ifdef _WIN32
+    // the default 15.6 ms scheduler tick would make every sleep miss
+    if (pacer.mode == Mode::Target)
+        timeBeginPeriod(1);
+#endif
+    pacer.started = false;
+    pacer.stats = Stats();
+}
+
+void FramePacer::wait(Pacer& pacer) {
+    if (pacer.mode != Mode::Target)
+        return;
+
+    Clock::time_point now = Clock::now();
+    if (!pacer.started) {
+        pacer.deadline = now;
+        return;
+    }
+
+    pacer.deadline += period(pacer);
+    if (now > pacer.deadline) {
+        // too late already, start counting again from here instead of rushing to catch up
+        pacer.stats.missed++;
+        pacer.deadline = now;
+        return;
+    }
+
+    const Clock::duration margin = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(pacer.sleepMarginMs));
+    if (pacer.deadline - now > margin) {
+        const Clock::time_point sleepUntil = pacer.deadline - margin;
+        std::this_thread::sleep_until(sleepUntil);
+        // grow straight away when a sleep overshoots, shrink back slowly
+        const double overshootMs = milliseconds(Clock::now() - sleepUntil);
+        pacer.sleepMarginMs = std::clamp(std::max(pacer.sleepMarginMs * 0.98, overshootMs * 1.25 + 0.05), 0.25, 8.0);
+    }
+
+    while (Clock::now() < pacer.deadline)
+        std::this_thread::yield();
+
+    const double errorMs = milliseconds(Clock::now() - pacer.deadline);
+    pacer.stats.waits++;
+    pacer.stats.waitErrorSum += errorMs;
+    pacer.stats.worstWaitErrorMs = std::max(pacer.stats.worstWaitErrorMs, errorMs);
+}
+
+void FramePacer::presented(Pacer& pacer) {
+    const Clock::time_point now = Clock::now();
+    if (pacer.started) {
+        const double intervalMs = milliseconds(now - pacer.lastPresent);
+        pacer.stats.frames++;
+        pacer.stats.intervalSum += intervalMs;
+        pacer.stats.intervalSquares += intervalMs * intervalMs;
+        pacer.stats.worstIntervalMs = std::max(pacer.stats.worstIntervalMs, intervalMs);
+    }
+    pacer.lastPresent = now;
+    pacer.started = true;
+}
+
+void FramePacer::end([[maybe_unused]] Pacer& pacer) {
+#ifdef _WIN32
+    if (pacer.mode == Mode::Target)
+        timeEndPeriod(1);
+#endif
+}
+
+void FramePacer::printStats(const Pacer& pacer) {
+    const Stats& stats = pacer.stats;
+    std::cout << "Frame pacing (" << modeName(pacer.mode);
+    if (pacer.mode == Mode::Target)
+        std::cout << " " << pacer.targetFps << " fps";
+    std::cout << "): ";
+    if (stats.frames == 0) {
+        std::cout << "no frames" << std::endl;
+        return;
+    }
+
+    const double mean = stats.intervalSum / stats.frames;
+    const double jitter = std::sqrt(std::max(stats.intervalSquares / stats.frames - mean * mean, 0.0));
+    std::cout << stats.frames << " frames, " << mean << " ms average (" << 1000.0 / mean << " fps), jitter " << jitter
+              << " ms, worst " << stats.worstIntervalMs << " ms";
+    if (pacer.mode == Mode::Target)
+        std::cout << ", wait error " << (stats.waits > 0 ? stats.waitErrorSum / stats.waits : 0.0) << " ms average, "
+                  << stats.worstWaitErrorMs << " ms worst, " << stats.missed << " missed";
+    std::cout << std::endl;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <chrono>
+
+// Decides when a frame is presented. Vsync leaves it to the swap interval,
+// Target paces to a fixed rate on the CPU, Uncapped presents as soon as a
+// frame is done (for benchmarking). Waiting sleeps for most of the gap and
+// spins the rest; the sleep stops early by how much sleeps have recently
+// overshot, so wake-up lands well within a fraction of a millisecond.
+namespace FramePacer {
+
+    using Clock = std::chrono::steady_clock;
+
+    enum class Mode { Vsync, Target, Uncapped };
+
+    struct Stats {
+        long long frames = 0;
+        long long missed = 0;           // Target frames that started after their deadline
+        double intervalSum = 0.0;       // present to present, ms
+        double intervalSquares = 0.0;
+        double worstIntervalMs = 0.0;
+        double waitErrorSum = 0.0;      // how late Target waits woke up, ms
+        double worstWaitErrorMs = 0.0;
+        long long waits = 0;
+    };
+
+    struct Pacer {
+        Mode mode = Mode::Vsync;
+        double targetFps = 60.0;
+        double sleepMarginMs = 2.0;     // adapts to the scheduler's oversleep
+        Clock::time_point deadline;
+        Clock::time_point lastPresent;
+        bool started = false;
+        Stats stats;
+    };
+
+    // Takes --vsync, --uncapped and --fps <rate>. Returns how many arguments it used.
+    int parseArgument(Pacer& pacer, int argc, char** argv, int i);
+
+    // Sets the swap interval for the mode, call with the context current
+    void begin(Pacer& pacer);
+
+    // Call right before swapping buffers. Blocks until the frame is due in Target mode.
+    void wait(Pacer& pacer);
+
+    // Call right after swapping buffers
+    void presented(Pacer& pacer);
+
+    void end(Pacer& pacer);
+
+    void printStats(const Pacer& pacer);
+}
@@ -0,0 +1,65 @@
+#include "FrameQueue.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+namespace {
+
+    double since(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+int FrameQueue::beginWrite(Queue& queue) {
+    auto start = std::chrono::steady_clock::now();
+    std::unique_lock<std::mutex> lock(queue.mutex);
+    queue.changed.wait(lock, [&]() { return queue.closed || queue.published - queue.released < queue.slots; });
+    const double waited = since(start);
+    queue.stats.producerWaitMs += waited;
+    queue.stats.worstProducerWaitMs = std::max(queue.stats.worstProducerWaitMs, waited);
+    return queue.closed ? -1 : int(queue.published % queue.slots);
+}
+
+void FrameQueue::endWrite(Queue& queue) {
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.published++;
+    }
+    queue.changed.notify_all();
+}
+
+int FrameQueue::beginRead(Queue& queue) {
+    auto start = std::chrono::steady_clock::now();
+    std::unique_lock<std::mutex> lock(queue.mutex);
+    queue.changed.wait(lock, [&]() { return queue.closed || queue.published > queue.released; });
+    const double waited = since(start);
+    queue.stats.consumerWaitMs += waited;
+    queue.stats.worstConsumerWaitMs = std::max(queue.stats.worstConsumerWaitMs, waited);
+    return queue.closed ? -1 : int(queue.released % queue.slots);
+}
+
+void FrameQueue::endRead(Queue& queue) {
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.released++;
+        queue.stats.frames++;
+    }
+    queue.changed.notify_all();
+}
+
+void FrameQueue::close(Queue& queue) {
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.closed = true;
+    }
+    queue.changed.notify_all();
+}
+
+void FrameQueue::printStats(const Queue& queue) {
+    const Stats& stats = queue.stats;
+    const double frames = double(std::max(stats.frames, 1LL));
+    std::cout << "Frame queue: " << queue.slots << " snapshots, " << stats.frames << " frames, simulation waited "
+              << stats.producerWaitMs / frames << " ms per frame (worst " << stats.worstProducerWaitMs << "), render waited "
+              << stats.consumerWaitMs / frames << " ms per frame (worst " << stats.worstConsumerWaitMs << ")" << std::endl;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+
+// Hands frame snapshots from the thread that simulates to the thread that
+// renders. The snapshots themselves live in the caller's array of `slots`
+// entries; the queue only says which one each side may touch. The producer
+// can run up to slots - 1 frames ahead of the snapshot being rendered and
+// blocks after that, the consumer blocks until something is published.
+// Both sides' waits are timed.
+namespace FrameQueue {
+
+    const int MaxSlots = 3;
+
+    struct Stats {
+        long long frames = 0;
+        double producerWaitMs = 0.0;
+        double consumerWaitMs = 0.0;
+        double worstProducerWaitMs = 0.0;
+        double worstConsumerWaitMs = 0.0;
+    };
+
+    struct Queue {
+        int slots = 2;
+        std::mutex mutex;
+        std::condition_variable changed;
+        long long published = 0;
+        long long released = 0;
+        bool closed = false;
+        Stats stats;
+    };
+
+    // Returns the slot to fill, or -1 once the queue is closed
+    int beginWrite(Queue& queue);
+    void endWrite(Queue& queue);
+
+    // Returns the slot to render, or -1 once the queue is closed
+    int beginRead(Queue& queue);
+    void endRead(Queue& queue);
+
+    // Wakes both sides for good
+    void close(Queue& queue);
+
+    void printStats(const Queue& queue);
+}
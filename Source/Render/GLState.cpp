@@ -0,0 +1,299 @@
+#include "GLState.h"
+
+#include <iostream>
+
+namespace {
+
+    // never a valid value of any tracked state, so the first call goes through
+    const GLuint Unknown = 0xFFFFFFFFu;
+
+    const int MaxUnits = 32;
+    const int MaxUniformBindings = 16;
+    const GLenum TrackedCaps[] = { GL_DEPTH_TEST, GL_STENCIL_TEST, GL_BLEND, GL_CULL_FACE, GL_SCISSOR_TEST };
+    const int CapCount = sizeof(TrackedCaps) / sizeof(TrackedCaps[0]);
+
+    struct Cache {
+        GLuint program;
+        GLuint vao;
+        GLuint arrayBuffer;
+        GLuint elementBuffer;   // part of the VAO, forgotten when it changes
+        GLuint uniformBuffer;
+        GLuint indirectBuffer;
+        GLuint uniformRange[MaxUniformBindings][3];    // buffer, offset, size
+        GLuint framebuffer;
+        GLuint activeUnit;
+        GLuint texture2D[MaxUnits];
+        GLuint textureCube[MaxUnits];
+        GLuint caps[CapCount];
+        GLuint depthFunc;
+        GLuint depthMask;
+        GLuint stencilFunc[3];
+        GLuint stencilOp[3];
+        GLuint stencilMask;
+        GLuint blendFunc[2];
+        GLint viewport[4];
+    };
+
+    Cache cache;
+    bool initialized = false;
+
+    GLState::Stats frame, previousFrame, overall;
+
+    void ensureInitialized() {
+        if (!initialized)
+            GLState::invalidate();
+    }
+
+    // true when the call is needed; also does the bookkeeping
+    bool changed(GLuint& cached, GLuint value) {
+        ensureInitialized();
+        if (cached == value) {
+            frame.skipped++;
+            return false;
+        }
+        cached = value;
+        frame.issued++;
+        return true;
+    }
+
+    int capIndex(GLenum cap) {
+        for (int i = 0; i < CapCount; ++i)
+            if (TrackedCaps[i] == cap)
+                return i;
+        return -1;
+    }
+
+    GLuint* textureSlot(GLuint unit, GLenum target) {
+        if (unit >= GLuint(MaxUnits))
+            return nullptr;
+        if (target == GL_TEXTURE_2D)
+            return &cache.texture2D[unit];
+        if (target == GL_TEXTURE_CUBE_MAP)
+            return &cache.textureCube[unit];
+        return nullptr;
+    }
+
+    void forget(GLuint& cached, GLuint name) {
+        if (cached == name)
+            cached = Unknown;
+    }
+}
+
+void GLState::invalidate() {
+    GLuint* words = reinterpret_cast<GLuint*>(&cache);
+    for (size_t i = 0; i < sizeof(Cache) / sizeof(GLuint); ++i)
+        words[i] = Unknown;
+    initialized = true;
+}
+
+void GLState::useProgram(GLuint program) {
+    if (changed(cache.program, program))
+        glUseProgram(program);
+}
+
+void GLState::bindVertexArray(GLuint vao) {
+    if (changed(cache.vao, vao)) {
+        glBindVertexArray(vao);
+        cache.elementBuffer = Unknown;
+    }
+}
+
+void GLState::bindBuffer(GLenum target, GLuint buffer) {
+    GLuint* slot = target == GL_ARRAY_BUFFER ? &cache.arrayBuffer
+                 : target == GL_ELEMENT_ARRAY_BUFFER ? &cache.elementBuffer
+                 : target == GL_UNIFORM_BUFFER ? &cache.uniformBuffer
+                 : target == GL_DRAW_INDIRECT_BUFFER ? &cache.indirectBuffer
+                 : nullptr;
+    if (!slot) {
+        frame.issued++;
+        glBindBuffer(target, buffer);
+    } else if (changed(*slot, buffer)) {
+        glBindBuffer(target, buffer);
+    }
+}
+
+void GLState::bindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size) {
+    ensureInitialized();
+    if (target == GL_UNIFORM_BUFFER && index < GLuint(MaxUniformBindings)) {
+        GLuint* range = cache.uniformRange[index];
+        if (range[0] == buffer && range[1] == GLuint(offset) && range[2] == GLuint(size)) {
+            frame.skipped++;
+            return;
+        }
+        range[0] = buffer;
+        range[1] = GLuint(offset);
+        range[2] = GLuint(size);
+        cache.uniformBuffer = buffer;
+    } else if (target == GL_UNIFORM_BUFFER) {
+        cache.uniformBuffer = buffer;
+    }
+    frame.issued++;
+    glBindBufferRange(target, index, buffer, offset, size);
+}
+
+void GLState::bindFramebuffer(GLuint framebuffer) {
+    if (changed(cache.framebuffer, framebuffer))
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+}
+
+void GLState::bindTexture(GLuint unit, GLenum target, GLuint texture) {
+    ensureInitialized();
+    GLuint* slot = textureSlot(unit, target);
+    if (slot && *slot == texture) {
+        frame.skipped++;
+        return;
+    }
+    if (changed(cache.activeUnit, unit))
+        glActiveTexture(GL_TEXTURE0 + unit);
+    if (slot)
+        *slot = texture;
+    frame.issued++;
+    glBindTexture(target, texture);
+}
+
+void GLState::enable(GLenum cap) {
+    int index = capIndex(cap);
+    if (index < 0) {
+        frame.issued++;
+        glEnable(cap);
+    } else if (changed(cache.caps[index], GL_TRUE)) {
+        glEnable(cap);
+    }
+}
+
+void GLState::disable(GLenum cap) {
+    int index = capIndex(cap);
+    if (index < 0) {
+        frame.issued++;
+        glDisable(cap);
+    } else if (changed(cache.caps[index], GL_FALSE)) {
+        glDisable(cap);
+    }
+}
+
+void GLState::depthFunc(GLenum func) {
+    if (changed(cache.depthFunc, func))
+        glDepthFunc(func);
+}
+
+void GLState::depthMask(GLboolean flag) {
+    if (changed(cache.depthMask, flag))
+        glDepthMask(flag);
+}
+
+void GLState::stencilFunc(GLenum func, GLint ref, GLuint mask) {
+    ensureInitialized();
+    if (cache.stencilFunc[0] == func && cache.stencilFunc[1] == GLuint(ref) && cache.stencilFunc[2] == mask) {
+        frame.skipped++;
+        return;
+    }
+    cache.stencilFunc[0] = func;
+    cache.stencilFunc[1] = GLuint(ref);
+    cache.stencilFunc[2] = mask;
+    frame.issued++;
+    glStencilFunc(func, ref, mask);
+}
+
+void GLState::stencilOp(GLenum fail, GLenum depthFail, GLenum depthPass) {
+    ensureInitialized();
+    if (cache.stencilOp[0] == fail && cache.stencilOp[1] == depthFail && cache.stencilOp[2] == depthPass) {
+        frame.skipped++;
+        return;
+    }
+    cache.stencilOp[0] = fail;
+    cache.stencilOp[1] = depthFail;
+    cache.stencilOp[2] = depthPass;
+    frame.issued++;
+    glStencilOp(fail, depthFail, depthPass);
+}
+
+void GLState::stencilMask(GLuint mask) {
+    if (changed(cache.stencilMask, mask))
+        glStencilMask(mask);
+}
+
+void GLState::blendFunc(GLenum source, GLenum destination) {
+    ensureInitialized();
+    if (cache.blendFunc[0] == source && cache.blendFunc[1] == destination) {
+        frame.skipped++;
+        return;
+    }
+    cache.blendFunc[0] = source;
+    cache.blendFunc[1] = destination;
+    frame.issued++;
+    glBlendFunc(source, destination);
+}
+
+void GLState::viewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+    ensureInitialized();
+    if (cache.viewport[0] == x && cache.viewport[1] == y && cache.viewport[2] == width && cache.viewport[3] == height) {
+        frame.skipped++;
+        return;
+    }
+    cache.viewport[0] = x;
+    cache.viewport[1] = y;
+    cache.viewport[2] = width;
+    cache.viewport[3] = height;
+    frame.issued++;
+    glViewport(x, y, width, height);
+}
+
+void GLState::deleteProgram(GLuint program) {
+    forget(cache.program, program);
+    glDeleteProgram(program);
+}
+
+void GLState::deleteVertexArrays(GLsizei count, const GLuint* vaos) {
+    for (GLsizei i = 0; i < count; ++i)
+        forget(cache.vao, vaos[i]);
+    glDeleteVertexArrays(count, vaos);
+}
+
+void GLState::deleteBuffers(GLsizei count, const GLuint* buffers) {
+    for (GLsizei i = 0; i < count; ++i) {
+        forget(cache.arrayBuffer, buffers[i]);
+        forget(cache.elementBuffer, buffers[i]);
+        forget(cache.uniformBuffer, buffers[i]);
+        forget(cache.indirectBuffer, buffers[i]);
+        for (int index = 0; index < MaxUniformBindings; ++index)
+            forget(cache.uniformRange[index][0], buffers[i]);
+    }
+    glDeleteBuffers(count, buffers);
+}
+
+void GLState::deleteFramebuffers(GLsizei count, const GLuint* framebuffers) {
+    for (GLsizei i = 0; i < count; ++i)
+        forget(cache.framebuffer, framebuffers[i]);
+    glDeleteFramebuffers(count, framebuffers);
+}
+
+void GLState::deleteTextures(GLsizei count, const GLuint* textures) {
+    for (GLsizei i = 0; i < count; ++i) {
+        for (int unit = 0; unit < MaxUnits; ++unit) {
+            forget(cache.texture2D[unit], textures[i]);
+            forget(cache.textureCube[unit], textures[i]);
+        }
+    }
+    glDeleteTextures(count, textures);
+}
+
+void GLState::endFrame() {
+    previousFrame = frame;
+    overall.issued += frame.issued;
+    overall.skipped += frame.skipped;
+    frame = Stats();
+}
+
+const GLState::Stats& GLState::lastFrame() {
+    return previousFrame;
+}
+
+const GLState::Stats& GLState::total() {
+    return overall;
+}
+
+void GLState::printStats() {
+    const long long calls = overall.issued + overall.skipped;
+    std::cout << "GL state: " << previousFrame.issued << " issued, " << previousFrame.skipped << " skipped last frame, "
+              << (calls > 0 ? overall.skipped * 100 / calls : 0) << "% skipped overall" << std::endl;
+}
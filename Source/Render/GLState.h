@@ -0,0 +1,50 @@
+#pragma once
+
+#include <GL/glew.h>
+
+// Shadow copy of the GL state the frame loop touches. Every setter compares
+// against what was last set and only calls into the driver on a change.
+// Calls made behind its back leave the copy stale: call invalidate() after
+// any code that binds or enables things directly (loaders, setup code).
+namespace GLState {
+
+    struct Stats {
+        long long issued = 0;
+        long long skipped = 0;
+    };
+
+    // Forget everything, the next call of each kind always goes through
+    void invalidate();
+
+    void useProgram(GLuint program);
+    void bindVertexArray(GLuint vao);
+    void bindBuffer(GLenum target, GLuint buffer);
+    // Also moves the generic binding of target, like GL does
+    void bindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size);
+    void bindFramebuffer(GLuint framebuffer);
+    // Selects the unit only when a bind is actually needed
+    void bindTexture(GLuint unit, GLenum target, GLuint texture);
+
+    void enable(GLenum cap);
+    void disable(GLenum cap);
+    void depthFunc(GLenum func);
+    void depthMask(GLboolean flag);
+    void stencilFunc(GLenum func, GLint ref, GLuint mask);
+    void stencilOp(GLenum fail, GLenum depthFail, GLenum depthPass);
+    void stencilMask(GLuint mask);
+    void blendFunc(GLenum source, GLenum destination);
+    void viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+
+    // Deleted names can be handed out again, so drop them from the copy
+    void deleteProgram(GLuint program);
+    void deleteVertexArrays(GLsizei count, const GLuint* vaos);
+    void deleteBuffers(GLsizei count, const GLuint* buffers);
+    void deleteFramebuffers(GLsizei count, const GLuint* framebuffers);
+    void deleteTextures(GLsizei count, const GLuint* textures);
+
+    // Rolls the per-frame counters over, call once per frame
+    void endFrame();
+    const Stats& lastFrame();
+    const Stats& total();
+    void printStats();
+}
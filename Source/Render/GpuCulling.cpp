@@ -0,0 +1,215 @@
+#include "GpuCulling.h"
+
+#include "GLState.h"
+#include "../Shader/ShaderProgram.h"
+#include "../Shader/VertexShaderStrings.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace {
+
+    const GLuint CullGroupSize = 64;
+    const GLuint HiZGroupSize = 8;
+
+    GLuint groups(int size, GLuint groupSize) {
+        return (GLuint(size) + groupSize - 1) / groupSize;
+    }
+
+    // Takes the oldest draw count if the GPU is done with it, never waits
+    void collectReadback(GpuCulling::Culler& culler) {
+        const int slot = culler.readbackIndex;
+        if (!culler.fences[slot])
+            return;
+        const GLenum status = glClientWaitSync(culler.fences[slot], 0, 0);
+        if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED) {
+            GLuint drawn = 0;
+            glBindBuffer(GL_COPY_READ_BUFFER, culler.readback[slot]);
+            glGetBufferSubData(GL_COPY_READ_BUFFER, 0, sizeof(drawn), &drawn);
+            culler.stats.drawn += drawn;
+            culler.stats.readFrames++;
+            culler.stats.lastDrawn = drawn;
+        }
+        glDeleteSync(culler.fences[slot]);
+        culler.fences[slot] = 0;
+    }
+}
+
+bool GpuCulling::create(Culler& culler, const ShaderStruct& shaders) {
+    if (!GLEW_VERSION_4_3) {
+        std::cout << "ERROR::GPU_CULLING::NO_COMPUTE_SHADERS\nneeds GL 4.3" << std::endl;
+        return false;
+    }
+    if (!createComputeProgram(shaders.hiZComputeSource, culler.hiZShader, culler.hiZProgram) ||
+        !createComputeProgram(shaders.cullComputeSource, culler.cullShader, culler.cullProgram)) {
+        std::cout << "ERROR::GPU_CULLING::PROGRAM_FAILED" << std::endl;
+        return false;
+    }
+
+    glUseProgram(culler.hiZProgram);
+    glUniform1i(glGetUniformLocation(culler.hiZProgram, "source"), 0);
+    culler.uniSourceLevel = glGetUniformLocation(culler.hiZProgram, "sourceLevel");
+
+    glUseProgram(culler.cullProgram);
+    glUniform1i(glGetUniformLocation(culler.cullProgram, "pyramid"), 0);
+    culler.uniFirstInstance = glGetUniformLocation(culler.cullProgram, "firstInstance");
+    culler.uniInstanceCount = glGetUniformLocation(culler.cullProgram, "instanceCount");
+    culler.uniIndexCount = glGetUniformLocation(culler.cullProgram, "indexCount");
+    culler.uniFirstIndex = glGetUniformLocation(culler.cullProgram, "firstIndex");
+    culler.uniBaseVertex = glGetUniformLocation(culler.cullProgram, "baseVertex");
+    culler.uniBoundsCenter = glGetUniformLocation(culler.cullProgram, "boundsCenter");
+    culler.uniBoundsExtents = glGetUniformLocation(culler.cullProgram, "boundsExtents");
+    culler.uniViewProj = glGetUniformLocation(culler.cullProgram, "viewProj");
+    culler.uniOcclusion = glGetUniformLocation(culler.cullProgram, "occlusion");
+    culler.uniPyramidViewProj = glGetUniformLocation(culler.cullProgram, "pyramidViewProj");
+
+    const GLuint zero = 0;
+    glGenBuffers(1, &culler.drawCount);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, culler.drawCount);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(zero), &zero, GL_DYNAMIC_COPY);
+    glGenBuffers(1, &culler.commands);
+
+    glGenBuffers(Readbacks, culler.readback);
+    for (GLuint buffer : culler.readback) {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, sizeof(zero), &zero, GL_STREAM_READ);
+    }
+
+    culler.indirectCount = GLEW_VERSION_4_6 || GLEW_ARB_indirect_parameters;
+    culler.supported = true;
+    return true;
+}
+
+void GpuCulling::cull(Culler& culler, GLuint instanceBuffer, GLuint firstInstance, GLuint count, const DrawBatch::Mesh& mesh,
+                      const glm::vec3& boundsCenter, const glm::vec3& boundsExtents, const glm::mat4& viewProj) {
+    culler.lastCount = 0;
+    if (!culler.supported || count == 0)
+        return;
+    collectReadback(culler);
+
+    if (count > culler.capacity) {
+        culler.capacity = std::max(count, culler.capacity * 2);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, culler.commands);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, culler.capacity * sizeof(DrawBatch::Command), nullptr, GL_DYNAMIC_COPY);
+    }
+
+    // the count starts over; without a count parameter the whole range is
+    // drawn, so every slot past the survivors has to be an empty draw
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, culler.drawCount);
+    glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+    if (!culler.indirectCount) {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, culler.commands);
+        glClearBufferSubData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, 0, count * sizeof(DrawBatch::Command), GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+    }
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, instanceBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, culler.commands);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, culler.drawCount);
+
+    GLState::useProgram(culler.cullProgram);
+    glUniform1ui(culler.uniFirstInstance, firstInstance);
+    glUniform1ui(culler.uniInstanceCount, count);
+    glUniform1ui(culler.uniIndexCount, mesh.indexCount);
+    glUniform1ui(culler.uniFirstIndex, mesh.firstIndex);
+    glUniform1i(culler.uniBaseVertex, mesh.baseVertex);
+    glUniform3f(culler.uniBoundsCenter, boundsCenter.x, boundsCenter.y, boundsCenter.z);
+    glUniform3f(culler.uniBoundsExtents, boundsExtents.x, boundsExtents.y, boundsExtents.z);
+    glUniformMatrix4fv(culler.uniViewProj, 1, GL_FALSE, &viewProj[0][0]);
+    glUniform1i(culler.uniOcclusion, culler.pyramidValid ? 1 : 0);
+    if (culler.pyramidValid) {
+        glUniformMatrix4fv(culler.uniPyramidViewProj, 1, GL_FALSE, &culler.pyramidViewProj[0][0]);
+        GLState::bindTexture(0, GL_TEXTURE_2D, culler.pyramid);
+    }
+    glDispatchCompute(groups(int(count), CullGroupSize), 1, 1);
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+
+    // how many survived, read back a few frames from now
+    const int slot = culler.readbackIndex;
+    glBindBuffer(GL_COPY_READ_BUFFER, culler.drawCount);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, culler.readback[slot]);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, sizeof(GLuint));
+    culler.fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    culler.readbackIndex = (slot + 1) % Readbacks;
+
+    culler.lastCount = count;
+    culler.stats.frames++;
+    culler.stats.instances += count;
+}
+
+void GpuCulling::draw(Culler& culler) {
+    if (culler.lastCount == 0)
+        return;
+    GLState::bindBuffer(GL_DRAW_INDIRECT_BUFFER, culler.commands);
+    if (!culler.indirectCount) {
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, GLsizei(culler.lastCount), 0);
+        return;
+    }
+    GLState::bindBuffer(GL_PARAMETER_BUFFER_ARB, culler.drawCount);
+    if (GLEW_VERSION_4_6)
+        glMultiDrawElementsIndirectCount(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, 0, GLsizei(culler.lastCount), 0);
+    else
+        glMultiDrawElementsIndirectCountARB(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, 0, GLsizei(culler.lastCount), 0);
+}
+
+void GpuCulling::buildPyramid(Culler& culler, GLuint depthTexture, int width, int height, const glm::mat4& viewProj) {
+    if (!culler.supported || width <= 0 || height <= 0)
+        return;
+
+    if (width != culler.pyramidWidth || height != culler.pyramidHeight) {
+        if (culler.pyramid)
+            GLState::deleteTextures(1, &culler.pyramid);
+        culler.pyramidWidth = width;
+        culler.pyramidHeight = height;
+        culler.pyramidLevels = 1 + int(std::floor(std::log2(float(std::max(width, height)))));
+        glGenTextures(1, &culler.pyramid);
+        GLState::bindTexture(0, GL_TEXTURE_2D, culler.pyramid);
+        glTexStorage2D(GL_TEXTURE_2D, culler.pyramidLevels, GL_R32F, width, height);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    }
+
+    // level 0 copies the depth, every level after reads the one before it
+    GLState::useProgram(culler.hiZProgram);
+    for (int level = 0; level < culler.pyramidLevels; ++level) {
+        GLState::bindTexture(0, GL_TEXTURE_2D, level == 0 ? depthTexture : culler.pyramid);
+        glUniform1i(culler.uniSourceLevel, level == 0 ? 0 : level - 1);
+        glBindImageTexture(0, culler.pyramid, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+        glDispatchCompute(groups(std::max(1, width >> level), HiZGroupSize), groups(std::max(1, height >> level), HiZGroupSize), 1);
+        glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+    }
+
+    culler.pyramidViewProj = viewProj;
+    culler.pyramidValid = true;
+}
+
+void GpuCulling::printStats(const Culler& culler) {
+    const Stats& stats = culler.stats;
+    if (stats.frames == 0 || stats.readFrames == 0)
+        return;
+    std::cout << "GPU culling: " << stats.drawn / stats.readFrames << " of " << stats.instances / stats.frames
+              << " instances drawn per frame (" << (culler.indirectCount ? "indirect count" : "cleared command buffer")
+              << ", Hi-Z " << culler.pyramidWidth << "x" << culler.pyramidHeight << " with " << culler.pyramidLevels << " levels)" << std::endl;
+}
+
+void GpuCulling::destroy(Culler& culler) {
+    for (GLsync& fence : culler.fences) {
+        if (fence)
+            glDeleteSync(fence);
+        fence = 0;
+    }
+    if (culler.supported) {
+        GLState::deleteBuffers(Readbacks, culler.readback);
+        GLState::deleteBuffers(1, &culler.commands);
+        GLState::deleteBuffers(1, &culler.drawCount);
+    }
+    if (culler.pyramid)
+        GLState::deleteTextures(1, &culler.pyramid);
+    if (culler.hiZProgram)
+        GLState::deleteProgram(culler.hiZProgram);
+    if (culler.cullProgram)
+        GLState::deleteProgram(culler.cullProgram);
+    glDeleteShader(culler.hiZShader);
+    glDeleteShader(culler.cullShader);
+    culler = Culler();
+}
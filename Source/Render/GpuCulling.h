@@ -0,0 +1,80 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "DrawBatch.h"
+
+struct ShaderStruct;
+
+// GPU driven culling for instance rows that already sit in a GL buffer.
+// A compute pass tests each instance's bounds against the frustum and a
+// Hi-Z pyramid, and every survivor appends its own draw command. The CPU
+// never learns the count: draw() uses glMultiDrawElementsIndirectCount
+// where GL 4.6 or ARB_indirect_parameters has it, otherwise the command
+// buffer is cleared to zero-instance draws first and drawn at full size.
+//
+// The pyramid holds the farthest depth per texel of the frame before,
+// built with a second compute pass once the opaque draws are done, and is
+// tested with that frame's camera. Needs GL 4.3 compute shaders.
+namespace GpuCulling {
+
+    // Draws read back a couple of frames late, so nothing waits on the GPU
+    const int Readbacks = 3;
+
+    struct Stats {
+        long long frames = 0;
+        long long instances = 0;
+        long long drawn = 0;            // over the frames read back
+        long long readFrames = 0;
+        GLuint lastDrawn = 0;
+    };
+
+    struct Culler {
+        bool supported = false;
+        bool indirectCount = false;
+
+        GLuint hiZShader = 0, hiZProgram = 0;
+        GLuint cullShader = 0, cullProgram = 0;
+        GLint uniSourceLevel = -1;
+        GLint uniFirstInstance = -1, uniInstanceCount = -1;
+        GLint uniIndexCount = -1, uniFirstIndex = -1, uniBaseVertex = -1;
+        GLint uniBoundsCenter = -1, uniBoundsExtents = -1, uniViewProj = -1;
+        GLint uniOcclusion = -1, uniPyramidViewProj = -1;
+
+        // Hi-Z, R32F with a full mip chain
+        GLuint pyramid = 0;
+        int pyramidWidth = 0, pyramidHeight = 0, pyramidLevels = 0;
+        glm::mat4 pyramidViewProj = glm::mat4(1.0f);
+        bool pyramidValid = false;
+
+        GLuint commands = 0;            // DrawBatch::Command per visible instance
+        GLuint drawCount = 0;
+        GLuint capacity = 0;
+        GLuint lastCount = 0;           // instances tested by the last cull()
+
+        GLuint readback[Readbacks] = {};
+        GLsync fences[Readbacks] = {};
+        int readbackIndex = 0;
+
+        Stats stats;
+    };
+
+    // Returns false, and leaves the culler unsupported, without compute shaders
+    bool create(Culler& culler, const ShaderStruct& shaders);
+
+    // Tests count rows of DrawBatch::Instance from firstInstance on, all
+    // drawn with mesh. boundsCenter/Extents is the mesh's own box.
+    void cull(Culler& culler, GLuint instanceBuffer, GLuint firstInstance, GLuint count, const DrawBatch::Mesh& mesh,
+              const glm::vec3& boundsCenter, const glm::vec3& boundsExtents, const glm::mat4& viewProj);
+
+    // Draws what the last cull() kept with the bound program and VAO
+    void draw(Culler& culler);
+
+    // Builds the pyramid from a depth texture rendered with viewProj, for
+    // the next frame's cull()
+    void buildPyramid(Culler& culler, GLuint depthTexture, int width, int height, const glm::mat4& viewProj);
+
+    void printStats(const Culler& culler);
+    void destroy(Culler& culler);
+}
@@ -0,0 +1,74 @@
+#include "OcclusionQuery.h"
+
+#include <iostream>
+
+namespace {
+
+    // Counts the slot's old result if it is there, never waits for it
+    void collect(OcclusionQuery::Query& query, int slot) {
+        if (!query.issued[slot])
+            return;
+        query.issued[slot] = false;
+
+        GLint available = 0;
+        glGetQueryObjectiv(query.queries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+            return;
+
+        GLuint samples = 0;
+        glGetQueryObjectuiv(query.queries[slot], GL_QUERY_RESULT, &samples);
+        query.stats.read++;
+        if (samples == 0)
+            query.stats.hidden++;
+    }
+}
+
+void OcclusionQuery::create(Query& query) {
+    query.supported = GLEW_VERSION_3_0;
+    if (!query.supported)
+        return;
+    // any sample is all the condition needs, and can stop counting early
+    query.target = GLEW_VERSION_3_3 || GLEW_ARB_occlusion_query2 ? GL_ANY_SAMPLES_PASSED : GL_SAMPLES_PASSED;
+    glGenQueries(Latency, query.queries);
+}
+
+void OcclusionQuery::begin(Query& query) {
+    if (!query.supported)
+        return;
+    collect(query, query.index);
+    glBeginQuery(query.target, query.queries[query.index]);
+}
+
+void OcclusionQuery::end(Query& query) {
+    if (!query.supported)
+        return;
+    glEndQuery(query.target);
+    query.issued[query.index] = true;
+    query.last = query.index;
+    query.index = (query.index + 1) % Latency;
+    query.stats.frames++;
+}
+
+void OcclusionQuery::beginConditional(const Query& query) {
+    if (query.supported && query.last >= 0)
+        glBeginConditionalRender(query.queries[query.last], GL_QUERY_NO_WAIT);
+}
+
+void OcclusionQuery::endConditional(const Query& query) {
+    if (query.supported && query.last >= 0)
+        glEndConditionalRender();
+}
+
+void OcclusionQuery::printStats(const Query& query, const char* name) {
+    const Stats& stats = query.stats;
+    if (stats.frames == 0)
+        return;
+    std::cout << name << ": skipped in " << stats.hidden << " of " << stats.read << " frames read back ("
+              << stats.frames << " queried, " << (query.target == GL_ANY_SAMPLES_PASSED ? "any samples" : "sample count") << ")" << std::endl;
+}
+
+void OcclusionQuery::destroy(Query& query) {
+    if (query.supported)
+        glDeleteQueries(Latency, query.queries);
+    query = Query();
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <GL/glew.h>
+
+// Hardware occlusion query around a cheap draw that decides whether some
+// expensive draws are worth doing, e.g. a mirror's surface and the scene
+// it reflects. The expensive draws go between beginConditional() and
+// endConditional() and the GPU drops them when the query passed no
+// samples, without the CPU ever waiting: GL_QUERY_NO_WAIT draws anyway
+// when the result isn't ready yet.
+//
+// The results are read back from a ring a few frames late, only to count
+// how often the draws were skipped.
+namespace OcclusionQuery {
+
+    const int Latency = 3;
+
+    struct Stats {
+        long long frames = 0;
+        long long read = 0;             // results that were ready when polled
+        long long hidden = 0;           // of those, no samples passed
+    };
+
+    struct Query {
+        GLuint queries[Latency] = {};
+        bool issued[Latency] = {};
+        int index = 0;                  // slot the next begin() uses
+        int last = -1;                  // slot of the last end()
+        GLenum target = GL_SAMPLES_PASSED;
+        bool supported = false;
+        Stats stats;
+    };
+
+    void create(Query& query);
+
+    void begin(Query& query);
+    void end(Query& query);
+
+    // Draws in between only happen if the last ended query passed samples
+    void beginConditional(const Query& query);
+    void endConditional(const Query& query);
+
+    void printStats(const Query& query, const char* name);
+    void destroy(Query& query);
+}
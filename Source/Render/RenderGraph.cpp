@@ -0,0 +1,452 @@
+#include "RenderGraph.h"
+#include "GLState.h"
+
+#include <algorithm>
+#include <iostream>
+
+namespace {
+
+    bool isDepthStencil(GLenum internalFormat) {
+        return internalFormat == GL_DEPTH24_STENCIL8 || internalFormat == GL_DEPTH32F_STENCIL8;
+    }
+
+    bool isDepth(GLenum internalFormat) {
+        return internalFormat == GL_DEPTH_COMPONENT16 || internalFormat == GL_DEPTH_COMPONENT24
+            || internalFormat == GL_DEPTH_COMPONENT32F;
+    }
+
+    // drivers pad three channel formats to four
+    size_t bytesPerPixel(GLenum internalFormat) {
+        switch (internalFormat) {
+        case GL_R8: return 1;
+        case GL_RG8: case GL_R16F: case GL_DEPTH_COMPONENT16: return 2;
+        case GL_RGB16F: case GL_RGBA16F: case GL_DEPTH32F_STENCIL8: return 8;
+        case GL_RGB32F: case GL_RGBA32F: return 16;
+        default: return 4;
+        }
+    }
+}
+
+size_t RenderGraph::byteSize(const TextureDesc& desc) {
+    return size_t(desc.width) * desc.height * bytesPerPixel(desc.internalFormat);
+}
+
+// ResourcePool
+
+void RenderGraph::ResourcePool::clear() {
+    for (int i = 0; i < int(objects.size()); ++i)
+        destroy(i);
+    objects.clear();
+}
+
+size_t RenderGraph::ResourcePool::allocatedBytes() const {
+    size_t bytes = 0;
+    for (const Object& object : objects)
+        if (object.name)
+            bytes += byteSize(object.desc);
+    return bytes;
+}
+
+void RenderGraph::ResourcePool::beginFrame() {
+    for (Object& object : objects) {
+        object.inUse = false;
+        object.usedThisFrame = false;
+    }
+}
+
+void RenderGraph::ResourcePool::endFrame() {
+    for (int i = 0; i < int(objects.size()); ++i) {
+        Object& object = objects[i];
+        if (!object.name)
+            continue;
+        object.idleFrames = object.usedThisFrame ? 0 : object.idleFrames + 1;
+        if (object.idleFrames > maxIdleFrames)
+            destroy(i);
+    }
+}
+
+int RenderGraph::ResourcePool::acquire(const TextureDesc& desc) {
+    int freeSlot = -1;
+    for (int i = 0; i < int(objects.size()); ++i) {
+        Object& object = objects[i];
+        if (object.name && !object.inUse && object.desc == desc) {
+            object.inUse = true;
+            object.usedThisFrame = true;
+            return i;
+        }
+        if (!object.name && freeSlot < 0)
+            freeSlot = i;
+    }
+
+    if (freeSlot < 0) {
+        freeSlot = int(objects.size());
+        objects.emplace_back();
+    }
+
+    Object& object = objects[freeSlot];
+    object.desc = desc;
+    object.inUse = true;
+    object.usedThisFrame = true;
+    object.idleFrames = 0;
+
+    if (desc.renderbuffer) {
+        glGenRenderbuffers(1, &object.name);
+        glBindRenderbuffer(GL_RENDERBUFFER, object.name);
+        glRenderbufferStorage(GL_RENDERBUFFER, desc.internalFormat, desc.width, desc.height);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    } else {
+        glGenTextures(1, &object.name);
+        GLState::bindTexture(0, GL_TEXTURE_2D, object.name);
+        if (GLEW_ARB_texture_storage) {
+            glTexStorage2D(GL_TEXTURE_2D, 1, desc.internalFormat, desc.width, desc.height);
+        } else {
+            GLenum format = isDepthStencil(desc.internalFormat) ? GL_DEPTH_STENCIL : isDepth(desc.internalFormat) ? GL_DEPTH_COMPONENT : GL_RGBA;
+            GLenum type = isDepthStencil(desc.internalFormat) ? GL_UNSIGNED_INT_24_8 : isDepth(desc.internalFormat) ? GL_FLOAT : GL_UNSIGNED_BYTE;
+            glTexImage2D(GL_TEXTURE_2D, 0, desc.internalFormat, desc.width, desc.height, 0, format, type, NULL);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+        }
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
+
+    return freeSlot;
+}
+
+GLuint RenderGraph::ResourcePool::framebuffer(const std::vector<int>& key) {
+    auto found = framebuffers.find(key);
+    if (found != framebuffers.end())
+        return found->second;
+
+    GLuint fbo;
+    glGenFramebuffers(1, &fbo);
+    GLState::bindFramebuffer(fbo);
+
+    std::vector<GLenum> drawBuffers;
+    for (size_t i = 0; i < key.size(); i += 2) {
+        const GLenum attachment = GLenum(key[i]);
+        const Object& object = objects[key[i + 1]];
+        if (object.desc.renderbuffer)
+            glFramebufferRenderbuffer(GL_FRAMEBUFFER, attachment, GL_RENDERBUFFER, object.name);
+        else
+            glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D, object.name, 0);
+        if (attachment >= GL_COLOR_ATTACHMENT0 && attachment <= GL_COLOR_ATTACHMENT15)
+            drawBuffers.push_back(attachment);
+    }
+    if (drawBuffers.empty())
+        glDrawBuffer(GL_NONE);
+    else
+        glDrawBuffers(GLsizei(drawBuffers.size()), drawBuffers.data());
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        std::cout << "ERROR::RENDERGRAPH::INCOMPLETE_FRAMEBUFFER" << std::endl;
+
+    framebuffers[key] = fbo;
+    return fbo;
+}
+
+void RenderGraph::ResourcePool::destroy(int index) {
+    Object& object = objects[index];
+    if (!object.name)
+        return;
+
+    // FBOs referencing the object go with it
+    for (auto it = framebuffers.begin(); it != framebuffers.end();) {
+        bool references = false;
+        for (size_t i = 1; i < it->first.size(); i += 2)
+            references |= it->first[i] == index;
+        if (references) {
+            GLState::deleteFramebuffers(1, &it->second);
+            it = framebuffers.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    if (object.desc.renderbuffer)
+        glDeleteRenderbuffers(1, &object.name);
+    else
+        GLState::deleteTextures(1, &object.name);
+    object = Object();
+}
+
+// PassBuilder
+
+RenderGraph::Handle RenderGraph::PassBuilder::create(const char* name, const TextureDesc& desc) {
+    Graph::Resource resource;
+    resource.name = name;
+    resource.desc = desc;
+    resource.root = int(graph.resources.size());
+    resource.producer = pass;
+    graph.resources.push_back(resource);
+
+    Handle handle = resource.root;
+    graph.passes[pass].writes.push_back(handle);
+    return handle;
+}
+
+RenderGraph::Handle RenderGraph::PassBuilder::read(Handle handle) {
+    graph.passes[pass].reads.push_back(handle);
+    graph.passes[pass].inputs.push_back(handle);
+    return handle;
+}
+
+RenderGraph::Handle RenderGraph::PassBuilder::write(Handle handle) {
+    // the previous contents are kept, so whoever produced them has to run first
+    graph.passes[pass].inputs.push_back(handle);
+    Handle version = graph.addVersion(handle, pass);
+    graph.passes[pass].writes.push_back(version);
+    if (graph.resources[version].imported)
+        graph.passes[pass].sideEffect = true;
+    return version;
+}
+
+// PassResources
+
+GLuint RenderGraph::PassResources::texture(Handle handle) const {
+    const Graph::Resource& root = graph->resources[graph->resources[handle].root];
+    if (root.imported || root.object < 0)
+        return 0;
+    return graph->pool.objects[root.object].name;
+}
+
+// Graph
+
+RenderGraph::Handle RenderGraph::Graph::importBackbuffer(const char* name, int width, int height) {
+    Resource resource;
+    resource.name = name;
+    resource.desc.width = width;
+    resource.desc.height = height;
+    resource.root = int(resources.size());
+    resource.imported = true;
+    resources.push_back(resource);
+    return resource.root;
+}
+
+RenderGraph::Handle RenderGraph::Graph::addVersion(Handle previous, int producer) {
+    Resource version = resources[previous];
+    version.producer = producer;
+    resources.push_back(version);
+    return Handle(resources.size() - 1);
+}
+
+void RenderGraph::Graph::addPass(const char* name, std::function<void(PassBuilder&)> setup,
+                                 std::function<void(const PassResources&)> execute) {
+    Pass pass;
+    pass.name = name;
+    pass.execute = std::move(execute);
+    passes.push_back(std::move(pass));
+
+    PassBuilder builder(*this, int(passes.size() - 1));
+    setup(builder);
+    compiled = false;
+}
+
+std::vector<int> RenderGraph::Graph::sortPasses(const std::vector<bool>& live) const {
+    const int count = int(passes.size());
+    std::vector<std::vector<int>> successors(count);
+    std::vector<int> pending(count, 0);
+
+    auto addEdge = [&](int from, int to) {
+        if (from < 0 || from == to || !live[from] || !live[to])
+            return;
+        successors[from].push_back(to);
+        pending[to]++;
+    };
+
+    for (int p = 0; p < count; ++p) {
+        for (Handle input : passes[p].inputs)
+            addEdge(resources[input].producer, p);
+    }
+    // a write replaces the version it was given, so every other reader of that
+    // version has to finish first (they share one GL object)
+    for (int p = 0; p < count; ++p) {
+        for (Handle version : passes[p].writes) {
+            for (Handle input : passes[p].inputs) {
+                if (resources[input].root != resources[version].root)
+                    continue;
+                for (int reader = 0; reader < count; ++reader) {
+                    if (reader != p && std::find(passes[reader].reads.begin(), passes[reader].reads.end(), input) != passes[reader].reads.end())
+                        addEdge(reader, p);
+                }
+            }
+        }
+    }
+
+    // Kahn's algorithm. Of the ready passes the one creating the fewest new
+    // bytes goes first, which keeps fewer attachments alive at the same time.
+    std::vector<int> ready, sorted;
+    for (int p = 0; p < count; ++p)
+        if (live[p] && pending[p] == 0)
+            ready.push_back(p);
+
+    while (!ready.empty()) {
+        auto createdBytes = [&](int p) {
+            size_t bytes = 0;
+            for (Handle write : passes[p].writes)
+                if (resources[write].root == write && !resources[write].imported)
+                    bytes += byteSize(resources[write].desc);
+            return bytes;
+        };
+        auto next = std::min_element(ready.begin(), ready.end(), [&](int a, int b) {
+            size_t bytesA = createdBytes(a), bytesB = createdBytes(b);
+            return bytesA != bytesB ? bytesA < bytesB : a < b;
+        });
+        int pass = *next;
+        ready.erase(next);
+        sorted.push_back(pass);
+        for (int successor : successors[pass])
+            if (--pending[successor] == 0)
+                ready.push_back(successor);
+    }
+
+    return sorted;
+}
+
+bool RenderGraph::Graph::compile() {
+    const int count = int(passes.size());
+
+    for (const Pass& pass : passes) {
+        bool toBackbuffer = false, toTransient = false;
+        for (Handle write : pass.writes)
+            (resources[write].imported ? toBackbuffer : toTransient) = true;
+        if (toBackbuffer && toTransient) {
+            std::cout << "ERROR::RENDERGRAPH::MIXED_BACKBUFFER_WRITE\n" << pass.name << std::endl;
+            return false;
+        }
+        for (Handle read : pass.reads) {
+            const Resource& resource = resources[read];
+            if ((resource.producer < 0 && !resource.imported) || resources[resource.root].desc.renderbuffer) {
+                std::cout << "ERROR::RENDERGRAPH::INVALID_READ\n" << pass.name << ": " << resource.name << std::endl;
+                return false;
+            }
+        }
+    }
+
+    // handles only refer to earlier passes, so one backwards sweep from the
+    // passes with side effects finds everything that contributes to them
+    std::vector<bool> live(count, false);
+    for (int p = count - 1; p >= 0; --p) {
+        if (passes[p].sideEffect)
+            live[p] = true;
+        if (!live[p])
+            continue;
+        for (Handle input : passes[p].inputs)
+            if (resources[input].producer >= 0)
+                live[resources[input].producer] = true;
+    }
+
+    frameStats = Stats();
+    frameStats.passes = count;
+    for (int p = 0; p < count; ++p) {
+        passes[p].culled = !live[p];
+        if (!live[p])
+            frameStats.culledPasses++;
+    }
+
+    order = sortPasses(live);
+
+    // lifetime of each transient root, as positions in the sorted order
+    std::vector<int> firstUse(resources.size(), -1), lastUse(resources.size(), -1);
+    for (int position = 0; position < int(order.size()); ++position) {
+        const Pass& pass = passes[order[position]];
+        auto touch = [&](Handle handle) {
+            int root = resources[handle].root;
+            if (resources[root].imported)
+                return;
+            if (firstUse[root] < 0)
+                firstUse[root] = position;
+            lastUse[root] = position;
+        };
+        for (Handle input : pass.inputs)
+            touch(input);
+        for (Handle write : pass.writes)
+            touch(write);
+    }
+
+    // hand out pool objects; a root released after its last pass is free for
+    // any later root with the same descriptor
+    pool.beginFrame();
+    for (Resource& resource : resources)
+        resource.object = -1;
+
+    for (int position = 0; position < int(order.size()); ++position) {
+        for (int root = 0; root < int(resources.size()); ++root) {
+            if (firstUse[root] == position) {
+                resources[root].object = pool.acquire(resources[root].desc);
+                frameStats.transientResources++;
+                frameStats.unaliasedBytes += byteSize(resources[root].desc);
+            }
+        }
+        for (int root = 0; root < int(resources.size()); ++root)
+            if (lastUse[root] == position)
+                pool.release(resources[root].object);
+    }
+
+    for (const ResourcePool::Object& object : pool.objects) {
+        if (object.usedThisFrame) {
+            frameStats.physicalObjects++;
+            frameStats.peakBytes += byteSize(object.desc);
+        }
+    }
+
+    // attachments, FBO and viewport per pass
+    for (int p : order) {
+        Pass& pass = passes[p];
+        std::vector<int> key;
+        int colorAttachments = 0;
+        pass.framebuffer = 0;
+        pass.width = pass.height = 0;
+        for (Handle write : pass.writes) {
+            const Resource& root = resources[resources[write].root];
+            pass.width = root.desc.width;
+            pass.height = root.desc.height;
+            if (root.imported)
+                continue;
+            GLenum attachment = isDepthStencil(root.desc.internalFormat) ? GL_DEPTH_STENCIL_ATTACHMENT
+                              : isDepth(root.desc.internalFormat) ? GL_DEPTH_ATTACHMENT
+                              : GL_COLOR_ATTACHMENT0 + colorAttachments++;
+            key.push_back(int(attachment));
+            key.push_back(root.object);
+        }
+        if (!key.empty())
+            pass.framebuffer = pool.framebuffer(key);
+    }
+
+    compiled = true;
+    return true;
+}
+
+void RenderGraph::Graph::execute() {
+    if (!compiled)
+        return;
+
+    PassResources passResources;
+    passResources.graph = this;
+
+    for (int p : order) {
+        const Pass& pass = passes[p];
+        GLState::bindFramebuffer(pass.framebuffer);
+        if (pass.width > 0)
+            GLState::viewport(0, 0, pass.width, pass.height);
+        passResources.viewportWidth = pass.width;
+        passResources.viewportHeight = pass.height;
+        pass.execute(passResources);
+    }
+
+    pool.endFrame();
+}
+
+void RenderGraph::Graph::reset() {
+    resources.clear();
+    passes.clear();
+    order.clear();
+    compiled = false;
+}
+
+void RenderGraph::Graph::printStats() const {
+    std::cout << "RenderGraph: " << frameStats.passes << " passes (" << frameStats.culledPasses << " culled), "
+              << frameStats.transientResources << " transient targets in " << frameStats.physicalObjects << " objects, "
+              << frameStats.peakBytes / 1024 << " KB vs " << frameStats.unaliasedBytes / 1024 << " KB unaliased" << std::endl;
+}
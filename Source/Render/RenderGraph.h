@@ -0,0 +1,169 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+// Frame graph for the offscreen passes. Each frame the passes are declared with
+// what they read and write, compile() culls the ones nothing depends on, orders
+// the rest and assigns every transient attachment a pooled GL object. Attachments
+// whose lifetimes don't overlap share the same object, so render-target memory
+// follows what is live at once instead of how many passes there are.
+namespace RenderGraph {
+
+    typedef int Handle;
+    const Handle InvalidHandle = -1;
+
+    struct TextureDesc {
+        int width = 0;
+        int height = 0;
+        GLenum internalFormat = GL_RGBA8;
+        bool renderbuffer = false;  // attach-only, cannot be read()
+
+        bool operator==(const TextureDesc& other) const {
+            return width == other.width && height == other.height
+                && internalFormat == other.internalFormat && renderbuffer == other.renderbuffer;
+        }
+    };
+
+    size_t byteSize(const TextureDesc& desc);
+
+    // GL objects that outlive a single frame's graph. Objects are recycled by
+    // descriptor and deleted once they go unused for a few frames (after a resize).
+    class ResourcePool {
+    public:
+        int maxIdleFrames = 3;
+
+        // Deletes every object, call while the context is still current
+        void clear();
+
+        size_t allocatedBytes() const;
+        int objectCount() const { return int(objects.size()); }
+
+    private:
+        friend class Graph;
+        friend class PassResources;
+
+        struct Object {
+            TextureDesc desc;
+            GLuint name = 0;
+            bool inUse = false;
+            bool usedThisFrame = false;
+            int idleFrames = 0;
+        };
+
+        std::vector<Object> objects;
+        // (attachment point, object index) pairs -> FBO
+        std::map<std::vector<int>, GLuint> framebuffers;
+
+        void beginFrame();
+        void endFrame();
+        int acquire(const TextureDesc& desc);
+        void release(int object) { objects[object].inUse = false; }
+        GLuint framebuffer(const std::vector<int>& key);
+        void destroy(int object);
+    };
+
+    class PassBuilder;
+
+    // What a pass sees while executing. Handles it declared map to GL names.
+    class PassResources {
+    public:
+        GLuint texture(Handle handle) const;
+        int width() const { return viewportWidth; }
+        int height() const { return viewportHeight; }
+
+    private:
+        friend class Graph;
+        const class Graph* graph = nullptr;
+        int viewportWidth = 0;
+        int viewportHeight = 0;
+    };
+
+    struct Stats {
+        int passes = 0;
+        int culledPasses = 0;
+        int transientResources = 0;
+        int physicalObjects = 0;        // objects used by this frame
+        size_t peakBytes = 0;           // attachment memory this frame actually needs
+        size_t unaliasedBytes = 0;      // what one object per resource would cost
+    };
+
+    class Graph {
+    public:
+        explicit Graph(ResourcePool& pool) : pool(pool) {}
+
+        // Default framebuffer. Passes writing it are never culled.
+        Handle importBackbuffer(const char* name, int width, int height);
+
+        void addPass(const char* name, std::function<void(PassBuilder&)> setup,
+                     std::function<void(const PassResources&)> execute);
+
+        // Returns false when a read has no producer or a write targets a renderbuffer read
+        bool compile();
+        void execute();
+
+        // Drops the passes and resources, the pool keeps its objects
+        void reset();
+
+        const Stats& stats() const { return frameStats; }
+        void printStats() const;
+
+    private:
+        friend class PassBuilder;
+        friend class PassResources;
+
+        struct Resource {
+            std::string name;
+            TextureDesc desc;
+            int root = 0;               // first version of this resource
+            int producer = -1;          // pass that writes this version
+            bool imported = false;
+            int object = -1;            // pool object, set by compile() on the root
+        };
+
+        struct Pass {
+            std::string name;
+            std::vector<Handle> reads;      // sampled
+            std::vector<Handle> writes;     // attached
+            std::vector<Handle> inputs;     // reads plus the versions the writes replace
+            std::function<void(const PassResources&)> execute;
+            bool sideEffect = false;
+            bool culled = false;
+            GLuint framebuffer = 0;
+            int width = 0;
+            int height = 0;
+        };
+
+        ResourcePool& pool;
+        std::vector<Resource> resources;
+        std::vector<Pass> passes;
+        std::vector<int> order;
+        bool compiled = false;
+        Stats frameStats;
+
+        Handle addVersion(Handle previous, int producer);
+        std::vector<int> sortPasses(const std::vector<bool>& live) const;
+    };
+
+    // Handed to a pass's setup callback to declare its attachments
+    class PassBuilder {
+    public:
+        // New transient attachment, written by this pass
+        Handle create(const char* name, const TextureDesc& desc);
+        // Sample a resource another pass wrote
+        Handle read(Handle handle);
+        // Render into an existing resource, returns its new version
+        Handle write(Handle handle);
+
+    private:
+        friend class Graph;
+        PassBuilder(Graph& graph, int pass) : graph(graph), pass(pass) {}
+        Graph& graph;
+        int pass;
+    };
+}
@@ -0,0 +1,452 @@
+#include "SoftRaster.h"
+
+#include "../Jobs/JobSystem.h"
+
+#include <SOIL.h>
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+#include <immintrin.h>
+
+namespace {
+
+    using SoftRaster::Framebuffer;
+    using SoftRaster::Renderer;
+    using SoftRaster::State;
+    using SoftRaster::Triangle;
+
+    struct ClipVertex {
+        glm::vec4 position;
+        glm::vec3 color;
+        glm::vec2 texcoord;
+    };
+
+    ClipVertex lerp(const ClipVertex& a, const ClipVertex& b, float t) {
+        return { glm::mix(a.position, b.position, t), glm::mix(a.color, b.color, t), glm::mix(a.texcoord, b.texcoord, t) };
+    }
+
+    // Keeps the part in front of the near plane, z >= -w. Returns the vertex count, 0, 3 or 4.
+    int clipNear(const ClipVertex in[3], ClipVertex out[4]) {
+        int count = 0;
+        for (int i = 0; i < 3; ++i) {
+            const ClipVertex& a = in[i];
+            const ClipVertex& b = in[(i + 1) % 3];
+            const float da = a.position.z + a.position.w;
+            const float db = b.position.z + b.position.w;
+            if (da >= 0.0f)
+                out[count++] = a;
+            if ((da >= 0.0f) != (db >= 0.0f))
+                out[count++] = lerp(a, b, da / (da - db));
+        }
+        return count;
+    }
+
+    // Returns false when the triangle covers no pixel
+    bool setup(const ClipVertex& a, const ClipVertex& b, const ClipVertex& c, int width, int height, int state, Triangle& triangle) {
+        const ClipVertex* vertices[3] = { &a, &b, &c };
+        glm::vec2 minimum(1e30f), maximum(-1e30f);
+        for (int i = 0; i < 3; ++i) {
+            const ClipVertex& vertex = *vertices[i];
+            const float invW = 1.0f / vertex.position.w;
+            const glm::vec3 ndc = glm::vec3(vertex.position) * invW;
+            triangle.position[i] = glm::vec2((ndc.x * 0.5f + 0.5f) * width, (ndc.y * 0.5f + 0.5f) * height);
+            triangle.depth[i] = ndc.z * 0.5f + 0.5f;
+            triangle.invW[i] = invW;
+            triangle.color[i] = vertex.color * invW;
+            triangle.texcoord[i] = vertex.texcoord * invW;
+            minimum = glm::min(minimum, triangle.position[i]);
+            maximum = glm::max(maximum, triangle.position[i]);
+        }
+        if (triangle.depth[0] > 1.0f && triangle.depth[1] > 1.0f && triangle.depth[2] > 1.0f)
+            return false;
+
+        // pixels whose centers can be inside
+        triangle.minX = std::max(0, int(std::ceil(minimum.x - 0.5f)));
+        triangle.minY = std::max(0, int(std::ceil(minimum.y - 0.5f)));
+        triangle.maxX = std::min(width - 1, int(std::floor(maximum.x - 0.5f)));
+        triangle.maxY = std::min(height - 1, int(std::floor(maximum.y - 0.5f)));
+        triangle.state = state;
+
+        const glm::vec2 e1 = triangle.position[1] - triangle.position[0];
+        const glm::vec2 e2 = triangle.position[2] - triangle.position[0];
+        return triangle.minX <= triangle.maxX && triangle.minY <= triangle.maxY && e1.x * e2.y - e1.y * e2.x != 0.0f;
+    }
+
+    // rounds like GL's normalized conversion
+    uint32_t pack(__m128 color) {
+        const __m128 scaled = _mm_mul_ps(_mm_min_ps(_mm_max_ps(color, _mm_setzero_ps()), _mm_set1_ps(1.0f)), _mm_set1_ps(255.0f));
+        const __m128i words = _mm_packs_epi32(_mm_cvtps_epi32(scaled), _mm_setzero_si128());
+        return uint32_t(_mm_cvtsi128_si32(_mm_packus_epi16(words, words)));
+    }
+
+    uint32_t pack(const glm::vec4& color) {
+        return pack(_mm_setr_ps(color.r, color.g, color.b, color.a));
+    }
+
+    // a * x + b * y + c over the screen, for barycentrics and interpolated values
+    struct Plane {
+        float a, b, c;
+        float at(float x, float y) const { return a * x + b * y + c; }
+    };
+
+    struct Planes {
+        Plane bary[3];
+        Plane depth;
+        Plane invW;
+        Plane attributes[5];    // color and texcoord, divided by w
+    };
+
+    Planes planesOf(const Triangle& triangle) {
+        Planes planes;
+        const glm::vec2* p = triangle.position;
+
+        // barycentric i is the edge function opposite vertex i over twice the area
+        const float area = (p[1].x - p[0].x) * (p[2].y - p[0].y) - (p[1].y - p[0].y) * (p[2].x - p[0].x);
+        const float invArea = 1.0f / area;
+        for (int i = 0; i < 3; ++i) {
+            const glm::vec2& v1 = p[(i + 1) % 3];
+            const glm::vec2& v2 = p[(i + 2) % 3];
+            planes.bary[i] = { (v1.y - v2.y) * invArea, (v2.x - v1.x) * invArea, (v1.x * v2.y - v2.x * v1.y) * invArea };
+        }
+        auto plane = [&](float v0, float v1, float v2) {
+            const Plane* bary = planes.bary;
+            return Plane{ bary[0].a * v0 + bary[1].a * v1 + bary[2].a * v2,
+                          bary[0].b * v0 + bary[1].b * v1 + bary[2].b * v2,
+                          bary[0].c * v0 + bary[1].c * v1 + bary[2].c * v2 };
+        };
+        planes.depth = plane(triangle.depth[0], triangle.depth[1], triangle.depth[2]);
+        planes.invW = plane(triangle.invW[0], triangle.invW[1], triangle.invW[2]);
+        for (int k = 0; k < 3; ++k)
+            planes.attributes[k] = plane(triangle.color[0][k], triangle.color[1][k], triangle.color[2][k]);
+        for (int k = 0; k < 2; ++k)
+            planes.attributes[3 + k] = plane(triangle.texcoord[0][k], triangle.texcoord[1][k], triangle.texcoord[2][k]);
+        return planes;
+    }
+
+    // Nothing in the scene blends, so a pixel's final color is the shade of
+    // the last triangle that passed its tests there. Tiles run depth and
+    // stencil for every triangle first, remembering that triangle per
+    // pixel, and shade each pixel once at the end however deep the overdraw.
+    const uint32_t NoWriter = 0xFFFFFFFFu;
+
+    struct TileScratch {
+        uint32_t writer[SoftRaster::TileSize * SoftRaster::TileSize];
+        std::vector<Planes> planes;     // per triangle in the tile's bin
+    };
+
+    void coverTriangle(const Renderer& renderer, const Triangle& triangle, const Planes& planes, uint32_t id, int tileX0, int tileY0, int tileX1, int tileY1, uint32_t* writer) {
+        Framebuffer& target = *renderer.target;
+        const State& state = renderer.states[triangle.state];
+
+        const int x0 = std::max(triangle.minX, tileX0) & ~3;
+        const int x1 = std::min(triangle.maxX, tileX1);
+        const int y0 = std::max(triangle.minY, tileY0);
+        const int y1 = std::min(triangle.maxY, tileY1);
+
+        const __m128 lane = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 ba[3] = { _mm_set1_ps(planes.bary[0].a), _mm_set1_ps(planes.bary[1].a), _mm_set1_ps(planes.bary[2].a) };
+        const __m128 depthA = _mm_set1_ps(planes.depth.a);
+        const bool stencilEqual = state.stencilTest && state.stencilFunc == SoftRaster::StencilFunc::Equal;
+        const bool stencilReplace = state.stencilTest && state.stencilPass == SoftRaster::StencilOp::Replace;
+
+        for (int y = y0; y <= y1; ++y) {
+            const float py = y + 0.5f;
+            __m128 rowBary[3];
+            for (int i = 0; i < 3; ++i)
+                rowBary[i] = _mm_set1_ps(planes.bary[i].b * py + planes.bary[i].c);
+            const __m128 rowDepth = _mm_set1_ps(planes.depth.b * py + planes.depth.c);
+            const size_t row = size_t(y) * target.width;
+            uint32_t* writerRow = writer + size_t(y - tileY0) * SoftRaster::TileSize - tileX0;
+
+            for (int x = x0; x <= x1; x += 4) {
+                const __m128 px = _mm_add_ps(_mm_set1_ps(float(x)), lane);
+
+                // shared edges land in both triangles, harmless without blending
+                __m128 inside = _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(ba[0], px), rowBary[0]), zero);
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(ba[1], px), rowBary[1]), zero));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(ba[2], px), rowBary[2]), zero));
+
+                const __m128 z = _mm_add_ps(_mm_mul_ps(depthA, px), rowDepth);
+                inside = _mm_and_ps(inside, _mm_and_ps(_mm_cmpge_ps(z, zero), _mm_cmple_ps(z, one)));
+                unsigned mask = unsigned(_mm_movemask_ps(inside));
+                // lanes past the end of the row are the start of the next one,
+                // which another tile's job owns: never read or write them
+                const bool wholeQuad = x + 4 <= target.width;
+                if (!wholeQuad)
+                    mask &= (1u << (target.width - x)) - 1u;
+                if (!mask)
+                    continue;
+
+                __m128 stored;
+                if (wholeQuad) {
+                    stored = _mm_loadu_ps(&target.depth[row + x]);
+                } else {
+                    alignas(16) float edge[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+                    for (int i = 0; i < target.width - x; ++i)
+                        edge[i] = target.depth[row + x + i];
+                    stored = _mm_load_ps(edge);
+                }
+                const unsigned depthPass = state.depthTest ? unsigned(_mm_movemask_ps(_mm_cmplt_ps(z, stored))) : 0xFu;
+                alignas(16) float depths[4];
+                if (!stencilEqual && !stencilReplace) {
+                    // no stencil, the common case stays in vector registers
+                    mask &= depthPass;
+                    if (state.depthWrite && wholeQuad) {
+                        const __m128 write = _mm_castsi128_ps(_mm_setr_epi32(mask & 1 ? -1 : 0, mask & 2 ? -1 : 0, mask & 4 ? -1 : 0, mask & 8 ? -1 : 0));
+                        _mm_storeu_ps(&target.depth[row + x], _mm_or_ps(_mm_and_ps(write, z), _mm_andnot_ps(write, stored)));
+                    } else if (state.depthWrite) {
+                        _mm_store_ps(depths, z);
+                        for (unsigned lanes = mask; lanes; lanes &= lanes - 1)
+                            target.depth[row + x + std::countr_zero(lanes)] = depths[std::countr_zero(lanes)];
+                    }
+                    for (; mask; mask &= mask - 1)
+                        writerRow[x + std::countr_zero(mask)] = id;
+                    continue;
+                }
+
+                _mm_store_ps(depths, z);
+                for (; mask; mask &= mask - 1) {
+                    const int i = std::countr_zero(mask);
+                    uint8_t& stencil = target.stencil[row + x + i];
+                    if (stencilEqual && stencil != state.stencilRef)
+                        continue;
+                    if (!(depthPass & (1u << i)))
+                        continue;
+                    if (stencilReplace)
+                        stencil = uint8_t((stencil & ~state.stencilWriteMask) | (state.stencilRef & state.stencilWriteMask));
+                    if (state.depthWrite)
+                        target.depth[row + x + i] = depths[i];
+                    writerRow[x + i] = id;
+                }
+            }
+        }
+    }
+
+    // invW first, then the attributes
+    const Plane& interpolant(const Planes& planes, int k) {
+        return k == 0 ? planes.invW : planes.attributes[k - 1];
+    }
+
+    // The scene program: vertex color times instance color, times the 50/50
+    // mix of both textures, a quad of four pixels at a time. The planes are
+    // evaluated, the textures sampled and the colors packed in SSE lanes.
+    // Inside a triangle, the common case, the quad broadcasts one set of
+    // planes; on an edge each lane takes its own writer's.
+    void shadeTile(const Renderer& renderer, const TileScratch& scratch, int tileX0, int tileY0) {
+        Framebuffer& target = *renderer.target;
+        const int x1 = std::min(tileX0 + SoftRaster::TileSize, target.width);
+        const int y1 = std::min(tileY0 + SoftRaster::TileSize, target.height);
+        const Sampler::State sampler;
+        const float lod[4] = {};
+        const __m128 lane = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 half = _mm_set1_ps(0.5f);
+        const __m128 scale = _mm_set1_ps(255.0f);
+        const __m128i none = _mm_set1_epi32(int(NoWriter));
+
+        for (int y = tileY0; y < y1; ++y) {
+            const float py = y + 0.5f;
+            const size_t row = size_t(y) * target.width;
+            // lanes past the end of the row have no writer, coverTriangle never sets them
+            const uint32_t* writerRow = scratch.writer + size_t(y - tileY0) * SoftRaster::TileSize - tileX0;
+            for (int x = tileX0; x < x1; x += 4) {
+                const __m128i ids = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&writerRow[x]));
+                const __m128i empty = _mm_cmpeq_epi32(ids, none);
+                const unsigned written = ~unsigned(_mm_movemask_ps(_mm_castsi128_ps(empty))) & 0xFu;
+                if (!written)
+                    continue;
+
+                const __m128 px = _mm_add_ps(_mm_set1_ps(float(x)), lane);
+                const uint32_t firstId = writerRow[x + std::countr_zero(written)];
+                const __m128i same = _mm_or_si128(_mm_cmpeq_epi32(ids, _mm_set1_epi32(int(firstId))), empty);
+                __m128 value[6];
+                if (_mm_movemask_ps(_mm_castsi128_ps(same)) == 0xF) {
+                    const Planes& planes = scratch.planes[firstId];
+                    for (int k = 0; k < 6; ++k) {
+                        const Plane& plane = interpolant(planes, k);
+                        value[k] = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.a), px), _mm_set1_ps(plane.b * py + plane.c));
+                    }
+                } else {
+                    const Planes* lanes[4];
+                    for (int i = 0; i < 4; ++i)
+                        lanes[i] = &scratch.planes[written & (1u << i) ? writerRow[x + i] : firstId];
+                    for (int k = 0; k < 6; ++k) {
+                        const Plane* p[4] = { &interpolant(*lanes[0], k), &interpolant(*lanes[1], k), &interpolant(*lanes[2], k), &interpolant(*lanes[3], k) };
+                        const __m128 a = _mm_setr_ps(p[0]->a, p[1]->a, p[2]->a, p[3]->a);
+                        const __m128 rest = _mm_setr_ps(p[0]->b * py + p[0]->c, p[1]->b * py + p[1]->c, p[2]->b * py + p[2]->c, p[3]->b * py + p[3]->c);
+                        value[k] = _mm_add_ps(_mm_mul_ps(a, px), rest);
+                    }
+                }
+
+                // lanes without a writer extrapolate a plane and can reach
+                // infinities, they sample texel (0, 0) and are not stored
+                const __m128 live = _mm_castsi128_ps(_mm_xor_si128(empty, _mm_set1_epi32(-1)));
+                const __m128 w = _mm_div_ps(one, value[0]);
+                alignas(16) float u[4], v[4];
+                _mm_store_ps(u, _mm_and_ps(_mm_mul_ps(value[4], w), live));
+                _mm_store_ps(v, _mm_and_ps(_mm_mul_ps(value[5], w), live));
+                alignas(16) float texels[32];
+                Sampler::sample4Channels(renderer.textures, 2, sampler, u, v, lod, texels);
+
+                // rounds like GL's normalized conversion, one channel per byte
+                __m128i packed = _mm_setzero_si128();
+                for (int c = 0; c < 4; ++c) {
+                    __m128 channel = _mm_mul_ps(_mm_add_ps(_mm_load_ps(texels + c * 4), _mm_load_ps(texels + 16 + c * 4)), half);
+                    if (c < 3)
+                        channel = _mm_mul_ps(channel, _mm_mul_ps(value[1 + c], w));
+                    channel = _mm_mul_ps(_mm_min_ps(_mm_max_ps(channel, _mm_setzero_ps()), one), scale);
+                    packed = _mm_or_si128(packed, _mm_slli_epi32(_mm_cvtps_epi32(channel), 8 * c));
+                }
+
+                if (written == 0xF) {
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(&target.color[row + x]), packed);
+                } else {
+                    alignas(16) uint32_t colors[4];
+                    _mm_store_si128(reinterpret_cast<__m128i*>(colors), packed);
+                    for (unsigned lanes = written; lanes; lanes &= lanes - 1)
+                        target.color[row + x + std::countr_zero(lanes)] = colors[std::countr_zero(lanes)];
+                }
+            }
+        }
+    }
+
+    double since(std::chrono::high_resolution_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+}
+
+void SoftRaster::resize(Framebuffer& framebuffer, int width, int height) {
+    if (framebuffer.width == width && framebuffer.height == height)
+        return;
+    framebuffer.width = width;
+    framebuffer.height = height;
+    // padded so four wide loads at the end of the last row stay in bounds
+    const size_t pixels = size_t(width) * height + 4;
+    framebuffer.color.assign(pixels, 0);
+    framebuffer.depth.assign(pixels, 1.0f);
+    framebuffer.stencil.assign(pixels, 0);
+}
+
+void SoftRaster::clear(Framebuffer& framebuffer, const glm::vec4& color, float depth, uint8_t stencil) {
+    std::fill(framebuffer.color.begin(), framebuffer.color.end(), pack(color));
+    std::fill(framebuffer.depth.begin(), framebuffer.depth.end(), depth);
+    std::fill(framebuffer.stencil.begin(), framebuffer.stencil.end(), stencil);
+}
+
+bool SoftRaster::loadTexture(Sampler::Image& texture, const char* path) {
+    int width, height;
+    unsigned char* image = SOIL_load_image(path, &width, &height, 0, SOIL_LOAD_RGBA);
+    if (!image) {
+        std::cout << "ERROR::SOFT_RASTER::TEXTURE_LOAD_FAILED\n" << path << ": " << SOIL_last_result() << std::endl;
+        return false;
+    }
+    Sampler::create(texture, Sampler::Format::RGBA8, Sampler::Layout::Morton, image, width, height, false);
+    SOIL_free_image_data(image);
+    return true;
+}
+
+void SoftRaster::addMesh(Mesh& mesh, const float* vertices, int vertexCount, int floatsPerVertex) {
+    for (int i = 0; i < vertexCount; ++i) {
+        const float* v = vertices + size_t(i) * floatsPerVertex;
+        mesh.vertices.push_back({ glm::vec3(v[0], v[1], v[2]), glm::vec3(v[3], v[4], v[5]), glm::vec2(v[6], v[7]) });
+    }
+}
+
+void SoftRaster::begin(Renderer& renderer, Framebuffer& target, const glm::mat4& viewProj, const Sampler::Image& first, const Sampler::Image& second) {
+    renderer.target = &target;
+    renderer.viewProj = viewProj;
+    renderer.textures[0] = &first;
+    renderer.textures[1] = &second;
+    renderer.states.clear();
+    renderer.triangles.clear();
+    renderer.stats = Stats();
+}
+
+void SoftRaster::draw(Renderer& renderer, const Mesh& mesh, const DrawBatch::Instance* instances, size_t count, const State& state) {
+    auto start = std::chrono::high_resolution_clock::now();
+    const int stateIndex = int(renderer.states.size());
+    renderer.states.push_back(state);
+
+    // clipping against near splits a triangle into two at most
+    const size_t meshTriangles = mesh.vertices.size() / 3;
+    const size_t slots = meshTriangles * 2;
+    renderer.scratch.resize(count * slots);
+    const int width = renderer.target->width, height = renderer.target->height;
+
+    JobSystem::parallelFor(count, 64, [&](size_t begin, size_t end) {
+        for (size_t instance = begin; instance < end; ++instance) {
+            const glm::mat4 transform = renderer.viewProj * instances[instance].model;
+            const glm::vec3 tint = glm::vec3(instances[instance].color);
+            Triangle* out = &renderer.scratch[instance * slots];
+            for (size_t t = 0; t < meshTriangles; ++t) {
+                ClipVertex corners[3];
+                for (int k = 0; k < 3; ++k) {
+                    const SoftRaster::Vertex& vertex = mesh.vertices[t * 3 + k];
+                    corners[k] = { transform * glm::vec4(vertex.position, 1.0f), vertex.color * tint, vertex.texcoord };
+                }
+                ClipVertex clipped[4];
+                const int n = clipNear(corners, clipped);
+                out[t * 2].state = -1;
+                out[t * 2 + 1].state = -1;
+                if (n >= 3 && !setup(clipped[0], clipped[1], clipped[2], width, height, stateIndex, out[t * 2]))
+                    out[t * 2].state = -1;
+                if (n == 4 && !setup(clipped[0], clipped[2], clipped[3], width, height, stateIndex, out[t * 2 + 1]))
+                    out[t * 2 + 1].state = -1;
+            }
+        }
+    });
+
+    // in submission order, which is the order tiles draw them in
+    for (const Triangle& triangle : renderer.scratch)
+        if (triangle.state >= 0)
+            renderer.triangles.push_back(triangle);
+    renderer.stats.setupMs += since(start);
+}
+
+void SoftRaster::finish(Renderer& renderer) {
+    auto start = std::chrono::high_resolution_clock::now();
+    const Framebuffer& target = *renderer.target;
+    renderer.tilesX = (target.width + TileSize - 1) / TileSize;
+    renderer.tilesY = (target.height + TileSize - 1) / TileSize;
+    renderer.bins.resize(size_t(renderer.tilesX) * renderer.tilesY);
+    for (std::vector<uint32_t>& bin : renderer.bins)
+        bin.clear();
+
+    for (uint32_t t = 0; t < uint32_t(renderer.triangles.size()); ++t) {
+        const Triangle& triangle = renderer.triangles[t];
+        for (int ty = triangle.minY / TileSize; ty <= triangle.maxY / TileSize; ++ty)
+            for (int tx = triangle.minX / TileSize; tx <= triangle.maxX / TileSize; ++tx)
+                renderer.bins[size_t(ty) * renderer.tilesX + tx].push_back(t);
+    }
+
+    JobSystem::parallelFor(renderer.bins.size(), 1, [&](size_t first, size_t last) {
+        thread_local TileScratch scratch;
+        for (size_t tile = first; tile < last; ++tile) {
+            const std::vector<uint32_t>& bin = renderer.bins[tile];
+            if (bin.empty())
+                continue;
+            const int tileX0 = int(tile % renderer.tilesX) * TileSize;
+            const int tileY0 = int(tile / renderer.tilesX) * TileSize;
+            std::fill(std::begin(scratch.writer), std::end(scratch.writer), NoWriter);
+            scratch.planes.resize(bin.size());
+            for (size_t i = 0; i < bin.size(); ++i) {
+                const Triangle& triangle = renderer.triangles[bin[i]];
+                scratch.planes[i] = planesOf(triangle);
+                coverTriangle(renderer, triangle, scratch.planes[i], uint32_t(i), tileX0, tileY0, tileX0 + TileSize - 1, tileY0 + TileSize - 1, scratch.writer);
+            }
+            shadeTile(renderer, scratch, tileX0, tileY0);
+        }
+    });
+
+    renderer.stats.triangles = renderer.triangles.size();
+    renderer.stats.binned = 0;
+    for (const std::vector<uint32_t>& bin : renderer.bins)
+        renderer.stats.binned += bin.size();
+    renderer.stats.rasterMs = since(start);
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+#include "DrawBatch.h"
+#include "../Texture/Sampler.h"
+
+// CPU rasterizer for the scene, for hosts without a GPU. Draws are recorded
+// between begin() and finish(): each one transforms and clips its instances
+// on the job threads into screen space triangles, finish() sorts those into
+// 64x64 pixel tiles and runs the tiles in parallel: coverage and depth four
+// pixels at a time with SSE edge functions, then one shade per pixel for the
+// triangle that wrote it last, interpolated, sampled and packed a quad of
+// four pixels per SSE register. A tile walks its triangles in submission
+// order, so depth and stencil behave as if drawn serially.
+//
+// Shading is the scene program: vertex color times instance color, times
+// the 50/50 mix of two textures sampled bilinear with clamp to edge, into
+// an RGBA8 framebuffer with row 0 at the bottom, like texColorBuffer.
+namespace SoftRaster {
+
+    const int TileSize = 64;
+
+    struct Framebuffer {
+        int width = 0;
+        int height = 0;
+        std::vector<uint32_t> color;    // RGBA8, R in the lowest byte
+        std::vector<float> depth;       // window depth, 0 near to 1 far
+        std::vector<uint8_t> stencil;
+    };
+
+    void resize(Framebuffer& framebuffer, int width, int height);
+    void clear(Framebuffer& framebuffer, const glm::vec4& color, float depth = 1.0f, uint8_t stencil = 0);
+
+    // RGBA8 in Morton order, sampled like the GL textures: linear, clamp to edge, no mips
+    bool loadTexture(Sampler::Image& texture, const char* path);
+
+    struct Vertex {
+        glm::vec3 position;
+        glm::vec3 color;
+        glm::vec2 texcoord;
+    };
+
+    // Non-indexed triangle list, position/color/texcoord interleaved like vertices.h
+    struct Mesh {
+        std::vector<Vertex> vertices;
+    };
+
+    void addMesh(Mesh& mesh, const float* vertices, int vertexCount, int floatsPerVertex);
+
+    enum class StencilFunc { Always, Equal };
+    enum class StencilOp { Keep, Replace };
+
+    // The fixed function state the scene pass sets. Depth compares GL_LESS.
+    struct State {
+        bool depthTest = true;
+        bool depthWrite = true;
+        bool stencilTest = false;
+        StencilFunc stencilFunc = StencilFunc::Always;
+        uint8_t stencilRef = 0;
+        StencilOp stencilPass = StencilOp::Keep;
+        uint8_t stencilWriteMask = 0xFF;
+    };
+
+    // Screen space triangle after clipping, attributes divided by w
+    struct Triangle {
+        glm::vec2 position[3];          // window pixels
+        float depth[3];
+        float invW[3];
+        glm::vec3 color[3];
+        glm::vec2 texcoord[3];
+        int minX, minY, maxX, maxY;     // covered pixels, inclusive
+        int state;
+    };
+
+    struct Stats {
+        size_t triangles = 0;           // after clipping
+        size_t binned = 0;              // triangle/tile pairs
+        double setupMs = 0.0;
+        double rasterMs = 0.0;
+    };
+
+    struct Renderer {
+        Framebuffer* target = nullptr;
+        glm::mat4 viewProj = glm::mat4(1.0f);
+        const Sampler::Image* textures[2] = {};
+        std::vector<State> states;
+        std::vector<Triangle> triangles;
+        std::vector<Triangle> scratch;          // per draw, two slots per mesh triangle and instance
+        std::vector<std::vector<uint32_t>> bins;
+        int tilesX = 0, tilesY = 0;
+        Stats stats;
+    };
+
+    // Starts recording into the framebuffer; the textures stand in for texKitten and texPuppy
+    void begin(Renderer& renderer, Framebuffer& target, const glm::mat4& viewProj, const Sampler::Image& first, const Sampler::Image& second);
+
+    // Draws the mesh once per instance with the given state
+    void draw(Renderer& renderer, const Mesh& mesh, const DrawBatch::Instance* instances, size_t count, const State& state);
+
+    // Bins and rasterizes everything recorded since begin()
+    void finish(Renderer& renderer);
+}
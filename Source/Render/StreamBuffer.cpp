@@ -0,0 +1,127 @@
+#include "StreamBuffer.h"
+#include "GLState.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+namespace {
+
+    // not tracked by GLState, so uploads here don't disturb its copy
+    const GLenum UploadTarget = GL_COPY_WRITE_BUFFER;
+
+    void waitFor(StreamBuffer::Buffer& stream, GLsync fence) {
+        // three frames back, usually already signalled
+        if (glClientWaitSync(fence, 0, 0) != GL_TIMEOUT_EXPIRED)
+            return;
+
+        auto start = std::chrono::high_resolution_clock::now();
+        while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED) {}
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+        stream.stats.waits++;
+        stream.stats.stallMs += ms;
+        stream.stats.worstStallMs = std::max(stream.stats.worstStallMs, ms);
+    }
+}
+
+bool StreamBuffer::create(Buffer& stream, size_t bytesPerFrame) {
+    // keep regions aligned for anything that gets bound by offset
+    GLint uniformAlignment = 256;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformAlignment);
+    const size_t alignment = std::max<size_t>(uniformAlignment, 256);
+    stream.regionSize = (bytesPerFrame + alignment - 1) / alignment * alignment;
+    const size_t size = stream.regionSize * Regions;
+
+    glGenBuffers(1, &stream.buffer);
+    glBindBuffer(UploadTarget, stream.buffer);
+
+    if (GLEW_ARB_buffer_storage) {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(UploadTarget, size, NULL, flags);
+        stream.mapped = static_cast<unsigned char*>(glMapBufferRange(UploadTarget, 0, size, flags));
+        if (!stream.mapped) {
+            std::cout << "ERROR::STREAMBUFFER::MAP_FAILED" << std::endl;
+            return false;
+        }
+    } else {
+        glBufferData(UploadTarget, size, NULL, GL_STREAM_DRAW);
+        stream.staging.resize(stream.regionSize);
+    }
+
+    stream.region = Regions - 1;
+    stream.offset = 0;
+    stream.flushed = 0;
+    return true;
+}
+
+void StreamBuffer::beginFrame(Buffer& stream) {
+    stream.region = (stream.region + 1) % Regions;
+    stream.offset = 0;
+    stream.flushed = 0;
+
+    GLsync& fence = stream.fences[stream.region];
+    if (fence) {
+        waitFor(stream, fence);
+        glDeleteSync(fence);
+        fence = 0;
+    }
+}
+
+StreamBuffer::Allocation StreamBuffer::allocate(Buffer& stream, size_t bytes, size_t alignment) {
+    // align the absolute offset, the region base need not be a multiple
+    const size_t base = stream.region * stream.regionSize;
+    size_t start = base + stream.offset;
+    if (alignment > 1)
+        start = (start + alignment - 1) / alignment * alignment;
+
+    if (start + bytes > base + stream.regionSize) {
+        std::cout << "ERROR::STREAMBUFFER::REGION_FULL\n" << bytes << " bytes requested, "
+                  << base + stream.regionSize - std::min(start, base + stream.regionSize) << " left" << std::endl;
+        return Allocation();
+    }
+
+    Allocation allocation;
+    allocation.offset = GLintptr(start);
+    allocation.size = GLsizeiptr(bytes);
+    allocation.data = stream.mapped ? stream.mapped + start : stream.staging.data() + (start - base);
+
+    stream.offset = start + bytes - base;
+    stream.stats.lastFrameBytes = stream.offset;
+    stream.stats.peakFrameBytes = std::max(stream.stats.peakFrameBytes, stream.offset);
+    return allocation;
+}
+
+void StreamBuffer::flush(Buffer& stream) {
+    if (stream.mapped || stream.flushed == stream.offset)
+        return;
+
+    // padding between allocations goes up too, one call covers them all
+    const size_t base = stream.region * stream.regionSize;
+    glBindBuffer(UploadTarget, stream.buffer);
+    glBufferSubData(UploadTarget, base + stream.flushed, stream.offset - stream.flushed, stream.staging.data() + stream.flushed);
+    stream.flushed = stream.offset;
+}
+
+void StreamBuffer::endFrame(Buffer& stream) {
+    flush(stream);
+    stream.fences[stream.region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void StreamBuffer::destroy(Buffer& stream) {
+    for (GLsync& fence : stream.fences)
+        if (fence)
+            glDeleteSync(fence);
+    if (stream.mapped) {
+        glBindBuffer(UploadTarget, stream.buffer);
+        glUnmapBuffer(UploadTarget);
+    }
+    GLState::deleteBuffers(1, &stream.buffer);
+    stream = Buffer();
+}
+
+void StreamBuffer::printStats(const Buffer& stream, const char* name) {
+    const Stats& stats = stream.stats;
+    std::cout << name << ": " << stats.peakFrameBytes << " of " << stream.regionSize << " bytes per frame at peak, "
+              << stats.waits << " fence waits, " << stats.stallMs << " ms stalled (worst " << stats.worstStallMs << " ms)" << std::endl;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstddef>
+#include <vector>
+
+// Buffer for data that is rewritten every frame: vertices, indices, instance
+// data, uniforms. It is split into one region per frame in flight and each
+// frame bump-allocates from its own region; a fence per region keeps the CPU
+// from writing over data the GPU has not read yet. Mapped once with
+// glBufferStorage, persistent and coherent, so writes need no map/unmap.
+// Without ARB_buffer_storage allocations point into a CPU copy and flush()
+// uploads them with glBufferSubData.
+namespace StreamBuffer {
+
+    const int Regions = 3;
+
+    struct Allocation {
+        unsigned char* data = nullptr;  // write here, valid until the frame ends
+        GLintptr offset = 0;            // from the start of the GL buffer
+        GLsizeiptr size = 0;
+    };
+
+    struct Stats {
+        long long waits = 0;        // beginFrame calls that found the GPU still reading
+        double stallMs = 0.0;       // total time spent in those waits
+        double worstStallMs = 0.0;
+        size_t lastFrameBytes = 0;
+        size_t peakFrameBytes = 0;
+    };
+
+    struct Buffer {
+        GLuint buffer = 0;
+        unsigned char* mapped = nullptr;        // null on the glBufferSubData path
+        std::vector<unsigned char> staging;     // one region, glBufferSubData path only
+        size_t regionSize = 0;
+        size_t offset = 0;                      // within the current region
+        size_t flushed = 0;                     // staging bytes already uploaded
+        int region = 0;
+        GLsync fences[Regions] = {};
+        Stats stats;
+    };
+
+    bool create(Buffer& stream, size_t bytesPerFrame);
+
+    // Moves to the next region, waiting for the GPU if it still reads it
+    void beginFrame(Buffer& stream);
+
+    // Linear sub-allocation from this frame's region. The offset is a
+    // multiple of alignment (any value, so a vertex stride works and the
+    // offset divided by it can be used as the first vertex). Returns an
+    // empty allocation when the region is full.
+    Allocation allocate(Buffer& stream, size_t bytes, size_t alignment = 4);
+
+    // Typed helpers; the offset is aligned to the element size
+    template<typename T>
+    T* allocateArray(Buffer& stream, size_t count, GLintptr& offset) {
+        Allocation allocation = allocate(stream, count * sizeof(T), sizeof(T));
+        offset = allocation.offset;
+        return reinterpret_cast<T*>(allocation.data);
+    }
+
+    // Makes what was written since the last flush visible to the GPU.
+    // Call before drawing from it; a no-op on the persistent path.
+    void flush(Buffer& stream);
+
+    // Fences the region written this frame
+    void endFrame(Buffer& stream);
+
+    void destroy(Buffer& stream);
+
+    void printStats(const Buffer& stream, const char* name);
+}
@@ -0,0 +1,33 @@
+#include "UniformRing.h"
+#include "GLState.h"
+
+#include <cstring>
+
+bool UniformRing::create(Ring& ring, size_t bytesPerFrame) {
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &ring.alignment);
+    return StreamBuffer::create(ring.stream, bytesPerFrame);
+}
+
+void UniformRing::beginFrame(Ring& ring) {
+    StreamBuffer::beginFrame(ring.stream);
+}
+
+bool UniformRing::push(Ring& ring, GLuint binding, const void* data, size_t bytes) {
+    StreamBuffer::Allocation allocation = StreamBuffer::allocate(ring.stream, bytes, ring.alignment);
+    if (!allocation.data)
+        return false;
+
+    memcpy(allocation.data, data, bytes);
+    StreamBuffer::flush(ring.stream);
+    GLState::bindBufferRange(GL_UNIFORM_BUFFER, binding, ring.stream.buffer, allocation.offset, allocation.size);
+    return true;
+}
+
+void UniformRing::endFrame(Ring& ring) {
+    StreamBuffer::endFrame(ring.stream);
+}
+
+void UniformRing::destroy(Ring& ring) {
+    StreamBuffer::destroy(ring.stream);
+    ring = Ring();
+}
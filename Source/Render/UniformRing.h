@@ -0,0 +1,27 @@
+#pragma once
+
+#include "StreamBuffer.h"
+
+// Uniform blocks streamed through a StreamBuffer: each push copies a block
+// into this frame's region and binds that slice with glBindBufferRange.
+namespace UniformRing {
+
+    struct Ring {
+        StreamBuffer::Buffer stream;
+        GLint alignment = 256;
+    };
+
+    bool create(Ring& ring, size_t bytesPerFrame);
+
+    // Moves to the next region, waiting for the GPU if it still uses it
+    void beginFrame(Ring& ring);
+
+    // Copies data into the ring and binds it to the uniform binding point.
+    // Returns false when the frame's region is full.
+    bool push(Ring& ring, GLuint binding, const void* data, size_t bytes);
+
+    // Fences the region written this frame
+    void endFrame(Ring& ring);
+
+    void destroy(Ring& ring);
+}
@@ -0,0 +1,597 @@
+#include "Bvh.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+
+#include <xmmintrin.h>
+
+namespace {
+
+    using Bvh::Aabb;
+    using Bvh::Node;
+    using Bvh::Tree;
+
+    const int Bins = 12;
+    const float TraversalCost = 1.0f;  // relative to testing one object
+
+    // Binary levels split by SAH. Past them ranges are split at the median,
+    // which halves them, so no branch gets deeper than MaxDepth even when
+    // the boxes defeat the heuristic (a long run of nested boxes, say).
+    const int MaxSahDepth = 48;
+    const int MaxDepth = MaxSahDepth + 32;
+
+    // Popping a node pushes at most Width children, so a depth first walk
+    // never holds more than this
+    const int StackSize = MaxDepth * (Bvh::Width - 1) + 1;
+
+    Aabb emptyBox() {
+        return { glm::vec3(FLT_MAX), glm::vec3(-FLT_MAX) };
+    }
+
+    void grow(Aabb& box, const Aabb& other) {
+        box.min = glm::min(box.min, other.min);
+        box.max = glm::max(box.max, other.max);
+    }
+
+    float area(const Aabb& box) {
+        glm::vec3 size = glm::max(box.max - box.min, glm::vec3(0.0f));
+        return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+    }
+
+    glm::vec3 centroid(const Aabb& box) {
+        return (box.min + box.max) * 0.5f;
+    }
+
+    // Binary tree the builder produces before it is collapsed
+    struct BuildNode {
+        Aabb bounds;
+        int left = -1, right = -1;
+        uint32_t first = 0, count = 0;     // leaf range when left < 0
+    };
+
+    struct Builder {
+        const std::vector<Aabb>& boxes;
+        std::vector<glm::vec3> centroids;
+        std::vector<uint32_t>& objects;
+        std::vector<BuildNode> nodes;
+
+        int build(uint32_t first, uint32_t count, int depth) {
+            BuildNode node;
+            node.bounds = emptyBox();
+            Aabb centroidBounds = emptyBox();
+            for (uint32_t i = first; i < first + count; ++i) {
+                grow(node.bounds, boxes[objects[i]]);
+                const glm::vec3& c = centroids[objects[i]];
+                grow(centroidBounds, { c, c });
+            }
+
+            const int index = int(nodes.size());
+            nodes.push_back(node);
+
+            uint32_t split = 0;
+            if (count > Bvh::MaxLeafSize)
+                split = depth < MaxSahDepth ? findSplit(first, count, node.bounds, centroidBounds) : medianSplit(first, count, centroidBounds);
+            if (split == 0) {
+                nodes[index].first = first;
+                nodes[index].count = count;
+                return index;
+            }
+
+            int left = build(first, split, depth + 1);
+            int right = build(first + split, count - split, depth + 1);
+            nodes[index].left = left;
+            nodes[index].right = right;
+            return index;
+        }
+
+        // Halves the range along the widest centroid axis
+        uint32_t medianSplit(uint32_t first, uint32_t count, const Aabb& centroidBounds) {
+            glm::vec3 extent = centroidBounds.max - centroidBounds.min;
+            int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+            uint32_t* begin = objects.data() + first;
+            std::nth_element(begin, begin + count / 2, begin + count,
+                             [&](uint32_t a, uint32_t b) { return centroids[a][axis] < centroids[b][axis]; });
+            return count / 2;
+        }
+
+        // Partitions the range and returns the size of the left side,
+        // 0 when a leaf is cheaper than any split
+        uint32_t findSplit(uint32_t first, uint32_t count, const Aabb& bounds, const Aabb& centroidBounds) {
+            glm::vec3 extent = centroidBounds.max - centroidBounds.min;
+            int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+
+            uint32_t* begin = objects.data() + first;
+            uint32_t* end = begin + count;
+
+            if (extent[axis] <= 0.0f) {
+                // all centroids on top of each other, no plane separates them
+                return count > 4 * Bvh::MaxLeafSize ? count / 2 : 0;
+            }
+
+            struct Bin {
+                Aabb bounds = emptyBox();
+                uint32_t count = 0;
+            } bins[Bins];
+
+            const float scale = Bins / extent[axis];
+            auto binOf = [&](uint32_t object) {
+                int bin = int((centroids[object][axis] - centroidBounds.min[axis]) * scale);
+                return std::min(bin, Bins - 1);
+            };
+            for (uint32_t* object = begin; object != end; ++object) {
+                Bin& bin = bins[binOf(*object)];
+                grow(bin.bounds, boxes[*object]);
+                bin.count++;
+            }
+
+            // sweep from the right, then from the left, pricing each plane
+            float rightArea[Bins];
+            uint32_t rightCount[Bins];
+            Aabb accumulated = emptyBox();
+            uint32_t accumulatedCount = 0;
+            for (int i = Bins - 1; i > 0; --i) {
+                grow(accumulated, bins[i].bounds);
+                accumulatedCount += bins[i].count;
+                rightArea[i] = area(accumulated);
+                rightCount[i] = accumulatedCount;
+            }
+
+            float bestCost = FLT_MAX;
+            int bestPlane = -1;
+            accumulated = emptyBox();
+            accumulatedCount = 0;
+            for (int i = 1; i < Bins; ++i) {
+                grow(accumulated, bins[i - 1].bounds);
+                accumulatedCount += bins[i - 1].count;
+                if (accumulatedCount == 0 || rightCount[i] == 0)
+                    continue;
+                float cost = area(accumulated) * accumulatedCount + rightArea[i] * rightCount[i];
+                if (cost < bestCost) {
+                    bestCost = cost;
+                    bestPlane = i;
+                }
+            }
+
+            const float leafCost = area(bounds) * count;
+            const float splitCost = TraversalCost * area(bounds) + bestCost;
+            if (bestPlane < 0 || (splitCost >= leafCost && count <= 4 * Bvh::MaxLeafSize))
+                return 0;
+
+            uint32_t* middle = std::partition(begin, end, [&](uint32_t object) { return binOf(object) < bestPlane; });
+            return uint32_t(middle - begin);
+        }
+    };
+
+    void setSlot(Node& node, int slot, const Aabb& box, int32_t child) {
+        node.minX[slot] = box.min.x;
+        node.minY[slot] = box.min.y;
+        node.minZ[slot] = box.min.z;
+        node.maxX[slot] = box.max.x;
+        node.maxY[slot] = box.max.y;
+        node.maxZ[slot] = box.max.z;
+        node.child[slot] = child;
+    }
+
+    Aabb slotBox(const Node& node, int slot) {
+        return { glm::vec3(node.minX[slot], node.minY[slot], node.minZ[slot]),
+                 glm::vec3(node.maxX[slot], node.maxY[slot], node.maxZ[slot]) };
+    }
+
+    // Pulls grandchildren up until each wide node has four children
+    int32_t collapse(Tree& tree, const std::vector<BuildNode>& binary, int index) {
+        int children[Bvh::Width] = { binary[index].left, binary[index].right };
+        int childCount = 2;
+        while (childCount < Bvh::Width) {
+            // open the inner child with the biggest box, it is the most likely to be entered
+            int widest = -1;
+            float widestArea = -1.0f;
+            for (int i = 0; i < childCount; ++i) {
+                const BuildNode& child = binary[children[i]];
+                if (child.left >= 0 && area(child.bounds) > widestArea) {
+                    widest = i;
+                    widestArea = area(child.bounds);
+                }
+            }
+            if (widest < 0)
+                break;
+            const BuildNode& opened = binary[children[widest]];
+            children[widest] = opened.left;
+            children[childCount++] = opened.right;
+        }
+
+        const int32_t nodeIndex = int32_t(tree.nodes.size());
+        tree.nodes.push_back(Node());
+        for (int slot = 0; slot < Bvh::Width; ++slot)
+            setSlot(tree.nodes[nodeIndex], slot, emptyBox(), Bvh::Empty);
+
+        for (int slot = 0; slot < childCount; ++slot) {
+            const BuildNode& child = binary[children[slot]];
+            int32_t code;
+            if (child.left < 0) {
+                code = ~int32_t(tree.leaves.size());
+                tree.leaves.push_back({ child.first, child.count });
+            } else {
+                code = collapse(tree, binary, children[slot]);
+            }
+            // the recursion may have moved the vector
+            setSlot(tree.nodes[nodeIndex], slot, child.bounds, code);
+        }
+        return nodeIndex;
+    }
+
+    float treeCost(const Tree& tree) {
+        if (tree.nodes.empty())
+            return 0.0f;
+        Aabb root = emptyBox();
+        float cost = 0.0f;
+        for (const Node& node : tree.nodes) {
+            for (int slot = 0; slot < Bvh::Width; ++slot) {
+                if (node.child[slot] == Bvh::Empty)
+                    continue;
+                float slotArea = area(slotBox(node, slot));
+                cost += node.child[slot] < 0 ? slotArea * tree.leaves[~node.child[slot]].count : slotArea * TraversalCost;
+                if (&node == &tree.nodes[0])
+                    grow(root, slotBox(node, slot));
+            }
+        }
+        return cost / std::max(area(root), 1e-12f);
+    }
+
+    bool overlaps(const Aabb& a, const Aabb& b) {
+        return a.min.x <= b.max.x && a.max.x >= b.min.x
+            && a.min.y <= b.max.y && a.max.y >= b.min.y
+            && a.min.z <= b.max.z && a.max.z >= b.min.z;
+    }
+
+    bool rayBox(const Bvh::Ray& ray, const glm::vec3& inverse, const Aabb& box, float& distance) {
+        glm::vec3 t1 = (box.min - ray.origin) * inverse;
+        glm::vec3 t2 = (box.max - ray.origin) * inverse;
+        glm::vec3 entries = glm::min(t1, t2), exits = glm::max(t1, t2);
+        float enter = std::max(std::max(entries.x, entries.y), std::max(entries.z, 0.0f));
+        float exit = std::min(std::min(exits.x, exits.y), std::min(exits.z, ray.maxDistance));
+        distance = enter;
+        return enter <= exit;
+    }
+
+    // Objects of a subtree, used once a node is known to be fully inside
+    void appendSubtree(const Tree& tree, int32_t child, std::vector<uint32_t>& objects) {
+        if (child < 0) {
+            const Bvh::Leaf& leaf = tree.leaves[~child];
+            objects.insert(objects.end(), tree.objects.begin() + leaf.first, tree.objects.begin() + leaf.first + leaf.count);
+            return;
+        }
+        for (int32_t grandchild : tree.nodes[child].child)
+            if (grandchild != Bvh::Empty)
+                appendSubtree(tree, grandchild, objects);
+    }
+}
+
+void Bvh::build(Tree& tree, const std::vector<Aabb>& boxes) {
+    tree.nodes.clear();
+    tree.leaves.clear();
+    tree.boxes = boxes;
+    tree.objects.resize(boxes.size());
+    for (uint32_t i = 0; i < boxes.size(); ++i)
+        tree.objects[i] = i;
+    if (boxes.empty()) {
+        tree.builtCost = tree.cost = 0.0f;
+        return;
+    }
+
+    Builder builder{ tree.boxes, {}, tree.objects, {} };
+    builder.centroids.resize(boxes.size());
+    for (size_t i = 0; i < boxes.size(); ++i)
+        builder.centroids[i] = centroid(boxes[i]);
+    builder.nodes.reserve(boxes.size() * 2 / MaxLeafSize + 1);
+    builder.build(0, uint32_t(boxes.size()), 0);
+
+    if (builder.nodes[0].left < 0) {
+        // small enough for one leaf, still give it a root node
+        tree.nodes.push_back(Node());
+        for (int slot = 0; slot < Width; ++slot)
+            setSlot(tree.nodes[0], slot, emptyBox(), Empty);
+        tree.leaves.push_back({ 0, uint32_t(boxes.size()) });
+        setSlot(tree.nodes[0], 0, builder.nodes[0].bounds, ~0);
+    } else {
+        collapse(tree, builder.nodes, 0);
+    }
+
+    tree.builtCost = tree.cost = treeCost(tree);
+    tree.builds++;
+}
+
+void Bvh::refit(Tree& tree, const std::vector<Aabb>& boxes) {
+    tree.boxes = boxes;
+
+    // children come after their parents, so walking backwards sees them first
+    for (size_t index = tree.nodes.size(); index-- > 0;) {
+        Node& node = tree.nodes[index];
+        for (int slot = 0; slot < Width; ++slot) {
+            const int32_t child = node.child[slot];
+            if (child == Empty)
+                continue;
+            Aabb box = emptyBox();
+            if (child < 0) {
+                const Leaf& leaf = tree.leaves[~child];
+                for (uint32_t i = leaf.first; i < leaf.first + leaf.count; ++i)
+                    grow(box, boxes[tree.objects[i]]);
+            } else {
+                for (int grandchild = 0; grandchild < Width; ++grandchild)
+                    if (tree.nodes[child].child[grandchild] != Empty)
+                        grow(box, slotBox(tree.nodes[child], grandchild));
+            }
+            setSlot(node, slot, box, child);
+        }
+    }
+
+    tree.cost = treeCost(tree);
+    tree.refits++;
+}
+
+bool Bvh::update(Tree& tree, const std::vector<Aabb>& boxes) {
+    if (tree.nodes.empty() || boxes.size() != tree.boxes.size()) {
+        build(tree, boxes);
+        return true;
+    }
+    refit(tree, boxes);
+    if (tree.cost <= tree.builtCost * tree.rebuildRatio)
+        return false;
+    build(tree, boxes);
+    return true;
+}
+
+void Bvh::queryFrustum(const Tree& tree, const FrustumCulling::Frustum& frustum, std::vector<uint32_t>& objects) {
+    if (tree.nodes.empty())
+        return;
+
+    __m128 nx[6], ny[6], nz[6], nw[6], ax[6], ay[6], az[6];
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    for (int p = 0; p < 6; ++p) {
+        nx[p] = _mm_set1_ps(frustum.planes[p].x);
+        ny[p] = _mm_set1_ps(frustum.planes[p].y);
+        nz[p] = _mm_set1_ps(frustum.planes[p].z);
+        nw[p] = _mm_set1_ps(frustum.planes[p].w);
+        ax[p] = _mm_andnot_ps(signMask, nx[p]);
+        ay[p] = _mm_andnot_ps(signMask, ny[p]);
+        az[p] = _mm_andnot_ps(signMask, nz[p]);
+    }
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 zero = _mm_setzero_ps();
+
+    int32_t stack[StackSize];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        const Node& node = tree.nodes[stack[--top]];
+
+        const __m128 minX = _mm_loadu_ps(node.minX), maxX = _mm_loadu_ps(node.maxX);
+        const __m128 minY = _mm_loadu_ps(node.minY), maxY = _mm_loadu_ps(node.maxY);
+        const __m128 minZ = _mm_loadu_ps(node.minZ), maxZ = _mm_loadu_ps(node.maxZ);
+        const __m128 cx = _mm_mul_ps(_mm_add_ps(minX, maxX), half), ex = _mm_mul_ps(_mm_sub_ps(maxX, minX), half);
+        const __m128 cy = _mm_mul_ps(_mm_add_ps(minY, maxY), half), ey = _mm_mul_ps(_mm_sub_ps(maxY, minY), half);
+        const __m128 cz = _mm_mul_ps(_mm_add_ps(minZ, maxZ), half), ez = _mm_mul_ps(_mm_sub_ps(maxZ, minZ), half);
+
+        __m128 outside = zero, crossing = zero;
+        for (int p = 0; p < 6; ++p) {
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx[p], cx), _mm_mul_ps(ny[p], cy)), _mm_add_ps(_mm_mul_ps(nz[p], cz), nw[p]));
+            __m128 reach = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax[p], ex), _mm_mul_ps(ay[p], ey)), _mm_mul_ps(az[p], ez));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, reach), zero));
+            crossing = _mm_or_ps(crossing, _mm_cmplt_ps(_mm_sub_ps(distance, reach), zero));
+        }
+        const int outsideMask = _mm_movemask_ps(outside);
+        const int crossingMask = _mm_movemask_ps(crossing);
+
+        for (int slot = 0; slot < Width; ++slot) {
+            const int32_t child = node.child[slot];
+            if (child == Empty || (outsideMask & (1 << slot)))
+                continue;
+            if (!(crossingMask & (1 << slot))) {
+                appendSubtree(tree, child, objects);
+            } else if (child >= 0) {
+                stack[top++] = child;
+            } else {
+                // leaves are small, test their objects one by one
+                const Leaf& leaf = tree.leaves[~child];
+                for (uint32_t i = leaf.first; i < leaf.first + leaf.count; ++i) {
+                    const uint32_t object = tree.objects[i];
+                    const Aabb& box = tree.boxes[object];
+                    glm::vec3 center = centroid(box), extent = (box.max - box.min) * 0.5f;
+                    bool inside = true;
+                    for (const glm::vec4& plane : frustum.planes) {
+                        if (glm::dot(glm::vec3(plane), center) + plane.w + glm::dot(glm::abs(glm::vec3(plane)), extent) < 0.0f) {
+                            inside = false;
+                            break;
+                        }
+                    }
+                    if (inside)
+                        objects.push_back(object);
+                }
+            }
+        }
+    }
+}
+
+void Bvh::queryOverlap(const Tree& tree, const Aabb& box, std::vector<uint32_t>& objects) {
+    if (tree.nodes.empty())
+        return;
+
+    const __m128 queryMinX = _mm_set1_ps(box.min.x), queryMaxX = _mm_set1_ps(box.max.x);
+    const __m128 queryMinY = _mm_set1_ps(box.min.y), queryMaxY = _mm_set1_ps(box.max.y);
+    const __m128 queryMinZ = _mm_set1_ps(box.min.z), queryMaxZ = _mm_set1_ps(box.max.z);
+
+    int32_t stack[StackSize];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        const Node& node = tree.nodes[stack[--top]];
+        __m128 hit = _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(node.minX), queryMaxX), _mm_cmpge_ps(_mm_loadu_ps(node.maxX), queryMinX));
+        hit = _mm_and_ps(hit, _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(node.minY), queryMaxY), _mm_cmpge_ps(_mm_loadu_ps(node.maxY), queryMinY)));
+        hit = _mm_and_ps(hit, _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(node.minZ), queryMaxZ), _mm_cmpge_ps(_mm_loadu_ps(node.maxZ), queryMinZ)));
+        const int hitMask = _mm_movemask_ps(hit);
+
+        for (int slot = 0; slot < Width; ++slot) {
+            const int32_t child = node.child[slot];
+            if (child == Empty || !(hitMask & (1 << slot)))
+                continue;
+            if (child >= 0) {
+                stack[top++] = child;
+                continue;
+            }
+            const Leaf& leaf = tree.leaves[~child];
+            for (uint32_t i = leaf.first; i < leaf.first + leaf.count; ++i)
+                if (overlaps(tree.boxes[tree.objects[i]], box))
+                    objects.push_back(tree.objects[i]);
+        }
+    }
+}
+
+bool Bvh::raycast(const Tree& tree, const Ray& ray, Hit& hit) {
+    if (tree.nodes.empty())
+        return false;
+
+    // zero components become infinities, which the slab test handles
+    const glm::vec3 inverse = 1.0f / ray.direction;
+    const __m128 originX = _mm_set1_ps(ray.origin.x), inverseX = _mm_set1_ps(inverse.x);
+    const __m128 originY = _mm_set1_ps(ray.origin.y), inverseY = _mm_set1_ps(inverse.y);
+    const __m128 originZ = _mm_set1_ps(ray.origin.z), inverseZ = _mm_set1_ps(inverse.z);
+
+    float best = ray.maxDistance;
+    bool found = false;
+
+    int32_t stack[StackSize];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        const Node& node = tree.nodes[stack[--top]];
+
+        __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.minX), originX), inverseX);
+        __m128 t2 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.maxX), originX), inverseX);
+        __m128 enter = _mm_min_ps(t1, t2), exit = _mm_max_ps(t1, t2);
+        t1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.minY), originY), inverseY);
+        t2 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.maxY), originY), inverseY);
+        enter = _mm_max_ps(enter, _mm_min_ps(t1, t2));
+        exit = _mm_min_ps(exit, _mm_max_ps(t1, t2));
+        t1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.minZ), originZ), inverseZ);
+        t2 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.maxZ), originZ), inverseZ);
+        enter = _mm_max_ps(_mm_max_ps(enter, _mm_min_ps(t1, t2)), _mm_setzero_ps());
+        exit = _mm_min_ps(_mm_min_ps(exit, _mm_max_ps(t1, t2)), _mm_set1_ps(best));
+        const int hitMask = _mm_movemask_ps(_mm_cmple_ps(enter, exit));
+
+        float entries[Width];
+        _mm_storeu_ps(entries, enter);
+
+        // push the far children first so the near ones are popped first
+        int order[Width] = { 0, 1, 2, 3 };
+        std::sort(order, order + Width, [&](int a, int b) { return entries[a] > entries[b]; });
+        for (int slot : order) {
+            const int32_t child = node.child[slot];
+            if (child == Empty || !(hitMask & (1 << slot)))
+                continue;
+            if (child >= 0) {
+                stack[top++] = child;
+                continue;
+            }
+            const Leaf& leaf = tree.leaves[~child];
+            for (uint32_t i = leaf.first; i < leaf.first + leaf.count; ++i) {
+                float distance;
+                Ray bounded = ray;
+                bounded.maxDistance = best;
+                if (rayBox(bounded, inverse, tree.boxes[tree.objects[i]], distance) && distance < best) {
+                    best = distance;
+                    hit.object = tree.objects[i];
+                    hit.distance = distance;
+                    found = true;
+                }
+            }
+        }
+    }
+    return found;
+}
+
+Bvh::Ray Bvh::screenRay(const glm::mat4& view, const glm::mat4& proj, float x, float y, int width, int height) {
+    const glm::vec4 viewport(0.0f, 0.0f, float(width), float(height));
+    const float windowY = float(height) - y;
+    glm::vec3 nearPoint = glm::unProject(glm::vec3(x, windowY, 0.0f), view, proj, viewport);
+    glm::vec3 farPoint = glm::unProject(glm::vec3(x, windowY, 1.0f), view, proj, viewport);
+
+    Ray ray;
+    ray.origin = nearPoint;
+    ray.direction = glm::normalize(farPoint - nearPoint);
+    ray.maxDistance = glm::length(farPoint - nearPoint);
+    return ray;
+}
+
+void Bvh::benchmark() {
+    const glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+    const glm::mat4 proj = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+    const FrustumCulling::Frustum frustum = FrustumCulling::extract(proj * view);
+
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+    std::uniform_real_distribution<float> size(0.1f, 2.0f);
+    std::uniform_real_distribution<float> jitter(-0.5f, 0.5f);
+
+    auto msSince = [](std::chrono::high_resolution_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    };
+
+    std::cout << "BVH" << Width << ", times in ms" << std::endl;
+    for (size_t count : { size_t(10000), size_t(100000), size_t(1000000) }) {
+        std::vector<Aabb> boxes(count);
+        FrustumCulling::Bounds flat;
+        for (Aabb& box : boxes) {
+            glm::vec3 center(position(random), position(random), position(random));
+            glm::vec3 extent(size(random), size(random), size(random));
+            box = { center - extent, center + extent };
+            FrustumCulling::add(flat, center, extent);
+        }
+
+        Tree tree;
+        auto start = std::chrono::high_resolution_clock::now();
+        build(tree, boxes);
+        const double buildMs = msSince(start);
+
+        for (Aabb& box : boxes) {
+            glm::vec3 move(jitter(random), jitter(random), jitter(random));
+            box.min += move;
+            box.max += move;
+        }
+        start = std::chrono::high_resolution_clock::now();
+        refit(tree, boxes);
+        const double refitMs = msSince(start);
+
+        std::vector<uint32_t> visible;
+        start = std::chrono::high_resolution_clock::now();
+        queryFrustum(tree, frustum, visible);
+        const double frustumMs = msSince(start);
+
+        std::vector<uint32_t> flatVisible;
+        FrustumCulling::Options options;
+        options.threads = 1;
+        start = std::chrono::high_resolution_clock::now();
+        FrustumCulling::cull(frustum, flat, flatVisible, options);
+        const double flatMs = msSince(start);
+
+        const int rays = 1000;
+        int hits = 0;
+        start = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < rays; ++i) {
+            Ray ray;
+            ray.origin = glm::vec3(0.0f);
+            ray.direction = glm::normalize(glm::vec3(jitter(random), jitter(random), jitter(random)));
+            Hit hit;
+            hits += raycast(tree, ray, hit);
+        }
+        const double rayMs = msSince(start) / rays;
+
+        std::cout << "  " << count << " objects: build " << buildMs << ", refit " << refitMs << " (cost x" << tree.cost / tree.builtCost
+                  << "), frustum " << frustumMs << " (" << visible.size() << " hits; flat SIMD cull " << flatMs
+                  << " on unmoved boxes), ray " << rayMs * 1000.0 << " us (" << hits << "/" << rays << " hit)" << std::endl;
+    }
+}
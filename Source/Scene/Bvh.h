@@ -0,0 +1,88 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+#include "FrustumCulling.h"
+
+// Bounding volume hierarchy over object boxes. Built top down with a binned
+// surface area heuristic, then collapsed into four-wide nodes whose child
+// boxes sit side by side, so one SSE test covers a whole node. Moving
+// objects are handled by refitting the boxes in place; once refits have
+// loosened the tree past rebuildRatio of its built cost, update() rebuilds.
+// Deep branches fall back to median splits, which bounds the depth and so
+// the fixed traversal stacks of the queries.
+namespace Bvh {
+
+    struct Aabb {
+        glm::vec3 min;
+        glm::vec3 max;
+    };
+
+    struct Ray {
+        glm::vec3 origin;
+        glm::vec3 direction;        // need not be normalized, distances are in its units
+        float maxDistance = 1e30f;
+    };
+
+    struct Hit {
+        uint32_t object = 0;
+        float distance = 0.0f;
+    };
+
+    const int Width = 4;
+    const int MaxLeafSize = 4;
+
+    // Child slots are inner node indices when >= 0, ~leaf index when
+    // negative, or Empty
+    const int32_t Empty = INT32_MIN;
+
+    struct Node {
+        float minX[Width], minY[Width], minZ[Width];
+        float maxX[Width], maxY[Width], maxZ[Width];
+        int32_t child[Width];
+    };
+
+    struct Leaf {
+        uint32_t first;     // into Tree::objects
+        uint32_t count;
+    };
+
+    struct Tree {
+        std::vector<Node> nodes;        // depth first, parents before children
+        std::vector<Leaf> leaves;
+        std::vector<uint32_t> objects;  // object ids grouped by leaf
+        std::vector<Aabb> boxes;        // per object id
+        float builtCost = 0.0f;
+        float cost = 0.0f;              // after the latest refit
+        float rebuildRatio = 1.5f;
+        int builds = 0;
+        int refits = 0;
+    };
+
+    void build(Tree& tree, const std::vector<Aabb>& boxes);
+
+    // Same objects, new boxes. Keeps the topology, only grows and shrinks boxes.
+    void refit(Tree& tree, const std::vector<Aabb>& boxes);
+
+    // Refits, and rebuilds when the tree has degraded too far. Returns true
+    // when it rebuilt.
+    bool update(Tree& tree, const std::vector<Aabb>& boxes);
+
+    // Appends objects whose boxes touch the frustum
+    void queryFrustum(const Tree& tree, const FrustumCulling::Frustum& frustum, std::vector<uint32_t>& objects);
+
+    // Appends objects whose boxes overlap the box
+    void queryOverlap(const Tree& tree, const Aabb& box, std::vector<uint32_t>& objects);
+
+    // Nearest object box along the ray
+    bool raycast(const Tree& tree, const Ray& ray, Hit& hit);
+
+    // Ray through a window pixel, cursor coordinates with y down
+    Ray screenRay(const glm::mat4& view, const glm::mat4& proj, float x, float y, int width, int height);
+
+    // Build, refit and query times against brute force on random boxes
+    void benchmark();
+}
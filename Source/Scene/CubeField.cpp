@@ -0,0 +1,38 @@
+#include "CubeField.h"
+
+#include <cmath>
+
+void CubeField::create(Field& field, int perSide, float spacing, float clearRadius) {
+    field.positions.clear();
+    field.phases.clear();
+
+    const float half = (perSide - 1) * spacing * 0.5f;
+    for (int y = 0; y < perSide; ++y) {
+        for (int x = 0; x < perSide; ++x) {
+            glm::vec3 position(x * spacing - half, y * spacing - half, -0.5f + field.size * 0.5f);
+            if (std::fabs(position.x) < clearRadius && std::fabs(position.y) < clearRadius)
+                continue;
+            field.positions.push_back(position);
+            // a cheap hash so neighbours don't move in lockstep
+            field.phases.push_back(std::fmod((x * 12.9898f + y * 78.233f) * 43.758f, 6.2831853f));
+        }
+    }
+}
+
+void CubeField::pose(const Field& field, int index, float time, glm::vec3& position, glm::quat& rotation) {
+    const float phase = field.phases[index];
+    position = field.positions[index];
+    position.z += field.size * (0.5f + 0.5f * std::sin(time * 2.0f + phase));
+    rotation = glm::angleAxis(time + phase, glm::vec3(0.0f, 0.0f, 1.0f));
+}
+
+glm::vec4 CubeField::color(const Field& field, int index) {
+    const float phase = field.phases[index];
+    return glm::vec4(0.75f + 0.25f * std::sin(phase), 0.75f + 0.25f * std::sin(phase + 2.1f), 0.75f + 0.25f * std::sin(phase + 4.2f), 1.0f);
+}
+
+void CubeField::bounds(const Field& field, int index, glm::vec3& center, glm::vec3& extents) {
+    // spinning about z sweeps out the half diagonal, bobbing adds a size in z
+    center = field.positions[index] + glm::vec3(0.0f, 0.0f, field.size * 0.5f);
+    extents = glm::vec3(field.size * 0.7072f, field.size * 0.7072f, field.size);
+}
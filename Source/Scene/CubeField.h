@@ -0,0 +1,29 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <vector>
+
+// Grid of small cubes around the floor, each bobbing on its own phase.
+// There to give the draw path a few thousand objects to chew on.
+namespace CubeField {
+
+    struct Field {
+        std::vector<glm::vec3> positions;   // resting centres
+        std::vector<float> phases;
+        float size = 0.08f;                 // edge length
+    };
+
+    // perSide x perSide cubes spaced apart on the floor plane, leaving a
+    // square of clearRadius around the origin empty
+    void create(Field& field, int perSide, float spacing, float clearRadius);
+
+    // Local transform at a point in time, scale is field.size
+    void pose(const Field& field, int index, float time, glm::vec3& position, glm::quat& rotation);
+    glm::vec4 color(const Field& field, int index);
+
+    // Box enclosing the cube over its whole bob and spin, so it never
+    // needs updating
+    void bounds(const Field& field, int index, glm::vec3& center, glm::vec3& extents);
+}
@@ -0,0 +1,36 @@
+#include "FixedTimestep.h"
+
+#include <algorithm>
+#include <iostream>
+
+void FixedTimestep::setRate(Clock& clock, double hz) {
+    clock.step = 1.0 / std::max(hz, 1.0);
+}
+
+int FixedTimestep::advance(Clock& clock, double frameSeconds) {
+    clock.frames++;
+    clock.accumulator += std::max(frameSeconds, 0.0);
+
+    int steps = int(clock.accumulator / clock.step);
+    if (steps > clock.maxStepsPerFrame) {
+        // a hitch (breakpoint, window drag) would otherwise spiral
+        const double excess = (steps - clock.maxStepsPerFrame) * clock.step;
+        clock.droppedSeconds += excess;
+        clock.accumulator -= excess;
+        steps = clock.maxStepsPerFrame;
+    }
+
+    clock.accumulator -= steps * clock.step;
+    clock.time += steps * clock.step;
+    clock.steps += steps;
+    return steps;
+}
+
+float FixedTimestep::alpha(const Clock& clock) {
+    return float(std::clamp(clock.accumulator / clock.step, 0.0, 1.0));
+}
+
+void FixedTimestep::printStats(const Clock& clock) {
+    std::cout << "Simulation: " << int(1.0 / clock.step + 0.5) << " Hz, " << clock.steps << " steps over " << clock.frames << " frames ("
+              << (clock.frames > 0 ? double(clock.steps) / clock.frames : 0.0) << " per frame), " << clock.droppedSeconds << " s dropped" << std::endl;
+}
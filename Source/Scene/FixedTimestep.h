@@ -0,0 +1,29 @@
+#pragma once
+
+// Runs the simulation in fixed steps no matter how fast frames come. Each
+// frame feeds its real duration in, gets back how many steps to run, and
+// afterwards renders at alpha() between the last two simulated states.
+// When frames are so slow that more than maxStepsPerFrame would be due, the
+// extra time is dropped instead of trying to catch up.
+namespace FixedTimestep {
+
+    struct Clock {
+        double step = 1.0 / 60.0;       // seconds
+        int maxStepsPerFrame = 8;
+        double accumulator = 0.0;
+        double time = 0.0;              // simulated seconds
+        long long steps = 0;
+        long long frames = 0;
+        double droppedSeconds = 0.0;
+    };
+
+    void setRate(Clock& clock, double hz);
+
+    // Returns how many steps the caller should simulate now
+    int advance(Clock& clock, double frameSeconds);
+
+    // How far between the previous and the latest state to render, 0..1
+    float alpha(const Clock& clock);
+
+    void printStats(const Clock& clock);
+}
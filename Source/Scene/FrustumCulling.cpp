@@ -0,0 +1,253 @@
+#include "FrustumCulling.h"
+
+#include "../Jobs/JobSystem.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <random>
+
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// MSVC takes AVX2 intrinsics anywhere, GCC and Clang only in functions built for it
+#if defined(__GNUC__)
+#define TARGET_AVX2 __attribute__((target("avx2,fma")))
+#else
+#define TARGET_AVX2
+#endif
+
+namespace {
+
+    using FrustumCulling::Bounds;
+    using FrustumCulling::Frustum;
+    using FrustumCulling::Shape;
+
+    template<Shape shape>
+    size_t cullScalar(const Frustum& frustum, const Bounds& bounds, size_t begin, size_t end, uint32_t* out) {
+        size_t count = 0;
+        for (size_t i = begin; i < end; ++i) {
+            bool inside = true;
+            for (const glm::vec4& plane : frustum.planes) {
+                float distance = plane.x * bounds.centerX[i] + plane.y * bounds.centerY[i] + plane.z * bounds.centerZ[i] + plane.w;
+                float reach = shape == Shape::Spheres ? bounds.radius[i]
+                    : std::fabs(plane.x) * bounds.extentX[i] + std::fabs(plane.y) * bounds.extentY[i] + std::fabs(plane.z) * bounds.extentZ[i];
+                if (distance + reach < 0.0f) {
+                    inside = false;
+                    break;
+                }
+            }
+            if (inside)
+                out[count++] = uint32_t(i);
+        }
+        return count;
+    }
+
+    template<Shape shape>
+    TARGET_AVX2 size_t cullAvx2(const Frustum& frustum, const Bounds& bounds, size_t begin, size_t end, uint32_t* out) {
+        const __m256 signMask = _mm256_set1_ps(-0.0f);
+        const __m256 zero = _mm256_setzero_ps();
+
+        __m256 nx[6], ny[6], nz[6], nw[6], ax[6], ay[6], az[6];
+        for (int p = 0; p < 6; ++p) {
+            nx[p] = _mm256_set1_ps(frustum.planes[p].x);
+            ny[p] = _mm256_set1_ps(frustum.planes[p].y);
+            nz[p] = _mm256_set1_ps(frustum.planes[p].z);
+            nw[p] = _mm256_set1_ps(frustum.planes[p].w);
+            ax[p] = _mm256_andnot_ps(signMask, nx[p]);
+            ay[p] = _mm256_andnot_ps(signMask, ny[p]);
+            az[p] = _mm256_andnot_ps(signMask, nz[p]);
+        }
+
+        size_t count = 0;
+        size_t i = begin;
+        for (; i + 8 <= end; i += 8) {
+            const __m256 cx = _mm256_loadu_ps(&bounds.centerX[i]);
+            const __m256 cy = _mm256_loadu_ps(&bounds.centerY[i]);
+            const __m256 cz = _mm256_loadu_ps(&bounds.centerZ[i]);
+            __m256 ex = zero, ey = zero, ez = zero, radius = zero;
+            if (shape == Shape::Spheres) {
+                radius = _mm256_loadu_ps(&bounds.radius[i]);
+            } else {
+                ex = _mm256_loadu_ps(&bounds.extentX[i]);
+                ey = _mm256_loadu_ps(&bounds.extentY[i]);
+                ez = _mm256_loadu_ps(&bounds.extentZ[i]);
+            }
+
+            // no early out, all six planes cost less than the branches would
+            __m256 outside = zero;
+            for (int p = 0; p < 6; ++p) {
+                __m256 distance = _mm256_fmadd_ps(nx[p], cx, _mm256_fmadd_ps(ny[p], cy, _mm256_fmadd_ps(nz[p], cz, nw[p])));
+                __m256 reach = shape == Shape::Spheres ? radius
+                    : _mm256_fmadd_ps(ax[p], ex, _mm256_fmadd_ps(ay[p], ey, _mm256_mul_ps(az[p], ez)));
+                outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(distance, reach), zero, _CMP_LT_OQ));
+            }
+
+            unsigned mask = ~unsigned(_mm256_movemask_ps(outside)) & 0xFFu;
+            while (mask) {
+                out[count++] = uint32_t(i + std::countr_zero(mask));
+                mask &= mask - 1;
+            }
+        }
+
+        return count + cullScalar<shape>(frustum, bounds, i, end, out + count);
+    }
+
+    size_t cullRange(const Frustum& frustum, const Bounds& bounds, Shape shape, bool simd, size_t begin, size_t end, uint32_t* out) {
+        if (simd)
+            return shape == Shape::Spheres ? cullAvx2<Shape::Spheres>(frustum, bounds, begin, end, out)
+                                           : cullAvx2<Shape::Boxes>(frustum, bounds, begin, end, out);
+        return shape == Shape::Spheres ? cullScalar<Shape::Spheres>(frustum, bounds, begin, end, out)
+                                       : cullScalar<Shape::Boxes>(frustum, bounds, begin, end, out);
+    }
+
+    bool detectAvx2() {
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7)
+            return false;
+        __cpuid(info, 1);
+        const bool osSavesYmm = (info[2] & (1 << 27)) && (_xgetbv(0) & 6) == 6;
+        const bool fma = info[2] & (1 << 12);
+        __cpuidex(info, 7, 0);
+        return osSavesYmm && fma && (info[1] & (1 << 5));
+#else
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+    }
+}
+
+FrustumCulling::Frustum FrustumCulling::extract(const glm::mat4& viewProj) {
+    // glm is column major, row i of the matrix is (m[0][i], m[1][i], m[2][i], m[3][i])
+    auto row = [&](int i) { return glm::vec4(viewProj[0][i], viewProj[1][i], viewProj[2][i], viewProj[3][i]); };
+
+    Frustum frustum;
+    frustum.planes[0] = row(3) + row(0);    // left
+    frustum.planes[1] = row(3) - row(0);    // right
+    frustum.planes[2] = row(3) + row(1);    // bottom
+    frustum.planes[3] = row(3) - row(1);    // top
+    frustum.planes[4] = row(3) + row(2);    // near
+    frustum.planes[5] = row(3) - row(2);    // far
+    for (glm::vec4& plane : frustum.planes)
+        plane /= glm::length(glm::vec3(plane));
+    return frustum;
+}
+
+void FrustumCulling::add(Bounds& bounds, const glm::vec3& center, const glm::vec3& extents) {
+    bounds.centerX.push_back(center.x);
+    bounds.centerY.push_back(center.y);
+    bounds.centerZ.push_back(center.z);
+    bounds.extentX.push_back(extents.x);
+    bounds.extentY.push_back(extents.y);
+    bounds.extentZ.push_back(extents.z);
+    bounds.radius.push_back(glm::length(extents));
+}
+
+void FrustumCulling::set(Bounds& bounds, size_t index, const glm::vec3& center, const glm::vec3& extents) {
+    bounds.centerX[index] = center.x;
+    bounds.centerY[index] = center.y;
+    bounds.centerZ[index] = center.z;
+    bounds.extentX[index] = extents.x;
+    bounds.extentY[index] = extents.y;
+    bounds.extentZ[index] = extents.z;
+    bounds.radius[index] = glm::length(extents);
+}
+
+void FrustumCulling::clear(Bounds& bounds) {
+    bounds = Bounds();
+}
+
+bool FrustumCulling::simdSupported() {
+    static const bool supported = detectAvx2();
+    return supported;
+}
+
+size_t FrustumCulling::cull(const Frustum& frustum, const Bounds& bounds, std::vector<uint32_t>& visible, const Options& options) {
+    const size_t count = bounds.size();
+    const bool simd = options.allowSimd && simdSupported();
+    visible.resize(count);
+
+    int threads = options.threads;
+    if (threads == 0)
+        threads = count >= ParallelThreshold ? JobSystem::threadCount() : 1;
+
+    if (threads <= 1) {
+        visible.resize(cullRange(frustum, bounds, options.shape, simd, 0, count, visible.data()));
+        return visible.size();
+    }
+
+    // each chunk writes from its own start, then the pieces are slid together
+    const size_t chunk = ((count + threads - 1) / threads + 7) / 8 * 8;
+    const size_t chunks = (count + chunk - 1) / chunk;
+    std::vector<size_t> found(chunks);
+    JobSystem::parallelFor(chunks, 1, [&](size_t first, size_t last) {
+        for (size_t c = first; c < last; ++c) {
+            const size_t begin = c * chunk;
+            found[c] = cullRange(frustum, bounds, options.shape, simd, begin, std::min(begin + chunk, count), visible.data() + begin);
+        }
+    });
+
+    size_t total = 0;
+    for (size_t c = 0; c < chunks; ++c) {
+        memmove(visible.data() + total, visible.data() + c * chunk, found[c] * sizeof(uint32_t));
+        total += found[c];
+    }
+    visible.resize(total);
+    return total;
+}
+
+void FrustumCulling::benchmark() {
+    const glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+    const glm::mat4 proj = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+    const Frustum frustum = extract(proj * view);
+    const int jobThreads = JobSystem::threadCount();
+
+    std::cout << "Frustum culling, objects per ms (" << (simdSupported() ? "AVX2" : "no AVX2") << ", "
+              << jobThreads << " threads)" << std::endl;
+
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+    std::uniform_real_distribution<float> size(0.1f, 2.0f);
+
+    for (size_t objects : { size_t(1000), size_t(10000), size_t(100000), size_t(1000000) }) {
+        Bounds bounds;
+        for (size_t i = 0; i < objects; ++i)
+            add(bounds, glm::vec3(position(random), position(random), position(random)), glm::vec3(size(random), size(random), size(random)));
+
+        for (Shape shape : { Shape::Spheres, Shape::Boxes }) {
+            struct Path { const char* name; bool simd; int threads; };
+            const Path paths[] = { { "scalar", false, 1 }, { "AVX2", true, 1 }, { "AVX2 threaded", true, jobThreads } };
+
+            std::cout << "  " << objects << (shape == Shape::Spheres ? " spheres:" : " boxes:");
+            std::vector<uint32_t> visible;
+            for (const Path& path : paths) {
+                if (path.simd && !simdSupported())
+                    continue;
+                Options options;
+                options.shape = shape;
+                options.allowSimd = path.simd;
+                options.threads = path.threads;
+
+                // repeat until the timing is long enough to mean something
+                int runs = 0;
+                double ms = 0.0;
+                auto start = std::chrono::high_resolution_clock::now();
+                while (runs < 3 || ms < 100.0) {
+                    cull(frustum, bounds, visible, options);
+                    runs++;
+                    ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+                }
+                std::cout << "  " << path.name << " " << std::lround(objects * runs / ms);
+            }
+            std::cout << "  (" << visible.size() * 100 / objects << "% visible)" << std::endl;
+        }
+    }
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+// View frustum culling over bounds kept as structure of arrays. The AVX2
+// path tests eight objects per iteration against all six planes, large sets
+// are split across threads, and the result is a compact list of visible
+// indices in ascending order. AVX2 is picked at runtime, so the project
+// does not need /arch:AVX2; other CPUs get the scalar loop.
+namespace FrustumCulling {
+
+    // Planes point inwards and are normalized: dot(xyz, p) + w >= 0 inside
+    struct Frustum {
+        glm::vec4 planes[6];
+    };
+
+    // Gribb/Hartmann extraction from proj * view, works in world space
+    Frustum extract(const glm::mat4& viewProj);
+
+    enum class Shape {
+        Spheres,    // centre and radius, cheapest test
+        Boxes       // centre and half extents, tighter
+    };
+
+    struct Bounds {
+        std::vector<float> centerX, centerY, centerZ;
+        std::vector<float> extentX, extentY, extentZ;   // AABB half sizes
+        std::vector<float> radius;                      // encloses the AABB
+        size_t size() const { return centerX.size(); }
+    };
+
+    void add(Bounds& bounds, const glm::vec3& center, const glm::vec3& extents);
+    void set(Bounds& bounds, size_t index, const glm::vec3& center, const glm::vec3& extents);
+    void clear(Bounds& bounds);
+
+    // Sets at least this big are split across threads
+    const size_t ParallelThreshold = 64 * 1024;
+
+    struct Options {
+        Shape shape = Shape::Boxes;
+        bool allowSimd = true;
+        int threads = 0;        // 0 uses every job system thread when above the threshold
+    };
+
+    // Replaces visible with the indices of the objects inside or crossing
+    // the frustum. Returns how many there are.
+    size_t cull(const Frustum& frustum, const Bounds& bounds, std::vector<uint32_t>& visible, const Options& options = Options());
+
+    bool simdSupported();
+
+    // Times the scalar, AVX2 and threaded paths on random bounds and prints
+    // objects culled per millisecond
+    void benchmark();
+}
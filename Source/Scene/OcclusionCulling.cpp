@@ -0,0 +1,273 @@
+#include "OcclusionCulling.h"
+
+#include "../Jobs/JobSystem.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+#include <immintrin.h>
+
+namespace {
+
+    using OcclusionCulling::Culler;
+    using OcclusionCulling::Level;
+    using OcclusionCulling::Triangle;
+
+    // Returns false for triangles that cover no whole pixel
+    bool setup(const glm::vec4 clip[3], Triangle& triangle) {
+        glm::vec2 screen[3];
+        float depth[3];
+        for (int i = 0; i < 3; ++i) {
+            const glm::vec3 ndc = glm::vec3(clip[i]) / clip[i].w;
+            screen[i] = glm::vec2((ndc.x * 0.5f + 0.5f) * OcclusionCulling::Width, (ndc.y * 0.5f + 0.5f) * OcclusionCulling::Height);
+            depth[i] = ndc.z * 0.5f + 0.5f;
+        }
+
+        // the scene's meshes don't keep a consistent winding, so both sides
+        // occlude; clockwise ones are flipped to counter-clockwise
+        glm::vec2 e1 = screen[1] - screen[0];
+        glm::vec2 e2 = screen[2] - screen[0];
+        float area = e1.x * e2.y - e1.y * e2.x;
+        if (area == 0.0f)
+            return false;
+        if (area < 0.0f) {
+            std::swap(screen[1], screen[2]);
+            std::swap(depth[1], depth[2]);
+            std::swap(e1, e2);
+            area = -area;
+        }
+
+        for (int i = 0; i < 3; ++i) {
+            const glm::vec2& from = screen[i];
+            const glm::vec2& to = screen[(i + 1) % 3];
+            const float a = from.y - to.y;
+            const float b = to.x - from.x;
+            // evaluated at pixel centres, this many units in means the whole pixel is inside
+            triangle.edge[i] = glm::vec3(a, b, -(a * from.x + b * from.y) - 0.5f * (std::abs(a) + std::abs(b)));
+        }
+
+        const float dz1 = depth[1] - depth[0], dz2 = depth[2] - depth[0];
+        const float za = (dz1 * e2.y - dz2 * e1.y) / area;
+        const float zb = (dz2 * e1.x - dz1 * e2.x) / area;
+        triangle.depth = glm::vec3(za, zb, depth[0] - za * screen[0].x - zb * screen[0].y + 0.5f * (std::abs(za) + std::abs(zb)));
+
+        const glm::vec2 minimum = glm::min(screen[0], glm::min(screen[1], screen[2]));
+        const glm::vec2 maximum = glm::max(screen[0], glm::max(screen[1], screen[2]));
+        triangle.minX = std::max(0, int(std::ceil(minimum.x - 0.5f)));
+        triangle.minY = std::max(0, int(std::ceil(minimum.y - 0.5f)));
+        triangle.maxX = std::min(OcclusionCulling::Width - 1, int(std::floor(maximum.x - 0.5f)));
+        triangle.maxY = std::min(OcclusionCulling::Height - 1, int(std::floor(maximum.y - 0.5f)));
+        return triangle.minX <= triangle.maxX && triangle.minY <= triangle.maxY;
+    }
+
+    // Keeps the nearest occluder depth per pixel, four pixels at a time
+    void rasterTile(Culler& culler, int tileX, int tileY) {
+        const int tileX0 = tileX * OcclusionCulling::TileWidth, tileY0 = tileY * OcclusionCulling::TileHeight;
+        const int tileX1 = tileX0 + OcclusionCulling::TileWidth - 1, tileY1 = tileY0 + OcclusionCulling::TileHeight - 1;
+        float* depth = culler.levels[0].farthest.data();
+        const __m128 lanes = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+        const __m128 zero = _mm_setzero_ps();
+
+        for (const Triangle& triangle : culler.triangles) {
+            const int minX = std::max(triangle.minX, tileX0) & ~3, maxX = std::min(triangle.maxX, tileX1);
+            const int minY = std::max(triangle.minY, tileY0), maxY = std::min(triangle.maxY, tileY1);
+            if (minX > maxX || minY > maxY)
+                continue;
+
+            __m128 a[3], step[3];
+            for (int e = 0; e < 3; ++e) {
+                a[e] = _mm_set1_ps(triangle.edge[e].x);
+                step[e] = _mm_set1_ps(triangle.edge[e].x * 4.0f);
+            }
+            const __m128 za = _mm_set1_ps(triangle.depth.x), zStep = _mm_set1_ps(triangle.depth.x * 4.0f);
+
+            for (int y = minY; y <= maxY; ++y) {
+                const float py = y + 0.5f;
+                const __m128 px = _mm_add_ps(_mm_set1_ps(float(minX)), lanes);
+                __m128 edge[3];
+                for (int e = 0; e < 3; ++e)
+                    edge[e] = _mm_add_ps(_mm_mul_ps(a[e], px), _mm_set1_ps(triangle.edge[e].y * py + triangle.edge[e].z));
+                __m128 z = _mm_add_ps(_mm_mul_ps(za, px), _mm_set1_ps(triangle.depth.y * py + triangle.depth.z));
+
+                float* row = depth + size_t(y) * OcclusionCulling::Width;
+                for (int x = minX; x <= maxX; x += 4) {
+                    const __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(edge[0], zero), _mm_cmpge_ps(edge[1], zero)), _mm_cmpge_ps(edge[2], zero));
+                    if (_mm_movemask_ps(inside)) {
+                        const __m128 old = _mm_loadu_ps(row + x);
+                        const __m128 nearer = _mm_min_ps(old, z);
+                        _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearer), _mm_andnot_ps(inside, old)));
+                    }
+                    for (int e = 0; e < 3; ++e)
+                        edge[e] = _mm_add_ps(edge[e], step[e]);
+                    z = _mm_add_ps(z, zStep);
+                }
+            }
+        }
+    }
+
+    void buildHierarchy(Culler& culler) {
+        Level& base = culler.levels[0];
+        base.nearest = base.farthest;
+        for (size_t l = 1; l < culler.levels.size(); ++l) {
+            const Level& fine = culler.levels[l - 1];
+            Level& coarse = culler.levels[l];
+            for (int y = 0; y < coarse.height; ++y) {
+                const int y0 = std::min(2 * y, fine.height - 1), y1 = std::min(2 * y + 1, fine.height - 1);
+                for (int x = 0; x < coarse.width; ++x) {
+                    const int x0 = std::min(2 * x, fine.width - 1), x1 = std::min(2 * x + 1, fine.width - 1);
+                    const size_t i00 = size_t(y0) * fine.width + x0, i10 = size_t(y0) * fine.width + x1;
+                    const size_t i01 = size_t(y1) * fine.width + x0, i11 = size_t(y1) * fine.width + x1;
+                    coarse.nearest[size_t(y) * coarse.width + x] = std::min(std::min(fine.nearest[i00], fine.nearest[i10]), std::min(fine.nearest[i01], fine.nearest[i11]));
+                    coarse.farthest[size_t(y) * coarse.width + x] = std::max(std::max(fine.farthest[i00], fine.farthest[i10]), std::max(fine.farthest[i01], fine.farthest[i11]));
+                }
+            }
+        }
+    }
+
+    double since(std::chrono::high_resolution_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+
+    // Refining past this many texels costs more than drawing the object
+    const int MaxTexels = 256;
+}
+
+void OcclusionCulling::begin(Culler& culler, const glm::mat4& viewProj) {
+    if (culler.levels.empty()) {
+        int width = Width, height = Height;
+        while (true) {
+            Level level;
+            level.width = width;
+            level.height = height;
+            level.nearest.resize(size_t(width) * height);
+            level.farthest.resize(size_t(width) * height);
+            culler.levels.push_back(std::move(level));
+            if (width == 1 && height == 1)
+                break;
+            width = std::max(1, width / 2);
+            height = std::max(1, height / 2);
+        }
+    }
+    std::fill(culler.levels[0].farthest.begin(), culler.levels[0].farthest.end(), 1.0f);
+    culler.viewProj = viewProj;
+    culler.triangles.clear();
+    culler.stats.occluderTriangles = 0;
+}
+
+void OcclusionCulling::addOccluder(Culler& culler, const glm::mat4& model, const float* vertices, int vertexCount, int floatsPerVertex) {
+    const glm::mat4 transform = culler.viewProj * model;
+    for (int first = 0; first + 2 < vertexCount; first += 3) {
+        glm::vec4 clip[3];
+        bool crossesNear = false;
+        for (int i = 0; i < 3; ++i) {
+            const float* v = vertices + size_t(first + i) * floatsPerVertex;
+            clip[i] = transform * glm::vec4(v[0], v[1], v[2], 1.0f);
+            crossesNear |= clip[i].z < -clip[i].w;
+        }
+        // clipping would only give a smaller occluder, leaving it out is still correct
+        Triangle triangle;
+        if (!crossesNear && setup(clip, triangle))
+            culler.triangles.push_back(triangle);
+    }
+    culler.stats.occluderTriangles = culler.triangles.size();
+}
+
+void OcclusionCulling::finish(Culler& culler) {
+    auto start = std::chrono::high_resolution_clock::now();
+    const int tilesX = Width / TileWidth, tilesY = Height / TileHeight;
+    JobSystem::parallelFor(size_t(tilesX * tilesY), 1, [&](size_t begin, size_t end) {
+        for (size_t tile = begin; tile < end; ++tile)
+            rasterTile(culler, int(tile % tilesX), int(tile / tilesX));
+    });
+    culler.stats.rasterMs = since(start);
+
+    start = std::chrono::high_resolution_clock::now();
+    buildHierarchy(culler);
+    culler.stats.hierarchyMs = since(start);
+}
+
+bool OcclusionCulling::visible(const Culler& culler, const glm::vec3& center, const glm::vec3& extents) {
+    glm::vec2 minimum(1e30f), maximum(-1e30f);
+    float nearest = 1.0f;
+    for (int corner = 0; corner < 8; ++corner) {
+        const glm::vec3 sign((corner & 1) ? 1.0f : -1.0f, (corner & 2) ? 1.0f : -1.0f, (corner & 4) ? 1.0f : -1.0f);
+        const glm::vec4 clip = culler.viewProj * glm::vec4(center + sign * extents, 1.0f);
+        if (clip.z < -clip.w)
+            return true;
+        const glm::vec3 ndc = glm::vec3(clip) / clip.w;
+        const glm::vec2 screen((ndc.x * 0.5f + 0.5f) * Width, (ndc.y * 0.5f + 0.5f) * Height);
+        minimum = glm::min(minimum, screen);
+        maximum = glm::max(maximum, screen);
+        nearest = std::min(nearest, ndc.z * 0.5f + 0.5f);
+    }
+    if (maximum.x < 0.0f || maximum.y < 0.0f || minimum.x >= float(Width) || minimum.y >= float(Height))
+        return false;
+
+    // every pixel the box touches
+    const int x0 = std::clamp(int(std::floor(minimum.x)), 0, Width - 1), x1 = std::clamp(int(std::floor(maximum.x)), 0, Width - 1);
+    const int y0 = std::clamp(int(std::floor(minimum.y)), 0, Height - 1), y1 = std::clamp(int(std::floor(maximum.y)), 0, Height - 1);
+
+    // start where the box spans a couple of texels, go finer while undecided
+    int level = 0;
+    while (level + 1 < int(culler.levels.size()) && (std::max(x1 - x0, y1 - y0) >> level) >= 2)
+        level++;
+    for (; level >= 0; --level) {
+        const Level& hierarchy = culler.levels[level];
+        const int lx0 = x0 >> level, lx1 = x1 >> level, ly0 = y0 >> level, ly1 = y1 >> level;
+        if ((lx1 - lx0 + 1) * (ly1 - ly0 + 1) > MaxTexels)
+            return true;
+        float regionNearest = 1.0f, regionFarthest = 0.0f;
+        for (int y = ly0; y <= ly1; ++y) {
+            for (int x = lx0; x <= lx1; ++x) {
+                regionNearest = std::min(regionNearest, hierarchy.nearest[size_t(y) * hierarchy.width + x]);
+                regionFarthest = std::max(regionFarthest, hierarchy.farthest[size_t(y) * hierarchy.width + x]);
+            }
+        }
+        if (nearest > regionFarthest)
+            return false;
+        if (nearest <= regionNearest)
+            return true;
+    }
+    return true;
+}
+
+size_t OcclusionCulling::cull(Culler& culler, const FrustumCulling::Bounds& bounds, std::vector<uint32_t>& indices) {
+    auto start = std::chrono::high_resolution_clock::now();
+    std::vector<uint8_t> keep(indices.size());
+    JobSystem::parallelFor(indices.size(), 256, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const uint32_t object = indices[i];
+            const glm::vec3 center(bounds.centerX[object], bounds.centerY[object], bounds.centerZ[object]);
+            const glm::vec3 extents(bounds.extentX[object], bounds.extentY[object], bounds.extentZ[object]);
+            keep[i] = visible(culler, center, extents);
+        }
+    });
+
+    size_t kept = 0;
+    for (size_t i = 0; i < indices.size(); ++i)
+        if (keep[i])
+            indices[kept++] = indices[i];
+
+    Stats& stats = culler.stats;
+    stats.tested = indices.size();
+    stats.culled = indices.size() - kept;
+    stats.testMs = since(start);
+    stats.frames++;
+    stats.totalTested += stats.tested;
+    stats.totalCulled += stats.culled;
+    stats.totalMs += stats.rasterMs + stats.hierarchyMs + stats.testMs;
+    indices.resize(kept);
+    return stats.culled;
+}
+
+void OcclusionCulling::printStats(const Culler& culler) {
+    const Stats& stats = culler.stats;
+    if (stats.frames == 0)
+        return;
+    std::cout << "Occlusion culling: " << stats.totalCulled / stats.frames << " of " << stats.totalTested / stats.frames
+              << " frustum visible objects culled per frame, " << stats.totalMs / stats.frames << " ms per frame ("
+              << stats.occluderTriangles << " occluder triangles, last frame " << stats.rasterMs << " ms raster, "
+              << stats.hierarchyMs << " ms hierarchy, " << stats.testMs << " ms tests)" << std::endl;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+#include "FrustumCulling.h"
+
+// Software occlusion culling. A few big occluder meshes are rasterized into
+// a small CPU depth buffer, four pixels at a time with SSE and one job per
+// tile, then reduced into a min/max depth hierarchy that object bounds are
+// tested against before anything is submitted.
+//
+// Everything errs towards visible: a pixel only takes an occluder's depth
+// when the triangle covers all of it, and then the farthest depth over the
+// pixel, so an object is never culled by something that does not fully
+// hide it. Triangles crossing the near plane are skipped as occluders, and
+// boxes crossing it are always visible.
+namespace OcclusionCulling {
+
+    const int Width = 256;
+    const int Height = 128;
+    const int TileWidth = 64;
+    const int TileHeight = 32;
+
+    // Window depth, 0 near to 1 far; min and max over each texel's pixels
+    struct Level {
+        int width = 0;
+        int height = 0;
+        std::vector<float> nearest;
+        std::vector<float> farthest;
+    };
+
+    // Screen space triangle in buffer pixels, edges as a * x + b * y + c >= 0
+    // inside, already pulled in so the test passes only for fully covered pixels
+    struct Triangle {
+        glm::vec3 edge[3];
+        glm::vec3 depth;                // farthest depth over a pixel, same form
+        int minX, minY, maxX, maxY;
+    };
+
+    struct Stats {
+        size_t occluderTriangles = 0;   // last frame, after near plane rejection
+        size_t tested = 0;
+        size_t culled = 0;
+        double rasterMs = 0.0;
+        double hierarchyMs = 0.0;
+        double testMs = 0.0;
+
+        // since the start
+        size_t frames = 0;
+        size_t totalTested = 0;
+        size_t totalCulled = 0;
+        double totalMs = 0.0;
+    };
+
+    struct Culler {
+        glm::mat4 viewProj = glm::mat4(1.0f);
+        std::vector<Triangle> triangles;
+        std::vector<Level> levels;      // levels[0] is the depth buffer
+        Stats stats;
+    };
+
+    // Clears the buffer and starts collecting occluders for this camera
+    void begin(Culler& culler, const glm::mat4& viewProj);
+
+    // A closed triangle list, position first in each vertex like vertices.h
+    void addOccluder(Culler& culler, const glm::mat4& model, const float* vertices, int vertexCount, int floatsPerVertex);
+
+    // Rasterizes the occluders and builds the hierarchy
+    void finish(Culler& culler);
+
+    // False when the box is certainly hidden behind the occluders
+    bool visible(const Culler& culler, const glm::vec3& center, const glm::vec3& extents);
+
+    // Removes the hidden objects from a frustum culling result, keeping the
+    // order. Returns how many were removed.
+    size_t cull(Culler& culler, const FrustumCulling::Bounds& bounds, std::vector<uint32_t>& indices);
+
+    void printStats(const Culler& culler);
+}
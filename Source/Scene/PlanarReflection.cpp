@@ -0,0 +1,153 @@
+#include "PlanarReflection.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+    float sign(float value) {
+        return value > 0.0f ? 1.0f : (value < 0.0f ? -1.0f : 0.0f);
+    }
+
+    // Maps an NDC rectangle onto the whole of NDC
+    glm::mat4 crop(const glm::vec4& rect) {
+        const glm::vec2 size(rect.z - rect.x, rect.w - rect.y);
+        glm::mat4 m(1.0f);
+        m[0][0] = 2.0f / size.x;
+        m[1][1] = 2.0f / size.y;
+        m[3][0] = -(rect.x + rect.z) / size.x;
+        m[3][1] = -(rect.y + rect.w) / size.y;
+        return m;
+    }
+
+    void addViews(const std::vector<PlanarReflection::Mirror>& mirrors, const PlanarReflection::Settings& settings,
+                  const glm::mat4& cameraView, const glm::mat4& proj, int parent, std::vector<PlanarReflection::View>& views) {
+        using PlanarReflection::View;
+
+        const glm::mat4 parentView = parent < 0 ? cameraView : views[parent].view;
+        const glm::mat4 parentReflection = parent < 0 ? glm::mat4(1.0f) : views[parent].reflection;
+        const glm::vec4 parentRect = parent < 0 ? glm::vec4(-1.0f, -1.0f, 1.0f, 1.0f) : views[parent].rect;
+        const int depth = parent < 0 ? 1 : views[parent].depth + 1;
+        const glm::vec3 eye = glm::vec3(glm::inverse(parentView)[3]);
+
+        for (int m = 0; m < int(mirrors.size()); ++m) {
+            if (int(views.size()) >= settings.maxViews)
+                return;
+            // a flat mirror never sees itself
+            if (parent >= 0 && views[parent].mirror == m)
+                continue;
+
+            const glm::vec4 plane = PlanarReflection::plane(mirrors[m]);
+            if (glm::dot(plane, glm::vec4(eye, 1.0f)) <= 0.0f)
+                continue;
+            if (parent >= 0) {
+                // behind the parent's glass it is clipped away
+                bool inFront = false;
+                for (const glm::vec3& corner : mirrors[m].corners)
+                    inFront = inFront || glm::dot(views[parent].plane, glm::vec4(corner, 1.0f)) > 0.0f;
+                if (!inFront)
+                    continue;
+            }
+
+            glm::vec4 rect;
+            if (!PlanarReflection::screenRect(mirrors[m], proj * parentView, rect))
+                continue;
+            rect = glm::vec4(std::max(rect.x, parentRect.x), std::max(rect.y, parentRect.y),
+                             std::min(rect.z, parentRect.z), std::min(rect.w, parentRect.w));
+            if (rect.x >= rect.z || rect.y >= rect.w)
+                continue;
+
+            View view;
+            view.reflection = parentReflection * PlanarReflection::reflection(plane);
+            view.view = cameraView * view.reflection;
+            view.proj = PlanarReflection::obliqueNearPlane(proj, glm::transpose(glm::inverse(view.view)) * plane);
+            view.plane = plane;
+            view.rect = rect;
+            view.frustum = FrustumCulling::extract(crop(rect) * proj * view.view);
+            view.frustum.planes[4] = plane;
+            view.resolutionScale = std::pow(settings.resolutionScale, float(depth));
+            view.mirror = m;
+            view.parent = parent;
+            view.depth = depth;
+            views.push_back(view);
+
+            if (depth < settings.maxDepth)
+                addViews(mirrors, settings, cameraView, proj, int(views.size()) - 1, views);
+        }
+    }
+}
+
+glm::vec4 PlanarReflection::plane(const Mirror& mirror) {
+    const glm::vec3 normal = glm::normalize(glm::cross(mirror.corners[1] - mirror.corners[0], mirror.corners[3] - mirror.corners[0]));
+    return glm::vec4(normal, -glm::dot(normal, mirror.corners[0]));
+}
+
+glm::mat4 PlanarReflection::reflection(const glm::vec4& plane) {
+    const glm::vec3 n(plane);
+    glm::mat4 m(1.0f);
+    for (int column = 0; column < 3; ++column) {
+        for (int row = 0; row < 3; ++row)
+            m[column][row] -= 2.0f * n[row] * n[column];
+    }
+    m[3] = glm::vec4(-2.0f * plane.w * n, 1.0f);
+    return m;
+}
+
+glm::mat4 PlanarReflection::obliqueNearPlane(const glm::mat4& proj, const glm::vec4& viewPlane) {
+    // the corner of the frustum opposite the plane, pushed through the
+    // inverse projection, ends up on the new far plane
+    const glm::vec4 corner((sign(viewPlane.x) + proj[2][0]) / proj[0][0],
+                           (sign(viewPlane.y) + proj[2][1]) / proj[1][1],
+                           -1.0f,
+                           (1.0f + proj[2][2]) / proj[3][2]);
+    const glm::vec4 scaled = viewPlane * (2.0f / glm::dot(viewPlane, corner));
+
+    glm::mat4 oblique = proj;
+    for (int column = 0; column < 4; ++column)
+        oblique[column][2] = scaled[column] - proj[column][3];
+    return oblique;
+}
+
+bool PlanarReflection::screenRect(const Mirror& mirror, const glm::mat4& viewProj, glm::vec4& rect) {
+    glm::vec4 clip[4];
+    for (int i = 0; i < 4; ++i)
+        clip[i] = viewProj * glm::vec4(mirror.corners[i], 1.0f);
+
+    // Sutherland-Hodgman against the near plane, z >= -w
+    glm::vec4 polygon[5];
+    int count = 0;
+    for (int i = 0; i < 4; ++i) {
+        const glm::vec4& a = clip[i];
+        const glm::vec4& b = clip[(i + 1) % 4];
+        const float da = a.z + a.w, db = b.z + b.w;
+        if (da >= 0.0f)
+            polygon[count++] = a;
+        if ((da >= 0.0f) != (db >= 0.0f))
+            polygon[count++] = a + (b - a) * (da / (da - db));
+    }
+    if (count == 0)
+        return false;
+
+    rect = glm::vec4(1.0f, 1.0f, -1.0f, -1.0f);
+    for (int i = 0; i < count; ++i) {
+        const glm::vec2 ndc = glm::vec2(polygon[i]) / std::max(polygon[i].w, 1e-6f);
+        rect = glm::vec4(std::min(rect.x, ndc.x), std::min(rect.y, ndc.y), std::max(rect.z, ndc.x), std::max(rect.w, ndc.y));
+    }
+    rect = glm::clamp(rect, glm::vec4(-1.0f), glm::vec4(1.0f));
+    return rect.x < rect.z && rect.y < rect.w;
+}
+
+void PlanarReflection::build(const std::vector<Mirror>& mirrors, const Settings& settings, const glm::mat4& view, const glm::mat4& proj, std::vector<View>& views) {
+    views.clear();
+    if (settings.maxDepth > 0)
+        addViews(mirrors, settings, view, proj, -1, views);
+}
+
+bool PlanarReflection::visible(const View& view, const glm::vec3& center, const glm::vec3& extents) {
+    for (const glm::vec4& plane : view.frustum.planes) {
+        const glm::vec3 normal(plane);
+        if (glm::dot(normal, center) + plane.w + glm::dot(glm::abs(normal), extents) < 0.0f)
+            return false;
+    }
+    return true;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+#include "FrustumCulling.h"
+
+// Planar mirrors and portals. Each mirror seen by a camera gets a view: the
+// camera reflected through the mirror's plane, with a projection whose near
+// plane is the mirror itself (Lengyel's oblique clipping) so nothing behind
+// the glass leaks in, and a frustum narrowed to the mirror's bounds on
+// screen for culling. Mirrors seen in a mirror become views of that view,
+// down to Settings::maxDepth.
+//
+// Every view renders in the screen space of the main camera, so a mirror's
+// surface samples its reflection at its own fragment's screen position.
+namespace PlanarReflection {
+
+    // A rectangle, corners counter-clockwise seen from the reflecting side
+    struct Mirror {
+        glm::vec3 corners[4];
+    };
+
+    struct Settings {
+        int maxDepth = 1;               // mirrors in mirrors, 0 turns reflections off
+        float resolutionScale = 0.5f;   // of the scene target, compounding per level
+        int maxViews = 8;
+    };
+
+    struct View {
+        glm::mat4 view;                 // camera with every mirror on the path applied
+        glm::mat4 proj;                 // near plane on the mirror
+        glm::mat4 reflection;           // the mirrors on the path, view = camera view * reflection
+        glm::vec4 plane;                // the mirror's plane in world space, positive in front
+        glm::vec4 rect;                 // mirror bounds in NDC: min x, min y, max x, max y
+        FrustumCulling::Frustum frustum;
+        float resolutionScale = 1.0f;
+        int mirror = -1;
+        int parent = -1;                // index of the view this mirror is seen in, -1 for the camera
+        int depth = 1;
+    };
+
+    // Mirror's plane, normalized, from its corners' winding
+    glm::vec4 plane(const Mirror& mirror);
+
+    // Reflects world space through a plane
+    glm::mat4 reflection(const glm::vec4& plane);
+
+    // Replaces proj's near plane with a view space clip plane, which faces
+    // away from the camera
+    glm::mat4 obliqueNearPlane(const glm::mat4& proj, const glm::vec4& viewPlane);
+
+    // Mirror bounds on screen after clipping to the near plane. False when
+    // none of it is in front of the camera.
+    bool screenRect(const Mirror& mirror, const glm::mat4& viewProj, glm::vec4& rect);
+
+    // Views for every mirror the camera sees, recursively. Parents always
+    // come before their children.
+    void build(const std::vector<Mirror>& mirrors, const Settings& settings, const glm::mat4& view, const glm::mat4& proj, std::vector<View>& views);
+
+    // Box test against a view's frustum
+    bool visible(const View& view, const glm::vec3& center, const glm::vec3& extents);
+}
@@ -0,0 +1,59 @@
+#include "Skybox.h"
+
+#include "../Render/GLState.h"
+#include "../Shader/ShaderProgram.h"
+#include "../Shader/VertexShaderStrings.h"
+#include "../vertices.h"
+
+bool Skybox::create(Pass& pass, GLuint cubemap) {
+    if (!cubemap)
+        return false;
+
+    ShaderStruct shaderSources;
+    createShaderProgram(shaderSources.skyboxVertexSource, shaderSources.skyboxFragmentSource,
+                        pass.vertexShader, pass.fragmentShader, pass.shaderProgram);
+
+    pass.cubemap = cubemap;
+    glUseProgram(pass.shaderProgram);
+    glUniform1i(glGetUniformLocation(pass.shaderProgram, "texSkybox"), 0);
+
+    glGenVertexArrays(1, &pass.vao);
+    glGenBuffers(1, &pass.vbo);
+    glBindVertexArray(pass.vao);
+    glBindBuffer(GL_ARRAY_BUFFER, pass.vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(Vertices::skyboxVertices), Vertices::skyboxVertices, GL_STATIC_DRAW);
+
+    GLint posAttrib = glGetAttribLocation(pass.shaderProgram, "position");
+    glEnableVertexAttribArray(posAttrib);
+    glVertexAttribPointer(posAttrib, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), 0);
+
+    // no visible seams where the faces meet
+    glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
+
+    return true;
+}
+
+void Skybox::draw(const Pass& pass) {
+    // the sky is at depth 1.0, which GL_LESS would reject against a cleared buffer
+    GLState::depthFunc(GL_LEQUAL);
+    GLState::depthMask(GL_FALSE);
+
+    GLState::useProgram(pass.shaderProgram);
+
+    GLState::bindTexture(0, GL_TEXTURE_CUBE_MAP, pass.cubemap);
+    GLState::bindVertexArray(pass.vao);
+    glDrawArrays(GL_TRIANGLES, 0, 36);
+
+    GLState::depthMask(GL_TRUE);
+    GLState::depthFunc(GL_LESS);
+}
+
+void Skybox::destroy(Pass& pass) {
+    glDeleteVertexArrays(1, &pass.vao);
+    glDeleteBuffers(1, &pass.vbo);
+    glDeleteTextures(1, &pass.cubemap);
+    glDeleteShader(pass.vertexShader);
+    glDeleteShader(pass.fragmentShader);
+    glDeleteProgram(pass.shaderProgram);
+    pass = Pass();
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <GL/glew.h>
+
+// Skybox pass. Drawn after the opaque geometry with GL_LEQUAL at the far
+// plane, so only the pixels the scene left uncovered get shaded.
+namespace Skybox {
+
+    struct Pass {
+        GLuint vao = 0;
+        GLuint vbo = 0;
+        GLuint cubemap = 0;
+        GLuint vertexShader = 0;
+        GLuint fragmentShader = 0;
+        GLuint shaderProgram = 0;
+    };
+
+    // Takes ownership of the cubemap. Returns false when there is no cubemap.
+    bool create(Pass& pass, GLuint cubemap);
+
+    // View and projection come from the Frame uniform block. Leaves the depth
+    // function at GL_LESS. State goes through GLState.
+    void draw(const Pass& pass);
+
+    void destroy(Pass& pass);
+}
@@ -0,0 +1,150 @@
+#include "Transforms.h"
+
+#include "../Jobs/JobSystem.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+
+namespace {
+
+    template<typename T>
+    void insertAt(std::vector<T>& values, size_t index, const T& value) {
+        values.insert(values.begin() + index, value);
+    }
+
+    glm::mat4 localMatrix(const Transforms::Hierarchy& hierarchy, size_t i) {
+        // T * R * S, built directly instead of through three matrix products
+        glm::mat4 local = glm::mat4_cast(hierarchy.rotation[i]);
+        local[0] *= hierarchy.scale[i].x;
+        local[1] *= hierarchy.scale[i].y;
+        local[2] *= hierarchy.scale[i].z;
+        local[3] = glm::vec4(hierarchy.position[i], 1.0f);
+        return local;
+    }
+
+    // Everything in the range is recomputed, its root's parent is already current
+    void updateRange(Transforms::Hierarchy& hierarchy, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const uint32_t parent = hierarchy.parent[i];
+            hierarchy.world[i] = parent == Transforms::None ? localMatrix(hierarchy, i) : hierarchy.world[parent] * localMatrix(hierarchy, i);
+            hierarchy.dirty[i] = 0;
+        }
+    }
+}
+
+uint32_t Transforms::add(Hierarchy& hierarchy, uint32_t parent) {
+    const uint32_t id = uint32_t(hierarchy.positionOf.size());
+    const uint32_t parentIndex = parent == None ? None : hierarchy.positionOf[parent];
+    const uint32_t index = parentIndex == None ? uint32_t(hierarchy.parent.size()) : hierarchy.subtreeEnd[parentIndex];
+
+    // the parent's range and its ancestors' grow by one, everything after shifts
+    for (uint32_t ancestor = parentIndex; ancestor != None; ancestor = hierarchy.parent[ancestor])
+        hierarchy.subtreeEnd[ancestor]++;
+    for (size_t i = index; i < hierarchy.parent.size(); ++i) {
+        hierarchy.subtreeEnd[i]++;
+        hierarchy.positionOf[hierarchy.idAt[i]]++;
+    }
+    for (uint32_t& p : hierarchy.parent)
+        if (p != None && p >= index)
+            p++;
+
+    insertAt(hierarchy.parent, index, parentIndex);
+    insertAt(hierarchy.subtreeEnd, index, index + 1);
+    insertAt(hierarchy.position, index, glm::vec3(0.0f));
+    insertAt(hierarchy.rotation, index, glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+    insertAt(hierarchy.scale, index, glm::vec3(1.0f));
+    insertAt(hierarchy.world, index, glm::mat4(1.0f));
+    insertAt(hierarchy.dirty, index, uint8_t(1));
+    insertAt(hierarchy.idAt, index, id);
+    hierarchy.positionOf.push_back(index);
+    return id;
+}
+
+void Transforms::setLocal(Hierarchy& hierarchy, uint32_t node, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale) {
+    const uint32_t i = hierarchy.positionOf[node];
+    hierarchy.position[i] = position;
+    hierarchy.rotation[i] = rotation;
+    hierarchy.scale[i] = scale;
+    hierarchy.dirty[i] = 1;
+}
+
+void Transforms::setPosition(Hierarchy& hierarchy, uint32_t node, const glm::vec3& position) {
+    const uint32_t i = hierarchy.positionOf[node];
+    hierarchy.position[i] = position;
+    hierarchy.dirty[i] = 1;
+}
+
+void Transforms::setRotation(Hierarchy& hierarchy, uint32_t node, const glm::quat& rotation) {
+    const uint32_t i = hierarchy.positionOf[node];
+    hierarchy.rotation[i] = rotation;
+    hierarchy.dirty[i] = 1;
+}
+
+const glm::mat4& Transforms::world(const Hierarchy& hierarchy, uint32_t node) {
+    return hierarchy.world[hierarchy.positionOf[node]];
+}
+
+size_t Transforms::update(Hierarchy& hierarchy) {
+    // outermost dirty nodes, their ranges cover every dirty descendant
+    struct Range { size_t begin, end; };
+    std::vector<Range> ranges;
+    size_t total = 0;
+    const size_t count = hierarchy.parent.size();
+    for (size_t i = 0; i < count;) {
+        if (hierarchy.dirty[i]) {
+            ranges.push_back({ i, hierarchy.subtreeEnd[i] });
+            total += hierarchy.subtreeEnd[i] - i;
+            i = hierarchy.subtreeEnd[i];
+        } else {
+            ++i;
+        }
+    }
+
+    const size_t threads = size_t(JobSystem::threadCount());
+    if (total < ParallelThreshold || threads == 1) {
+        for (const Range& range : ranges)
+            updateRange(hierarchy, range.begin, range.end);
+        hierarchy.lastUpdated = total;
+        return total;
+    }
+
+    // a range bigger than one thread's share is opened up: its root is done
+    // here, and its children's subtrees become ranges of their own
+    const size_t share = (total + threads - 1) / threads;
+    std::vector<Range> open;
+    for (size_t r = 0; r < ranges.size(); ++r) {
+        Range range = ranges[r];
+        if (range.end - range.begin <= share || range.end - range.begin == 1) {
+            open.push_back(range);
+            continue;
+        }
+        updateRange(hierarchy, range.begin, range.begin + 1);
+        for (size_t child = range.begin + 1; child < range.end; child = hierarchy.subtreeEnd[child])
+            ranges.push_back({ child, hierarchy.subtreeEnd[child] });
+    }
+
+    std::vector<std::vector<Range>> work(1);
+    size_t assigned = 0;
+    for (const Range& range : open) {
+        if (assigned >= share && work.size() < threads) {
+            work.emplace_back();
+            assigned = 0;
+        }
+        work.back().push_back(range);
+        assigned += range.end - range.begin;
+    }
+
+    JobSystem::parallelFor(work.size(), 1, [&](size_t first, size_t last) {
+        for (size_t w = first; w < last; ++w)
+            for (const Range& range : work[w])
+                updateRange(hierarchy, range.begin, range.end);
+    });
+
+    hierarchy.lastUpdated = total;
+    return total;
+}
+
+size_t Transforms::size(const Hierarchy& hierarchy) {
+    return hierarchy.parent.size();
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <cstdint>
+#include <vector>
+
+// Parent/child transform hierarchy. Nodes are kept in depth first order in
+// parallel arrays, so every subtree is one contiguous range that follows its
+// root. Setting a local transform marks the node dirty; update() walks the
+// arrays once, recomputes each dirty node's whole range and skips clean
+// ranges. Dirty ranges never overlap and their parents are already up to
+// date, so big updates go to several threads, a range each.
+namespace Transforms {
+
+    const uint32_t None = 0xFFFFFFFFu;
+
+    struct Hierarchy {
+        // indexed by position in depth first order
+        std::vector<uint32_t> parent;       // position, None for roots
+        std::vector<uint32_t> subtreeEnd;   // one past the last descendant
+        std::vector<glm::vec3> position;
+        std::vector<glm::quat> rotation;
+        std::vector<glm::vec3> scale;
+        std::vector<glm::mat4> world;
+        std::vector<uint8_t> dirty;
+
+        // stable node ids, positions move when nodes are inserted
+        std::vector<uint32_t> positionOf;
+        std::vector<uint32_t> idAt;
+
+        size_t lastUpdated = 0;
+    };
+
+    // Returns the new node's id. The node starts dirty with an identity transform.
+    uint32_t add(Hierarchy& hierarchy, uint32_t parent = None);
+
+    void setLocal(Hierarchy& hierarchy, uint32_t node, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale);
+    void setPosition(Hierarchy& hierarchy, uint32_t node, const glm::vec3& position);
+    void setRotation(Hierarchy& hierarchy, uint32_t node, const glm::quat& rotation);
+
+    // Valid after update()
+    const glm::mat4& world(const Hierarchy& hierarchy, uint32_t node);
+
+    // Dirty subtrees at least this big in total are split across threads
+    const size_t ParallelThreshold = 16 * 1024;
+
+    // Recomputes the world matrices of dirty nodes and everything below
+    // them. Returns how many were recomputed.
+    size_t update(Hierarchy& hierarchy);
+
+    size_t size(const Hierarchy& hierarchy);
+}
@@ -0,0 +1,61 @@
+#include "ShaderProgram.h"
+#include "UniformBlocks.h"
+
+#include <iostream>
+
+GLuint shaderLogCheck(GLuint shader, ShaderLogType type) {
+	GLint success = GL_TRUE;
+	GLchar infoLog[512];
+	
+    if(type == COMPILE) {
+		glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+		if(!success) {
+			glGetShaderInfoLog(shader, 512, NULL, infoLog);
+			std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
+			return 0;
+		}
+	} else if(type == LINK) {
+		glGetProgramiv(shader, GL_LINK_STATUS, &success);
+		if(!success) {
+			glGetProgramInfoLog(shader, 512, NULL, infoLog);
+			std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+			return 0;
+		}
+	}
+
+	return success;
+}
+
+int createShaderProgram(const GLchar* vertexSource, const GLchar* fragmentSource, GLuint& vertexShader, GLuint& fragmentShader, GLuint& shaderProgram) {
+    vertexShader = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(vertexShader, 1, &vertexSource, NULL);
+    glCompileShader(vertexShader);
+    shaderLogCheck(vertexShader, COMPILE);
+
+    fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(fragmentShader, 1, &fragmentSource, NULL);
+    glCompileShader(fragmentShader);
+    shaderLogCheck(fragmentShader, COMPILE);
+
+    shaderProgram = glCreateProgram();
+    glAttachShader(shaderProgram, vertexShader);
+    glAttachShader(shaderProgram, fragmentShader);
+    glLinkProgram(shaderProgram);
+    shaderLogCheck(shaderProgram, LINK);
+    UniformBlocks::bind(shaderProgram);
+
+    return 1;
+}
+
+int createComputeProgram(const GLchar* computeSource, GLuint& computeShader, GLuint& shaderProgram) {
+    computeShader = glCreateShader(GL_COMPUTE_SHADER);
+    glShaderSource(computeShader, 1, &computeSource, NULL);
+    glCompileShader(computeShader);
+    if (!shaderLogCheck(computeShader, COMPILE))
+        return 0;
+
+    shaderProgram = glCreateProgram();
+    glAttachShader(shaderProgram, computeShader);
+    glLinkProgram(shaderProgram);
+    return shaderLogCheck(shaderProgram, LINK) ? 1 : 0;
+}
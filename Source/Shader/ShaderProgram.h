@@ -0,0 +1,15 @@
+#pragma once
+
+#include <GL/glew.h>
+
+enum ShaderLogType {
+    COMPILE,
+    LINK
+};
+
+GLuint shaderLogCheck(GLuint shader, ShaderLogType type);
+
+int createShaderProgram(const GLchar* vertexSource, const GLchar* fragmentSource, GLuint& vertexShader, GLuint& fragmentShader, GLuint& shaderProgram);
+
+// GL 4.3 compute programs. Returns 0 when compiling or linking failed.
+int createComputeProgram(const GLchar* computeSource, GLuint& computeShader, GLuint& shaderProgram);
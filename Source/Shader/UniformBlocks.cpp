@@ -0,0 +1,7 @@
+#include "UniformBlocks.h"
+
+void UniformBlocks::bind(GLuint program) {
+    GLuint frameIndex = glGetUniformBlockIndex(program, "Frame");
+    if (frameIndex != GL_INVALID_INDEX)
+        glUniformBlockBinding(program, frameIndex, FrameBinding);
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+// std140 uniform blocks shared by every program. The GLSL side declares
+//
+//     layout(std140) uniform Frame { mat4 view; mat4 proj; float time; };
+//
+// and createShaderProgram points it at this binding point. Per-draw data
+// travels as instance attributes, see DrawBatch.
+namespace UniformBlocks {
+
+    const GLuint FrameBinding = 0;
+
+    struct Frame {
+        glm::mat4 view;
+        glm::mat4 proj;
+        float time;
+        float padding[3];
+    };
+
+    static_assert(sizeof(Frame) == 144, "Frame must match the std140 layout");
+
+    // Binds the blocks the program uses
+    void bind(GLuint program);
+}
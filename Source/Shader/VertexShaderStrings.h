@@ -10,20 +10,24 @@ struct ShaderStruct {
 			in vec3 position;
 			in vec3 color;
 			in vec2 texcoord;
+			in mat4 instanceModel;
+			in vec4 instanceColor;
 
 			out vec2 Texcoord;
 			out vec3 Color;
 
-			uniform mat4 model;
-			uniform mat4 view;
-			uniform mat4 proj;
-			uniform vec3 overrideColor;
+			layout(std140) uniform Frame
+			{
+				mat4 view;
+				mat4 proj;
+				float time;
+			};
 
 			void main()
 			{
-				Color = overrideColor * color;
+				Color = instanceColor.rgb * color;
 				Texcoord = texcoord;
-				gl_Position = proj * view * model * vec4(position, 1.0);
+				gl_Position = proj * view * instanceModel * vec4(position, 1.0);
 			}
 		)glsl";
 
@@ -34,9 +38,16 @@ struct ShaderStruct {
 			out vec4 outColor;
 			uniform sampler2D texKitten;
 			uniform sampler2D texPuppy;
+			// a mirror's surface shows its reflection at the same screen position
+			uniform sampler2D reflection;
+			uniform vec2 mirrorPixel;	// 1 / target size on a mirror, zero elsewhere
+			uniform float mirrorTint;
 			void main()
 			{
-				outColor = vec4(Color, 1.0) * mix(texture(texKitten, Texcoord), texture(texPuppy, Texcoord), 0.5);
+				if (mirrorPixel.x > 0.0)
+					outColor = vec4(vec3(mirrorTint), 1.0) * texture(reflection, gl_FragCoord.xy * mirrorPixel);
+				else
+					outColor = vec4(Color, 1.0) * mix(texture(texKitten, Texcoord), texture(texPuppy, Texcoord), 0.5);
 			}
 		)glsl";
 
@@ -52,14 +63,210 @@ struct ShaderStruct {
 			}
 		)glsl";
 
+	// Upscales the scene target to the window. The bilinear weights are
+	// tightened across edges so they stay crisp, then a contrast-adaptive
+	// sharpen restores detail the lower resolution lost.
 	const char* screenFragmentSource = R"glsl(
 			#version 150 core
 			in vec2 Texcoord;
 			out vec4 outColor;
 			uniform sampler2D texFramebuffer;
+			uniform vec2 sourceSize;
+			uniform float sharpness;
+
+			float luma(vec3 c)
+			{
+				return dot(c, vec3(0.299, 0.587, 0.114));
+			}
+
+			void main()
+			{
+				vec2 texel = 1.0 / sourceSize;
+				vec2 pos = Texcoord * sourceSize - 0.5;
+				vec2 base = (floor(pos) + 0.5) * texel;
+				vec2 f = fract(pos);
+
+				vec3 a = texture(texFramebuffer, base).rgb;
+				vec3 b = texture(texFramebuffer, base + vec2(texel.x, 0.0)).rgb;
+				vec3 c = texture(texFramebuffer, base + vec2(0.0, texel.y)).rgb;
+				vec3 d = texture(texFramebuffer, base + texel).rgb;
+
+				// gradient over the 2x2 footprint, strong gradient = edge
+				float la = luma(a), lb = luma(b), lc = luma(c), ld = luma(d);
+				vec2 gradient = vec2((lb - la) + (ld - lc), (lc - la) + (ld - lb));
+				float edge = clamp(length(gradient) * 4.0, 0.0, 1.0);
+				vec2 across = abs(normalize(gradient + 1e-5));
+				vec2 weights = mix(f, smoothstep(0.0, 1.0, f), edge * across);
+				vec3 color = mix(mix(a, b, weights.x), mix(c, d, weights.x), weights.y);
+
+				vec3 n = texture(texFramebuffer, Texcoord + vec2(0.0, texel.y)).rgb;
+				vec3 s = texture(texFramebuffer, Texcoord - vec2(0.0, texel.y)).rgb;
+				vec3 e = texture(texFramebuffer, Texcoord + vec2(texel.x, 0.0)).rgb;
+				vec3 w = texture(texFramebuffer, Texcoord - vec2(texel.x, 0.0)).rgb;
+				vec3 low = min(color, min(min(n, s), min(e, w)));
+				vec3 high = max(color, max(max(n, s), max(e, w)));
+
+				// less sharpening where the neighbourhood already has contrast
+				vec3 amount = sqrt(clamp(min(low, 1.0 - high) / max(high, 1e-4), 0.0, 1.0));
+				vec3 weight = amount * (-0.2 * sharpness);
+				color = (color + (n + s + e + w) * weight) / (1.0 + 4.0 * weight);
+
+				outColor = vec4(clamp(color, 0.0, 1.0), 1.0);
+			}
+		)glsl";
+
+	const char* skyboxVertexSource = R"glsl(
+			#version 150 core
+			in vec3 position;
+			out vec3 Direction;
+
+			layout(std140) uniform Frame
+			{
+				mat4 view;
+				mat4 proj;
+				float time;
+			};
+
+			void main()
+			{
+				// the scene is z-up, cubemaps are y-up
+				Direction = vec3(position.x, position.z, -position.y);
+				// rotation only, and z = w so the sky always sits on the far plane
+				vec4 pos = proj * mat4(mat3(view)) * vec4(position, 1.0);
+				gl_Position = pos.xyww;
+			}
+		)glsl";
+
+	const char* skyboxFragmentSource = R"glsl(
+			#version 150 core
+			in vec3 Direction;
+			out vec4 outColor;
+			uniform samplerCube texSkybox;
 			void main()
 			{
-				outColor = texture(texFramebuffer, Texcoord);
+				outColor = texture(texSkybox, Direction);
+			}
+		)glsl";
+
+	// GPU culling, GL 4.3 compute. Each level of the Hi-Z pyramid keeps the
+	// farthest depth of the texels below it; odd sizes take the leftover
+	// row or column into the last texel so nothing is dropped.
+	const char* hiZComputeSource = R"glsl(
+			#version 430 core
+			layout(local_size_x = 8, local_size_y = 8) in;
+
+			uniform sampler2D source;
+			uniform int sourceLevel;
+			layout(r32f, binding = 0) uniform writeonly image2D destination;
+
+			void main()
+			{
+				ivec2 size = imageSize(destination);
+				ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+				if (any(greaterThanEqual(texel, size)))
+					return;
+
+				ivec2 sourceSize = textureSize(source, sourceLevel);
+				ivec2 first = texel * sourceSize / size;
+				ivec2 last = ((texel + 1) * sourceSize + size - 1) / size;
+				float farthest = 0.0;
+				for (int y = first.y; y < last.y; ++y)
+					for (int x = first.x; x < last.x; ++x)
+						farthest = max(farthest, texelFetch(source, ivec2(x, y), sourceLevel).r);
+				imageStore(destination, texel, vec4(farthest));
+			}
+		)glsl";
+
+	// One invocation per instance: frustum test, then the Hi-Z test against
+	// last frame's depth, and survivors append a draw command
+	const char* cullComputeSource = R"glsl(
+			#version 430 core
+			layout(local_size_x = 64) in;
+
+			struct Instance { mat4 model; vec4 color; };
+			struct Command { uint count; uint instanceCount; uint firstIndex; int baseVertex; uint baseInstance; };
+
+			layout(std430, binding = 0) readonly buffer Instances { Instance instances[]; };
+			layout(std430, binding = 1) writeonly buffer Commands { Command commands[]; };
+			layout(std430, binding = 2) buffer DrawCount { uint drawCount; };
+
+			uniform uint firstInstance;
+			uniform uint instanceCount;
+			uniform uint indexCount;
+			uniform uint firstIndex;
+			uniform int baseVertex;
+			uniform vec3 boundsCenter;
+			uniform vec3 boundsExtents;
+			uniform mat4 viewProj;
+
+			uniform bool occlusion;
+			uniform mat4 pyramidViewProj;
+			uniform sampler2D pyramid;
+
+			void main()
+			{
+				uint index = gl_GlobalInvocationID.x;
+				if (index >= instanceCount)
+					return;
+				mat4 model = instances[firstInstance + index].model;
+
+				// world space box around the transformed mesh bounds
+				vec3 center = (model * vec4(boundsCenter, 1.0)).xyz;
+				mat3 axes = mat3(model);
+				vec3 extents = abs(axes[0]) * boundsExtents.x + abs(axes[1]) * boundsExtents.y + abs(axes[2]) * boundsExtents.z;
+
+				// culled when all eight corners are outside the same clip plane
+				uint outside = 63u;
+				for (int corner = 0; corner < 8; ++corner) {
+					vec3 side = vec3((corner & 1) != 0 ? 1.0 : -1.0, (corner & 2) != 0 ? 1.0 : -1.0, (corner & 4) != 0 ? 1.0 : -1.0);
+					vec4 clip = viewProj * vec4(center + side * extents, 1.0);
+					uint code = 0u;
+					code |= clip.x < -clip.w ? 1u : 0u;
+					code |= clip.x > clip.w ? 2u : 0u;
+					code |= clip.y < -clip.w ? 4u : 0u;
+					code |= clip.y > clip.w ? 8u : 0u;
+					code |= clip.z < -clip.w ? 16u : 0u;
+					code |= clip.z > clip.w ? 32u : 0u;
+					outside &= code;
+				}
+				if (outside != 0u)
+					return;
+
+				if (occlusion) {
+					ivec2 size = textureSize(pyramid, 0);
+					vec2 low = vec2(1e30), high = vec2(-1e30);
+					float nearest = 1.0;
+					bool crossesNear = false;
+					for (int corner = 0; corner < 8; ++corner) {
+						vec3 side = vec3((corner & 1) != 0 ? 1.0 : -1.0, (corner & 2) != 0 ? 1.0 : -1.0, (corner & 4) != 0 ? 1.0 : -1.0);
+						vec4 clip = pyramidViewProj * vec4(center + side * extents, 1.0);
+						crossesNear = crossesNear || clip.z < -clip.w;
+						vec3 ndc = clip.xyz / clip.w;
+						vec2 pixel = (ndc.xy * 0.5 + 0.5) * vec2(size);
+						low = min(low, pixel);
+						high = max(high, pixel);
+						nearest = min(nearest, ndc.z * 0.5 + 0.5);
+					}
+
+					if (!crossesNear) {
+						ivec2 first = clamp(ivec2(floor(low)), ivec2(0), size - 1);
+						ivec2 last = clamp(ivec2(floor(high)), ivec2(0), size - 1);
+						// the level where the box is at most one texel wide spans two at most
+						ivec2 span = last - first + 1;
+						int level = int(ceil(log2(float(max(span.x, span.y)))));
+						level = min(level, textureQueryLevels(pyramid) - 1);
+						ivec2 levelSize = textureSize(pyramid, level);
+						ivec2 a = min(first >> level, levelSize - 1);
+						ivec2 b = min(last >> level, levelSize - 1);
+						float farthest = max(max(texelFetch(pyramid, a, level).r, texelFetch(pyramid, ivec2(b.x, a.y), level).r),
+						                     max(texelFetch(pyramid, ivec2(a.x, b.y), level).r, texelFetch(pyramid, b, level).r));
+						if (nearest > farthest)
+							return;
+					}
+				}
+
+				uint slot = atomicAdd(drawCount, 1u);
+				commands[slot] = Command(indexCount, 1u, firstIndex, baseVertex, firstInstance + index);
 			}
 		)glsl";
 };
\ No newline at end of file
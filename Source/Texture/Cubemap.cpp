@@ -0,0 +1,136 @@
+#include "Cubemap.h"
+
+#include <SOIL.h>
+#include <stb_image_aug.h>
+
+#include <cstring>
+#include <future>
+#include <iostream>
+
+namespace {
+
+    struct Face {
+        unsigned char* pixels = nullptr;
+        int width = 0;
+        int height = 0;
+    };
+
+    // 'E'ast = +X, 'W'est = -X, 'U'p = +Y, 'D'own = -Y, 'N'orth = +Z, 'S'outh = -Z
+    GLenum faceTarget(char letter) {
+        switch (letter) {
+        case 'E': return GL_TEXTURE_CUBE_MAP_POSITIVE_X;
+        case 'W': return GL_TEXTURE_CUBE_MAP_NEGATIVE_X;
+        case 'U': return GL_TEXTURE_CUBE_MAP_POSITIVE_Y;
+        case 'D': return GL_TEXTURE_CUBE_MAP_NEGATIVE_Y;
+        case 'N': return GL_TEXTURE_CUBE_MAP_POSITIVE_Z;
+        case 'S': return GL_TEXTURE_CUBE_MAP_NEGATIVE_Z;
+        default: return 0;
+        }
+    }
+
+    GLuint createStorage(int size) {
+        GLuint textureID;
+        glGenTextures(1, &textureID);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
+
+        // one allocation for all six faces
+        if (GLEW_ARB_texture_storage) {
+            glTexStorage2D(GL_TEXTURE_CUBE_MAP, 1, GL_RGBA8, size, size);
+        } else {
+            for (int i = 0; i < 6; ++i)
+                glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGBA8, size, size, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        }
+
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, 0);
+
+        return textureID;
+    }
+}
+
+GLuint Cubemap::loadFaces(const char* const paths[6]) {
+    // loader registration isn't thread safe, get it done before fanning out.
+    // The workers go to stb directly, SOIL_load_image would also write SOIL's
+    // shared result string from every thread.
+    SOIL_register_loaders();
+
+    std::future<Face> pending[6];
+    for (int i = 0; i < 6; ++i) {
+        pending[i] = std::async(std::launch::async, [path = paths[i]]() {
+            Face face;
+            int channels;
+            face.pixels = stbi_load(path, &face.width, &face.height, &channels, SOIL_LOAD_RGBA);
+            return face;
+        });
+    }
+
+    Face faces[6];
+    bool valid = true;
+    for (int i = 0; i < 6; ++i) {
+        faces[i] = pending[i].get();
+        if (!faces[i].pixels) {
+            std::cout << "ERROR::CUBEMAP::LOAD_FAILED\n" << paths[i] << std::endl;
+            valid = false;
+        } else if (faces[i].width != faces[i].height || faces[i].width != faces[0].width) {
+            std::cout << "ERROR::CUBEMAP::FACE_SIZE_MISMATCH\n" << paths[i] << std::endl;
+            valid = false;
+        }
+    }
+
+    GLuint textureID = 0;
+    if (valid) {
+        textureID = createStorage(faces[0].width);
+        for (int i = 0; i < 6; ++i)
+            glTexSubImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, 0, 0, faces[i].width, faces[i].height, GL_RGBA, GL_UNSIGNED_BYTE, faces[i].pixels);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+    }
+
+    for (Face& face : faces)
+        SOIL_free_image_data(face.pixels);
+
+    return textureID;
+}
+
+GLuint Cubemap::loadStrip(const char* path, const char* faceOrder) {
+    bool validOrder = faceOrder && strlen(faceOrder) == 6;
+    for (int i = 0; validOrder && i < 6; ++i)
+        validOrder = faceTarget(faceOrder[i]) != 0;
+    if (!validOrder) {
+        std::cout << "ERROR::CUBEMAP::INVALID_FACE_ORDER\n" << path << std::endl;
+        return 0;
+    }
+
+    int width, height, channels;
+    unsigned char* image = SOIL_load_image(path, &width, &height, &channels, SOIL_LOAD_RGBA);
+    if (!image) {
+        std::cout << "ERROR::CUBEMAP::LOAD_FAILED\n" << path << ": " << SOIL_last_result() << std::endl;
+        return 0;
+    }
+
+    const bool vertical = height == 6 * width;
+    if (!vertical && width != 6 * height) {
+        std::cout << "ERROR::CUBEMAP::NOT_A_STRIP\n" << path << std::endl;
+        SOIL_free_image_data(image);
+        return 0;
+    }
+
+    // faces are uploaded in place: a vertical strip is six contiguous faces and
+    // a horizontal one only needs the source row length, so nothing is copied
+    const int size = vertical ? width : height;
+    GLuint textureID = createStorage(size);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, width);
+    for (int i = 0; i < 6; ++i) {
+        const size_t offset = vertical ? size_t(i) * size * size * 4 : size_t(i) * size * 4;
+        glTexSubImage2D(faceTarget(faceOrder[i]), 0, 0, 0, size, size, GL_RGBA, GL_UNSIGNED_BYTE, image + offset);
+    }
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+
+    SOIL_free_image_data(image);
+
+    return textureID;
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <GL/glew.h>
+
+// Cubemap loading. Faces are decoded concurrently and uploaded into one
+// immutable allocation, instead of SOIL_load_OGL_cubemap's face-by-face path.
+namespace Cubemap {
+
+    // Face order is +X, -X, +Y, -Y, +Z, -Z. Returns 0 on failure.
+    GLuint loadFaces(const char* const paths[6]);
+
+    // One image holding all six faces as a horizontal or vertical strip
+    // (DDS cubemaps decode as a vertical strip). faceOrder uses SOIL's
+    // letters, e.g. SOIL_DDS_CUBEMAP_FACE_ORDER "EWUDNS". Returns 0 on failure.
+    GLuint loadStrip(const char* path, const char* faceOrder);
+}
@@ -0,0 +1,602 @@
+#include "Ktx2.h"
+
+#include <SOIL.h>
+#include <image_helper.h>
+extern "C" {
+#include <image_DXT.h>
+}
+
+#include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <numeric>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+    const uint8_t identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+    const size_t headerSize = 80;       // identifier + header + index
+    const size_t levelIndexSize = 24;   // byteOffset, byteLength, uncompressedByteLength
+
+    const Ktx2::FormatInfo formats[] = {
+        { Ktx2::FORMAT_R5G6B5_UNORM_PACK16, GL_RGB565, GL_RGB, GL_UNSIGNED_SHORT_5_6_5, 1, 1, 2 },
+        { Ktx2::FORMAT_R8_UNORM, GL_R8, GL_RED, GL_UNSIGNED_BYTE, 1, 1, 1 },
+        { Ktx2::FORMAT_R8G8_UNORM, GL_RG8, GL_RG, GL_UNSIGNED_BYTE, 1, 1, 2 },
+        { Ktx2::FORMAT_R8G8B8_UNORM, GL_RGB8, GL_RGB, GL_UNSIGNED_BYTE, 1, 1, 3 },
+        { Ktx2::FORMAT_R8G8B8_SRGB, GL_SRGB8, GL_RGB, GL_UNSIGNED_BYTE, 1, 1, 3 },
+        { Ktx2::FORMAT_R8G8B8A8_UNORM, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, 1, 1, 4 },
+        { Ktx2::FORMAT_R8G8B8A8_SRGB, GL_SRGB8_ALPHA8, GL_RGBA, GL_UNSIGNED_BYTE, 1, 1, 4 },
+        { Ktx2::FORMAT_R16_SFLOAT, GL_R16F, GL_RED, GL_HALF_FLOAT, 1, 1, 2 },
+        { Ktx2::FORMAT_R16G16_SFLOAT, GL_RG16F, GL_RG, GL_HALF_FLOAT, 1, 1, 4 },
+        { Ktx2::FORMAT_R16G16B16A16_SFLOAT, GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT, 1, 1, 8 },
+        { Ktx2::FORMAT_R32G32B32A32_SFLOAT, GL_RGBA32F, GL_RGBA, GL_FLOAT, 1, 1, 16 },
+        { Ktx2::FORMAT_BC1_RGB_UNORM_BLOCK, GL_COMPRESSED_RGB_S3TC_DXT1_EXT, 0, 0, 4, 4, 8 },
+        { Ktx2::FORMAT_BC1_RGB_SRGB_BLOCK, GL_COMPRESSED_SRGB_S3TC_DXT1_EXT, 0, 0, 4, 4, 8 },
+        { Ktx2::FORMAT_BC1_RGBA_UNORM_BLOCK, GL_COMPRESSED_RGBA_S3TC_DXT1_EXT, 0, 0, 4, 4, 8 },
+        { Ktx2::FORMAT_BC3_UNORM_BLOCK, GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, 0, 0, 4, 4, 16 },
+        { Ktx2::FORMAT_BC3_SRGB_BLOCK, GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT, 0, 0, 4, 4, 16 },
+        { Ktx2::FORMAT_BC4_UNORM_BLOCK, GL_COMPRESSED_RED_RGTC1, 0, 0, 4, 4, 8 },
+        { Ktx2::FORMAT_BC5_UNORM_BLOCK, GL_COMPRESSED_RG_RGTC2, 0, 0, 4, 4, 16 },
+        { Ktx2::FORMAT_BC6H_UFLOAT_BLOCK, GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT, 0, 0, 4, 4, 16 },
+        { Ktx2::FORMAT_BC7_UNORM_BLOCK, GL_COMPRESSED_RGBA_BPTC_UNORM, 0, 0, 4, 4, 16 },
+        { Ktx2::FORMAT_BC7_SRGB_BLOCK, GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM, 0, 0, 4, 4, 16 },
+    };
+
+    // Data Format Descriptor values (Khronos Data Format spec, section 5)
+    enum DfdModel : uint32_t {
+        MODEL_RGBSDA = 1,
+        MODEL_BC1A = 128,
+        MODEL_BC3 = 130,
+        MODEL_BC4 = 131,
+        MODEL_BC5 = 132,
+        MODEL_BC6H = 133,
+        MODEL_BC7 = 134
+    };
+
+    enum DfdQualifier : uint8_t {
+        QUALIFIER_LINEAR = 0x10,
+        QUALIFIER_SIGNED = 0x40,
+        QUALIFIER_FLOAT = 0x80
+    };
+
+    const uint8_t channelAlpha = 15;
+    const uint32_t floatMinusOne = 0xBF800000;
+    const uint32_t floatOne = 0x3F800000;
+
+    struct DfdSample {
+        uint16_t bitOffset;
+        uint8_t bitLength;
+        uint8_t channel;    // channel id | qualifiers
+        uint32_t lower;
+        uint32_t upper;
+    };
+
+    bool isSrgb(uint32_t vkFormat) {
+        return vkFormat == Ktx2::FORMAT_R8G8B8_SRGB || vkFormat == Ktx2::FORMAT_R8G8B8A8_SRGB
+            || vkFormat == Ktx2::FORMAT_BC1_RGB_SRGB_BLOCK || vkFormat == Ktx2::FORMAT_BC3_SRGB_BLOCK
+            || vkFormat == Ktx2::FORMAT_BC7_SRGB_BLOCK;
+    }
+
+    // Basic descriptor block, including the leading dfdTotalSize word
+    std::vector<uint32_t> buildDfd(const Ktx2::FormatInfo& info) {
+        const bool srgb = isSrgb(info.vkFormat);
+        const uint8_t alphaQualifier = srgb ? QUALIFIER_LINEAR : 0;
+        uint32_t model = MODEL_RGBSDA;
+        std::vector<DfdSample> samples;
+
+        switch (info.vkFormat) {
+        case Ktx2::FORMAT_R5G6B5_UNORM_PACK16:
+            samples = { { 0, 5, 2, 0, 31 }, { 5, 6, 1, 0, 63 }, { 11, 5, 0, 0, 31 } };
+            break;
+        case Ktx2::FORMAT_BC1_RGB_UNORM_BLOCK:
+        case Ktx2::FORMAT_BC1_RGB_SRGB_BLOCK:
+            model = MODEL_BC1A;
+            samples = { { 0, 64, 0, 0, 0xFFFFFFFF } };
+            break;
+        case Ktx2::FORMAT_BC1_RGBA_UNORM_BLOCK:
+            model = MODEL_BC1A;
+            samples = { { 0, 64, 1, 0, 0xFFFFFFFF } };
+            break;
+        case Ktx2::FORMAT_BC3_UNORM_BLOCK:
+        case Ktx2::FORMAT_BC3_SRGB_BLOCK:
+            model = MODEL_BC3;
+            samples = { { 0, 64, uint8_t(channelAlpha | alphaQualifier), 0, 0xFFFFFFFF }, { 64, 64, 0, 0, 0xFFFFFFFF } };
+            break;
+        case Ktx2::FORMAT_BC4_UNORM_BLOCK:
+            model = MODEL_BC4;
+            samples = { { 0, 64, 0, 0, 0xFFFFFFFF } };
+            break;
+        case Ktx2::FORMAT_BC5_UNORM_BLOCK:
+            model = MODEL_BC5;
+            samples = { { 0, 64, 0, 0, 0xFFFFFFFF }, { 64, 64, 1, 0, 0xFFFFFFFF } };
+            break;
+        case Ktx2::FORMAT_BC6H_UFLOAT_BLOCK:
+            model = MODEL_BC6H;
+            samples = { { 0, 128, QUALIFIER_FLOAT, 0, floatOne } };
+            break;
+        case Ktx2::FORMAT_BC7_UNORM_BLOCK:
+        case Ktx2::FORMAT_BC7_SRGB_BLOCK:
+            model = MODEL_BC7;
+            samples = { { 0, 128, 0, 0, 0xFFFFFFFF } };
+            break;
+        default: {
+            // plain interleaved channels: 8-bit unorm, 16/32-bit float
+            const bool isFloat = info.type == GL_HALF_FLOAT || info.type == GL_FLOAT;
+            const uint32_t bits = info.type == GL_FLOAT ? 32 : (info.type == GL_HALF_FLOAT ? 16 : 8);
+            const uint32_t channels = info.blockBytes * 8 / bits;
+            const uint8_t ids[4] = { 0, 1, 2, channelAlpha };
+            for (uint32_t c = 0; c < channels; ++c) {
+                uint8_t channel = (c == 3) ? uint8_t(ids[c] | alphaQualifier) : ids[c];
+                if (isFloat)
+                    samples.push_back({ uint16_t(c * bits), uint8_t(bits), uint8_t(channel | QUALIFIER_FLOAT | QUALIFIER_SIGNED), floatMinusOne, floatOne });
+                else
+                    samples.push_back({ uint16_t(c * bits), uint8_t(bits), channel, 0, (1u << bits) - 1 });
+            }
+            break;
+        }
+        }
+
+        const uint32_t blockSize = 24 + 16 * uint32_t(samples.size());
+        std::vector<uint32_t> dfd;
+        dfd.push_back(4 + blockSize);
+        dfd.push_back(0);                                   // vendorId 0, descriptorType 0
+        dfd.push_back(2 | (blockSize << 16));               // versionNumber 2
+        dfd.push_back(model | (1 << 8) | ((srgb ? 2u : 1u) << 16));    // BT709 primaries, sRGB or linear
+        dfd.push_back((info.blockWidth - 1) | ((info.blockHeight - 1) << 8));
+        dfd.push_back(info.blockBytes);                     // bytesPlane0
+        dfd.push_back(0);
+        for (const DfdSample& sample : samples) {
+            dfd.push_back(sample.bitOffset | (uint32_t(sample.bitLength - 1) << 16) | (uint32_t(sample.channel) << 24));
+            dfd.push_back(0);
+            dfd.push_back(sample.lower);
+            dfd.push_back(sample.upper);
+        }
+        return dfd;
+    }
+
+    void put32(std::vector<uint8_t>& out, size_t offset, uint32_t value) {
+        for (int i = 0; i < 4; ++i)
+            out[offset + i] = uint8_t(value >> (8 * i));
+    }
+
+    void put64(std::vector<uint8_t>& out, size_t offset, uint64_t value) {
+        for (int i = 0; i < 8; ++i)
+            out[offset + i] = uint8_t(value >> (8 * i));
+    }
+
+    uint32_t get32(const uint8_t* data) {
+        return data[0] | (data[1] << 8) | (data[2] << 16) | (uint32_t(data[3]) << 24);
+    }
+
+    uint64_t get64(const uint8_t* data) {
+        return get32(data) | (uint64_t(get32(data + 4)) << 32);
+    }
+
+    size_t alignUp(size_t value, size_t alignment) {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    // Read-only file mapping, unmapped on destruction
+    struct MappedFile {
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+#ifdef _WIN32
+        HANDLE file = INVALID_HANDLE_VALUE;
+        HANDLE mapping = NULL;
+#endif
+
+        bool open(const char* path) {
+#ifdef _WIN32
+            file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+            if (file == INVALID_HANDLE_VALUE)
+                return false;
+            LARGE_INTEGER fileSize;
+            if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+                return false;
+            mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+            if (!mapping)
+                return false;
+            data = (const uint8_t*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            size = size_t(fileSize.QuadPart);
+#else
+            int fd = ::open(path, O_RDONLY);
+            if (fd < 0)
+                return false;
+            struct stat st;
+            if (fstat(fd, &st) != 0 || st.st_size == 0) {
+                close(fd);
+                return false;
+            }
+            void* view = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            close(fd);
+            if (view == MAP_FAILED)
+                return false;
+            data = (const uint8_t*)view;
+            size = size_t(st.st_size);
+#endif
+            return data != nullptr;
+        }
+
+        ~MappedFile() {
+#ifdef _WIN32
+            if (data)
+                UnmapViewOfFile(data);
+            if (mapping)
+                CloseHandle(mapping);
+            if (file != INVALID_HANDLE_VALUE)
+                CloseHandle(file);
+#else
+            if (data)
+                munmap((void*)data, size);
+#endif
+        }
+    };
+
+    // size of the data type used for endianness conversion, 1 for block formats
+    uint32_t typeSize(const Ktx2::FormatInfo& info) {
+        if (info.type == GL_HALF_FLOAT || info.type == GL_UNSIGNED_SHORT_5_6_5)
+            return 2;
+        if (info.type == GL_FLOAT)
+            return 4;
+        return 1;
+    }
+
+    // BC4: per 4x4 block two endpoints and a 3-bit index into 8 interpolated values
+    std::vector<uint8_t> encodeBC4(const unsigned char* pixels, int width, int height) {
+        const int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+        std::vector<uint8_t> out(size_t(blocksX) * blocksY * 8);
+        uint8_t* block = out.data();
+
+        for (int by = 0; by < blocksY; ++by) {
+            for (int bx = 0; bx < blocksX; ++bx, block += 8) {
+                uint8_t values[16];
+                uint8_t lo = 255, hi = 0;
+                for (int i = 0; i < 16; ++i) {
+                    // partial edge blocks repeat the last row/column
+                    int x = std::min(bx * 4 + (i & 3), width - 1);
+                    int y = std::min(by * 4 + (i >> 2), height - 1);
+                    values[i] = pixels[size_t(y) * width + x];
+                    lo = std::min(lo, values[i]);
+                    hi = std::max(hi, values[i]);
+                }
+
+                // hi > lo selects the 8-value palette
+                uint8_t palette[8] = { hi, lo };
+                for (int i = 1; i < 7; ++i)
+                    palette[i + 1] = uint8_t(((7 - i) * hi + i * lo + 3) / 7);
+
+                uint64_t indices = 0;
+                for (int i = 0; i < 16; ++i) {
+                    int best = 0, bestError = 256;
+                    for (int p = 0; p < 8; ++p) {
+                        int error = std::abs(int(values[i]) - int(palette[p]));
+                        if (error < bestError) {
+                            bestError = error;
+                            best = p;
+                        }
+                    }
+                    indices |= uint64_t(best) << (3 * i);
+                }
+
+                block[0] = hi;
+                block[1] = lo;
+                for (int i = 0; i < 6; ++i)
+                    block[2 + i] = uint8_t(indices >> (8 * i));
+            }
+        }
+        return out;
+    }
+
+    uint32_t mipCount(uint32_t width, uint32_t height) {
+        uint32_t levels = 1;
+        while ((width | height) >> levels)
+            ++levels;
+        return levels;
+    }
+}
+
+const Ktx2::FormatInfo* Ktx2::formatInfo(uint32_t vkFormat) {
+    for (const FormatInfo& info : formats) {
+        if (info.vkFormat == vkFormat)
+            return &info;
+    }
+    return nullptr;
+}
+
+size_t Ktx2::levelSize(const FormatInfo& info, uint32_t width, uint32_t height) {
+    size_t blocksX = (width + info.blockWidth - 1) / info.blockWidth;
+    size_t blocksY = (height + info.blockHeight - 1) / info.blockHeight;
+    return blocksX * blocksY * info.blockBytes;
+}
+
+bool Ktx2::write(const char* path, const Image& image) {
+    const FormatInfo* info = formatInfo(image.vkFormat);
+    if (!info || image.width == 0 || image.height == 0 || image.levels.empty()) {
+        std::cout << "ERROR::KTX2::INVALID_IMAGE\n" << path << std::endl;
+        return false;
+    }
+    for (size_t i = 0; i < image.levels.size(); ++i) {
+        uint32_t w = std::max(1u, image.width >> i), h = std::max(1u, image.height >> i);
+        if (image.levels[i].size() != levelSize(*info, w, h)) {
+            std::cout << "ERROR::KTX2::LEVEL_SIZE_MISMATCH\n" << path << " level " << i << std::endl;
+            return false;
+        }
+    }
+
+    const uint32_t levelCount = uint32_t(image.levels.size());
+    const std::vector<uint32_t> dfd = buildDfd(*info);
+    const char kvdKey[] = "KTXwriter";
+    const char kvdValue[] = "Render";
+    const uint32_t kvdEntryLength = sizeof(kvdKey) + sizeof(kvdValue);
+
+    const size_t dfdOffset = headerSize + levelIndexSize * levelCount;
+    const size_t dfdLength = dfd.size() * 4;
+    const size_t kvdOffset = dfdOffset + dfdLength;
+    const size_t kvdLength = alignUp(4 + kvdEntryLength, 4);
+    const size_t levelAlignment = std::lcm<size_t>(info->blockBytes, 4);
+
+    // levels are stored smallest first, as the spec recommends
+    std::vector<size_t> levelOffsets(levelCount);
+    size_t fileSize = kvdOffset + kvdLength;
+    for (uint32_t i = levelCount; i-- > 0;) {
+        fileSize = alignUp(fileSize, levelAlignment);
+        levelOffsets[i] = fileSize;
+        fileSize += image.levels[i].size();
+    }
+
+    std::vector<uint8_t> out(fileSize, 0);
+    memcpy(out.data(), identifier, sizeof(identifier));
+    put32(out, 12, image.vkFormat);
+    put32(out, 16, typeSize(*info));
+    put32(out, 20, image.width);
+    put32(out, 24, image.height);
+    put32(out, 28, 0);                      // pixelDepth
+    put32(out, 32, 0);                      // layerCount
+    put32(out, 36, 1);                      // faceCount
+    put32(out, 40, levelCount);
+    put32(out, 44, 0);                      // supercompressionScheme
+    put32(out, 48, uint32_t(dfdOffset));
+    put32(out, 52, uint32_t(dfdLength));
+    put32(out, 56, uint32_t(kvdOffset));
+    put32(out, 60, uint32_t(kvdLength));
+    put64(out, 64, 0);                      // no supercompression global data
+    put64(out, 72, 0);
+
+    for (uint32_t i = 0; i < levelCount; ++i) {
+        const size_t entry = headerSize + levelIndexSize * i;
+        put64(out, entry, levelOffsets[i]);
+        put64(out, entry + 8, image.levels[i].size());
+        put64(out, entry + 16, image.levels[i].size());
+        memcpy(out.data() + levelOffsets[i], image.levels[i].data(), image.levels[i].size());
+    }
+    for (size_t i = 0; i < dfd.size(); ++i)
+        put32(out, dfdOffset + 4 * i, dfd[i]);
+
+    put32(out, kvdOffset, kvdEntryLength);
+    memcpy(out.data() + kvdOffset + 4, kvdKey, sizeof(kvdKey));
+    memcpy(out.data() + kvdOffset + 4 + sizeof(kvdKey), kvdValue, sizeof(kvdValue));
+
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        std::cout << "ERROR::KTX2::WRITE_FAILED\n" << path << std::endl;
+        return false;
+    }
+    bool written = fwrite(out.data(), 1, out.size(), file) == out.size();
+    fclose(file);
+    return written;
+}
+
+GLuint Ktx2::loadTexture(const char* path, Resident* resident) {
+    MappedFile file;
+    if (!file.open(path) || file.size < headerSize || memcmp(file.data, identifier, sizeof(identifier)) != 0) {
+        std::cout << "ERROR::KTX2::OPEN_FAILED\n" << path << std::endl;
+        return 0;
+    }
+
+    const uint8_t* data = file.data;
+    const uint32_t vkFormat = get32(data + 12);
+    const uint32_t width = get32(data + 20);
+    const uint32_t height = get32(data + 24);
+    const uint32_t depth = get32(data + 28);
+    const uint32_t layers = get32(data + 32);
+    const uint32_t faces = get32(data + 36);
+    const uint32_t levelCount = get32(data + 40);
+    const uint32_t supercompression = get32(data + 44);
+
+    const FormatInfo* info = formatInfo(vkFormat);
+    if (!info || width == 0 || height == 0 || depth != 0 || layers != 0 || faces != 1 || supercompression != 0) {
+        std::cout << "ERROR::KTX2::UNSUPPORTED_FORMAT\n" << path << " (vkFormat " << vkFormat << ")" << std::endl;
+        return 0;
+    }
+
+    // levelCount 0 asks the loader to generate the mip chain
+    const uint32_t fileLevels = std::max(1u, levelCount);
+    const bool generateMips = levelCount == 0 && info->format != 0;
+    const uint32_t storageLevels = generateMips ? mipCount(width, height) : fileLevels;
+    if (headerSize + levelIndexSize * fileLevels > file.size || fileLevels > mipCount(width, height)) {
+        std::cout << "ERROR::KTX2::CORRUPT_LEVEL_INDEX\n" << path << std::endl;
+        return 0;
+    }
+    for (uint32_t i = 0; i < fileLevels; ++i) {
+        const uint8_t* entry = data + headerSize + levelIndexSize * i;
+        uint64_t offset = get64(entry), length = get64(entry + 8);
+        uint32_t w = std::max(1u, width >> i), h = std::max(1u, height >> i);
+        if (offset + length > file.size || length < levelSize(*info, w, h)) {
+            std::cout << "ERROR::KTX2::CORRUPT_LEVEL_INDEX\n" << path << " level " << i << std::endl;
+            return 0;
+        }
+    }
+
+    GLuint textureID;
+    glGenTextures(1, &textureID);
+    glBindTexture(GL_TEXTURE_2D, textureID);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    const bool immutable = GLEW_ARB_texture_storage;
+    if (immutable)
+        glTexStorage2D(GL_TEXTURE_2D, storageLevels, info->internalFormat, width, height);
+
+    // every level goes straight from the mapping to the driver
+    for (uint32_t i = 0; i < fileLevels; ++i) {
+        const uint8_t* entry = data + headerSize + levelIndexSize * i;
+        const uint8_t* pixels = data + get64(entry);
+        const GLsizei w = std::max(1u, width >> i), h = std::max(1u, height >> i);
+        const GLsizei size = GLsizei(levelSize(*info, w, h));
+
+        if (info->format == 0) {
+            if (immutable)
+                glCompressedTexSubImage2D(GL_TEXTURE_2D, i, 0, 0, w, h, info->internalFormat, size, pixels);
+            else
+                glCompressedTexImage2D(GL_TEXTURE_2D, i, info->internalFormat, w, h, 0, size, pixels);
+        } else {
+            if (immutable)
+                glTexSubImage2D(GL_TEXTURE_2D, i, 0, 0, w, h, info->format, info->type, pixels);
+            else
+                glTexImage2D(GL_TEXTURE_2D, i, info->internalFormat, w, h, 0, info->format, info->type, pixels);
+        }
+    }
+    if (generateMips)
+        glGenerateMipmap(GL_TEXTURE_2D);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    if (resident) {
+        resident->vkFormat = vkFormat;
+        resident->width = width;
+        resident->height = height;
+        resident->levels = storageLevels;
+        resident->bytes = 0;
+        for (uint32_t i = 0; i < storageLevels; ++i)
+            resident->bytes += levelSize(*info, std::max(1u, width >> i), std::max(1u, height >> i));
+    }
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, storageLevels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, storageLevels - 1);
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    return textureID;
+}
+
+int Ktx2::sourceChannels(uint32_t vkFormat) {
+    switch (vkFormat) {
+    case FORMAT_R8_UNORM:
+    case FORMAT_BC4_UNORM_BLOCK:
+        return 1;
+    case FORMAT_R8G8_UNORM:
+        return 2;
+    case FORMAT_R5G6B5_UNORM_PACK16:
+    case FORMAT_R8G8B8_UNORM:
+    case FORMAT_R8G8B8_SRGB:
+    case FORMAT_BC1_RGB_UNORM_BLOCK:
+    case FORMAT_BC1_RGB_SRGB_BLOCK:
+        return 3;
+    case FORMAT_R8G8B8A8_UNORM:
+    case FORMAT_R8G8B8A8_SRGB:
+    case FORMAT_BC3_UNORM_BLOCK:
+    case FORMAT_BC3_SRGB_BLOCK:
+    case FORMAT_R16G16B16A16_SFLOAT:
+        return 4;
+    default:
+        return 0;
+    }
+}
+
+std::vector<uint8_t> Ktx2::encodeLevel(uint32_t vkFormat, const unsigned char* pixels, int width, int height) {
+    const int channels = sourceChannels(vkFormat);
+    const size_t count = size_t(width) * height;
+    std::vector<uint8_t> encoded;
+
+    switch (vkFormat) {
+    case FORMAT_BC1_RGB_UNORM_BLOCK:
+    case FORMAT_BC1_RGB_SRGB_BLOCK:
+    case FORMAT_BC3_UNORM_BLOCK:
+    case FORMAT_BC3_SRGB_BLOCK: {
+        int size = 0;
+        unsigned char* blocks = channels == 3
+            ? convert_image_to_DXT1(pixels, width, height, channels, &size)
+            : convert_image_to_DXT5(pixels, width, height, channels, &size);
+        encoded.assign(blocks, blocks + size);
+        free(blocks);
+        break;
+    }
+    case FORMAT_BC4_UNORM_BLOCK:
+        encoded = encodeBC4(pixels, width, height);
+        break;
+    case FORMAT_R5G6B5_UNORM_PACK16:
+        encoded.resize(count * 2);
+        for (size_t i = 0; i < count; ++i) {
+            const unsigned char* p = &pixels[i * 3];
+            uint16_t packed = uint16_t(((p[0] >> 3) << 11) | ((p[1] >> 2) << 5) | (p[2] >> 3));
+            memcpy(&encoded[i * 2], &packed, 2);
+        }
+        break;
+    case FORMAT_R16G16B16A16_SFLOAT:
+        encoded.resize(count * 4 * 2);
+        for (size_t i = 0; i < count * 4; ++i) {
+            uint16_t half = glm::packHalf1x16(pixels[i] / 255.0f);
+            memcpy(&encoded[i * 2], &half, 2);
+        }
+        break;
+    default:
+        encoded.assign(pixels, pixels + count * channels);
+        break;
+    }
+    return encoded;
+}
+
+bool Ktx2::cook(const char* sourcePath, const char* path, uint32_t vkFormat) {
+    const int channels = sourceChannels(vkFormat);
+    if (channels == 0) {
+        std::cout << "ERROR::KTX2::COOK_FORMAT_UNSUPPORTED\n" << vkFormat << std::endl;
+        return false;
+    }
+
+    int width, height;
+    unsigned char* pixels = SOIL_load_image(sourcePath, &width, &height, 0, channels);
+    if (!pixels) {
+        std::cout << "ERROR::KTX2::COOK_LOAD_FAILED\n" << sourcePath << ": " << SOIL_last_result() << std::endl;
+        return false;
+    }
+
+    Image image;
+    image.vkFormat = vkFormat;
+    image.width = uint32_t(width);
+    image.height = uint32_t(height);
+
+    std::vector<unsigned char> level(pixels, pixels + size_t(width) * height * channels);
+    SOIL_free_image_data(pixels);
+
+    int w = width, h = height;
+    while (true) {
+        image.levels.push_back(encodeLevel(vkFormat, level.data(), w, h));
+
+        if (w == 1 && h == 1)
+            break;
+        std::vector<unsigned char> next(size_t(std::max(1, w / 2)) * std::max(1, h / 2) * channels);
+        mipmap_image(level.data(), w, h, channels, next.data(), 2, 2);
+        level.swap(next);
+        w = std::max(1, w / 2);
+        h = std::max(1, h / 2);
+    }
+
+    return write(path, image);
+}
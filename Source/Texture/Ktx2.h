@@ -0,0 +1,87 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstdint>
+#include <vector>
+
+// KTX2 texture container (https://registry.khronos.org/KTX/specs/2.0/ktxspec.v2.html).
+// Files hold GPU-ready payloads with their whole mip chain, so loading is a
+// mmap plus one upload per level. Only 2D, non-supercompressed files are supported.
+namespace Ktx2 {
+
+    // VkFormat values understood by the reader and writer
+    enum Format : uint32_t {
+        FORMAT_R5G6B5_UNORM_PACK16 = 4,
+        FORMAT_R8_UNORM = 9,
+        FORMAT_R8G8_UNORM = 16,
+        FORMAT_R8G8B8_UNORM = 23,
+        FORMAT_R8G8B8_SRGB = 29,
+        FORMAT_R8G8B8A8_UNORM = 37,
+        FORMAT_R8G8B8A8_SRGB = 43,
+        FORMAT_R16_SFLOAT = 76,
+        FORMAT_R16G16_SFLOAT = 83,
+        FORMAT_R16G16B16A16_SFLOAT = 97,
+        FORMAT_R32G32B32A32_SFLOAT = 109,
+        FORMAT_BC1_RGB_UNORM_BLOCK = 131,
+        FORMAT_BC1_RGB_SRGB_BLOCK = 132,
+        FORMAT_BC1_RGBA_UNORM_BLOCK = 133,
+        FORMAT_BC3_UNORM_BLOCK = 137,
+        FORMAT_BC3_SRGB_BLOCK = 138,
+        FORMAT_BC4_UNORM_BLOCK = 139,
+        FORMAT_BC5_UNORM_BLOCK = 141,
+        FORMAT_BC6H_UFLOAT_BLOCK = 143,
+        FORMAT_BC7_UNORM_BLOCK = 145,
+        FORMAT_BC7_SRGB_BLOCK = 146
+    };
+
+    struct FormatInfo {
+        uint32_t vkFormat;
+        GLenum internalFormat;
+        GLenum format;          // 0 for block compressed formats
+        GLenum type;
+        uint32_t blockWidth;
+        uint32_t blockHeight;
+        uint32_t blockBytes;
+    };
+
+    // nullptr if the format is not one of the above
+    const FormatInfo* formatInfo(uint32_t vkFormat);
+
+    // Byte size of one mip level of a width x height image
+    size_t levelSize(const FormatInfo& info, uint32_t width, uint32_t height);
+
+    // In-memory image for writing, levels[0] is the full resolution level
+    struct Image {
+        uint32_t vkFormat = FORMAT_R8G8B8A8_UNORM;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        std::vector<std::vector<uint8_t>> levels;
+    };
+
+    bool write(const char* path, const Image& image);
+
+    // What loadTexture allocated, generated mip levels included
+    struct Resident {
+        uint32_t vkFormat = 0;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t levels = 0;
+        size_t bytes = 0;
+    };
+
+    // Maps the file and uploads every level straight from the mapping into
+    // immutable storage. Returns 0 on failure.
+    GLuint loadTexture(const char* path, Resident* resident = nullptr);
+
+    // Channels an 8-bit source image needs for encodeLevel, 0 if vkFormat
+    // can't be encoded here (8-bit formats, RGB565, BC1, BC3, BC4, RGBA16F).
+    int sourceChannels(uint32_t vkFormat);
+
+    // Encodes one level of 8-bit pixels with sourceChannels(vkFormat) channels
+    std::vector<uint8_t> encodeLevel(uint32_t vkFormat, const unsigned char* pixels, int width, int height);
+
+    // Offline cooking: decode with SOIL, build the full mip chain and encode
+    // every level with encodeLevel.
+    bool cook(const char* sourcePath, const char* path, uint32_t vkFormat);
+}
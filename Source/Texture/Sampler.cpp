@@ -0,0 +1,529 @@
+#include "Sampler.h"
+
+#include <glm/gtc/packing.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <random>
+
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// MSVC takes AVX2 intrinsics anywhere, GCC and Clang only in functions built for it
+#if defined(__GNUC__)
+#define TARGET_AVX2 __attribute__((target("avx2,f16c")))
+#else
+#define TARGET_AVX2
+#endif
+
+namespace {
+
+    using Sampler::Format;
+    using Sampler::Image;
+    using Sampler::Layout;
+    using Sampler::Level;
+    using Sampler::Wrap;
+
+    // bit i of a 3 bit coordinate to bit 2i, x takes the even bits and y the odd ones
+    const uint8_t Spread[8] = { 0, 1, 4, 5, 16, 17, 20, 21 };
+
+    size_t texelIndex(const Image& image, const Level& level, int x, int y) {
+        if (image.layout == Layout::Linear)
+            return level.offset + size_t(y) * level.width + x;
+        const size_t tile = size_t(y >> 3) * level.tilesX + (x >> 3);
+        return level.offset + (tile << 6) + (Spread[x & 7] | (Spread[y & 7] << 1));
+    }
+
+    glm::vec4 fetch(const Image& image, size_t index) {
+        const uint8_t* texel = image.data.data() + index * image.texelSize;
+        switch (image.format) {
+        case Format::RGBA8:
+            return glm::vec4(texel[0], texel[1], texel[2], texel[3]) * (1.0f / 255.0f);
+        case Format::RGBA16F: {
+            uint16_t half[4];
+            std::memcpy(half, texel, sizeof(half));
+            return glm::vec4(glm::unpackHalf1x16(half[0]), glm::unpackHalf1x16(half[1]), glm::unpackHalf1x16(half[2]), glm::unpackHalf1x16(half[3]));
+        }
+        default: {
+            glm::vec4 value;
+            std::memcpy(&value, texel, sizeof(value));
+            return value;
+        }
+        }
+    }
+
+    void store(Image& image, size_t index, const glm::vec4& value) {
+        uint8_t* texel = image.data.data() + index * image.texelSize;
+        switch (image.format) {
+        case Format::RGBA8:
+            for (int c = 0; c < 4; ++c)
+                texel[c] = uint8_t(std::lround(std::clamp(value[c], 0.0f, 1.0f) * 255.0f));
+            break;
+        case Format::RGBA16F: {
+            const uint16_t half[4] = { glm::packHalf1x16(value.r), glm::packHalf1x16(value.g), glm::packHalf1x16(value.b), glm::packHalf1x16(value.a) };
+            std::memcpy(texel, half, sizeof(half));
+            break;
+        }
+        default:
+            std::memcpy(texel, &value, sizeof(value));
+            break;
+        }
+    }
+
+    int wrap(int x, int size, Wrap mode) {
+        if (mode == Wrap::ClampToEdge)
+            return std::clamp(x, 0, size - 1);
+        x %= size;
+        return x < 0 ? x + size : x;
+    }
+
+    glm::vec4 bilinear(const Image& image, const Level& level, Wrap mode, const glm::vec2& texcoord) {
+        const float u = texcoord.x * level.width - 0.5f;
+        const float v = texcoord.y * level.height - 0.5f;
+        const float fu = std::floor(u), fv = std::floor(v);
+        const float tu = u - fu, tv = v - fv;
+        const int x0 = wrap(int(fu), level.width, mode), x1 = wrap(int(fu) + 1, level.width, mode);
+        const int y0 = wrap(int(fv), level.height, mode), y1 = wrap(int(fv) + 1, level.height, mode);
+        const glm::vec4 top = glm::mix(fetch(image, texelIndex(image, level, x0, y0)), fetch(image, texelIndex(image, level, x1, y0)), tu);
+        const glm::vec4 bottom = glm::mix(fetch(image, texelIndex(image, level, x0, y1)), fetch(image, texelIndex(image, level, x1, y1)), tu);
+        return glm::mix(top, bottom, tv);
+    }
+
+    // The two levels to blend and the weight of the second, GL's mipmap selection
+    struct LevelChoice {
+        int first = 0;
+        int second = 0;
+        float blend = 0.0f;
+    };
+
+    LevelChoice chooseLevels(const Image& image, Sampler::MipFilter filter, float lod) {
+        const int last = int(image.levels.size()) - 1;
+        LevelChoice choice;
+        // lod <= 0 is magnification, always the base level
+        if (filter == Sampler::MipFilter::None || last == 0 || !(lod > 0.0f))
+            return choice;
+        if (filter == Sampler::MipFilter::Nearest) {
+            choice.first = choice.second = std::min(int(std::ceil(lod + 0.5f)) - 1, last);
+            return choice;
+        }
+        const float base = std::floor(lod);
+        if (base >= float(last)) {
+            choice.first = choice.second = last;
+            return choice;
+        }
+        choice.first = int(base);
+        choice.second = choice.first + 1;
+        choice.blend = lod - base;
+        return choice;
+    }
+
+    // Four lanes of one channel each, structure of arrays
+    struct Texels4 {
+        __m128 c[4];
+    };
+
+    struct LevelLanes {
+        alignas(16) int width[4];
+        alignas(16) int height[4];
+        alignas(16) int tilesX[4];
+        alignas(16) int offset[4];
+    };
+
+    // SSE2 has no floor, truncate and step down where that rounded up
+    __m128 floor4(__m128 x) {
+        const __m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(x));
+        return _mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, x), _mm_set1_ps(1.0f)));
+    }
+
+    __m128 wrap4(__m128 x, __m128 size, Wrap mode) {
+        if (mode == Wrap::ClampToEdge)
+            return _mm_min_ps(_mm_max_ps(x, _mm_setzero_ps()), _mm_sub_ps(size, _mm_set1_ps(1.0f)));
+        return _mm_sub_ps(x, _mm_mul_ps(floor4(_mm_div_ps(x, size)), size));
+    }
+
+    __m128i spread4(__m128i v) {
+        v = _mm_and_si128(_mm_or_si128(v, _mm_slli_epi32(v, 2)), _mm_set1_epi32(0x33));
+        return _mm_and_si128(_mm_or_si128(v, _mm_slli_epi32(v, 1)), _mm_set1_epi32(0x55));
+    }
+
+    // x and y are wrapped whole texel coordinates as floats, exact below 2^24
+    __m128i texelIndex4(Layout layout, const LevelLanes& lanes, __m128 x, __m128 y) {
+        const __m128i offset = _mm_load_si128(reinterpret_cast<const __m128i*>(lanes.offset));
+        if (layout == Layout::Linear) {
+            const __m128 width = _mm_cvtepi32_ps(_mm_load_si128(reinterpret_cast<const __m128i*>(lanes.width)));
+            return _mm_add_epi32(offset, _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(y, width), x)));
+        }
+        const __m128i ix = _mm_cvttps_epi32(x), iy = _mm_cvttps_epi32(y);
+        const __m128 tilesX = _mm_cvtepi32_ps(_mm_load_si128(reinterpret_cast<const __m128i*>(lanes.tilesX)));
+        const __m128 tile = _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(iy, 3)), tilesX), _mm_cvtepi32_ps(_mm_srai_epi32(ix, 3)));
+        const __m128i seven = _mm_set1_epi32(7);
+        const __m128i inner = _mm_or_si128(spread4(_mm_and_si128(ix, seven)), _mm_slli_epi32(spread4(_mm_and_si128(iy, seven)), 1));
+        return _mm_add_epi32(_mm_add_epi32(offset, _mm_slli_epi32(_mm_cvttps_epi32(tile), 6)), inner);
+    }
+
+    Texels4 unpackRGBA8(__m128i texels) {
+        const __m128i mask = _mm_set1_epi32(0xFF);
+        const __m128 scale = _mm_set1_ps(1.0f / 255.0f);
+        Texels4 result;
+        for (int c = 0; c < 4; ++c)
+            result.c[c] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(texels, 8 * c), mask)), scale);
+        return result;
+    }
+
+    Texels4 transpose(__m128 t0, __m128 t1, __m128 t2, __m128 t3) {
+        _MM_TRANSPOSE4_PS(t0, t1, t2, t3);
+        return { { t0, t1, t2, t3 } };
+    }
+
+    // two sets of four RGBA8 texels with one eight wide gather
+    TARGET_AVX2 void gatherRGBA8(const uint8_t* data, __m128i first, __m128i second, __m128i& outFirst, __m128i& outSecond) {
+        const __m256i texels = _mm256_i32gather_epi32(reinterpret_cast<const int*>(data), _mm256_set_m128i(second, first), 4);
+        outFirst = _mm256_castsi256_si128(texels);
+        outSecond = _mm256_extracti128_si256(texels, 1);
+    }
+
+    TARGET_AVX2 Texels4 fetchRGBA16FConverted(const uint8_t* data, const int* index) {
+        __m128 texels[4];
+        for (int lane = 0; lane < 4; ++lane)
+            texels[lane] = _mm_cvtph_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(data + size_t(index[lane]) * 8)));
+        return transpose(texels[0], texels[1], texels[2], texels[3]);
+    }
+
+    bool detectGather() {
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7)
+            return false;
+        __cpuid(info, 1);
+        const bool osSavesYmm = (info[2] & (1 << 27)) && (_xgetbv(0) & 6) == 6;
+        const bool f16c = info[2] & (1 << 29);
+        __cpuidex(info, 7, 0);
+        return osSavesYmm && f16c && (info[1] & (1 << 5));
+#else
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("f16c");
+#endif
+    }
+
+    // The four corners of each lane's footprint, 00 10 01 11
+    void fetchCorners(const Image& image, const __m128i index[4], Texels4 corners[4], bool gather) {
+        const uint8_t* data = image.data.data();
+        if (image.format == Format::RGBA8) {
+            __m128i texels[4];
+            if (gather) {
+                gatherRGBA8(data, index[0], index[1], texels[0], texels[1]);
+                gatherRGBA8(data, index[2], index[3], texels[2], texels[3]);
+            } else {
+                for (int corner = 0; corner < 4; ++corner) {
+                    alignas(16) int lanes[4];
+                    _mm_store_si128(reinterpret_cast<__m128i*>(lanes), index[corner]);
+                    const uint32_t* words = reinterpret_cast<const uint32_t*>(data);
+                    texels[corner] = _mm_setr_epi32(int(words[lanes[0]]), int(words[lanes[1]]), int(words[lanes[2]]), int(words[lanes[3]]));
+                }
+            }
+            for (int corner = 0; corner < 4; ++corner)
+                corners[corner] = unpackRGBA8(texels[corner]);
+            return;
+        }
+
+        for (int corner = 0; corner < 4; ++corner) {
+            alignas(16) int lanes[4];
+            _mm_store_si128(reinterpret_cast<__m128i*>(lanes), index[corner]);
+            if (image.format == Format::RGBA32F) {
+                const float* texels = reinterpret_cast<const float*>(data);
+                corners[corner] = transpose(_mm_loadu_ps(texels + size_t(lanes[0]) * 4), _mm_loadu_ps(texels + size_t(lanes[1]) * 4),
+                                            _mm_loadu_ps(texels + size_t(lanes[2]) * 4), _mm_loadu_ps(texels + size_t(lanes[3]) * 4));
+            } else if (gather) {
+                corners[corner] = fetchRGBA16FConverted(data, lanes);
+            } else {
+                glm::vec4 values[4];
+                for (int lane = 0; lane < 4; ++lane)
+                    values[lane] = fetch(image, size_t(lanes[lane]));
+                corners[corner] = transpose(_mm_loadu_ps(&values[0].x), _mm_loadu_ps(&values[1].x), _mm_loadu_ps(&values[2].x), _mm_loadu_ps(&values[3].x));
+            }
+        }
+    }
+
+    // Where a lane's bilinear footprint is and how much each corner weighs,
+    // the same for every image with the lanes' level sizes and layout
+    struct Footprint4 {
+        __m128i index[4];
+        __m128 weight[4];
+    };
+
+    Footprint4 footprint4(Layout layout, Wrap mode, const LevelLanes& lanes, __m128 u, __m128 v) {
+        const __m128 width = _mm_cvtepi32_ps(_mm_load_si128(reinterpret_cast<const __m128i*>(lanes.width)));
+        const __m128 height = _mm_cvtepi32_ps(_mm_load_si128(reinterpret_cast<const __m128i*>(lanes.height)));
+        const __m128 x = _mm_sub_ps(_mm_mul_ps(u, width), _mm_set1_ps(0.5f));
+        const __m128 y = _mm_sub_ps(_mm_mul_ps(v, height), _mm_set1_ps(0.5f));
+        const __m128 fx = floor4(x), fy = floor4(y);
+        const __m128 tu = _mm_sub_ps(x, fx), tv = _mm_sub_ps(y, fy);
+        const __m128 one = _mm_set1_ps(1.0f);
+
+        const __m128 x0 = wrap4(fx, width, mode), x1 = wrap4(_mm_add_ps(fx, one), width, mode);
+        const __m128 y0 = wrap4(fy, height, mode), y1 = wrap4(_mm_add_ps(fy, one), height, mode);
+        const __m128 su = _mm_sub_ps(one, tu), sv = _mm_sub_ps(one, tv);
+        return { { texelIndex4(layout, lanes, x0, y0), texelIndex4(layout, lanes, x1, y0),
+                   texelIndex4(layout, lanes, x0, y1), texelIndex4(layout, lanes, x1, y1) },
+                 { _mm_mul_ps(su, sv), _mm_mul_ps(tu, sv), _mm_mul_ps(su, tv), _mm_mul_ps(tu, tv) } };
+    }
+
+    Texels4 bilinear4(const Image& image, const Footprint4& footprint, bool gather) {
+        Texels4 corners[4];
+        fetchCorners(image, footprint.index, corners, gather);
+        Texels4 result;
+        for (int c = 0; c < 4; ++c) {
+            __m128 sum = _mm_mul_ps(corners[0].c[c], footprint.weight[0]);
+            for (int corner = 1; corner < 4; ++corner)
+                sum = _mm_add_ps(sum, _mm_mul_ps(corners[corner].c[c], footprint.weight[corner]));
+            result.c[c] = sum;
+        }
+        return result;
+    }
+
+    void setLane(LevelLanes& lanes, int lane, const Level& level) {
+        lanes.width[lane] = level.width;
+        lanes.height[lane] = level.height;
+        lanes.tilesX[lane] = level.tilesX;
+        lanes.offset[lane] = int(level.offset);
+    }
+
+    bool sameShape(const Image& a, const Image& b) {
+        if (a.format != b.format || a.layout != b.layout || a.levels.size() != b.levels.size())
+            return false;
+        for (size_t i = 0; i < a.levels.size(); ++i)
+            if (a.levels[i].width != b.levels[i].width || a.levels[i].height != b.levels[i].height || a.levels[i].offset != b.levels[i].offset)
+                return false;
+        return true;
+    }
+
+    // Four lookups into each of count images of the same shape, with their
+    // levels chosen per lane and the footprints worked out once for all
+    void sampleLanes(const Image* const* images, int count, const Sampler::State& state, __m128 u, __m128 v, const float* lod, Texels4* out) {
+        const Image& shape = *images[0];
+        const bool gather = Sampler::gatherSupported();
+        LevelLanes first, second;
+        alignas(16) float blend[4] = {};
+        bool trilinear = false;
+        if (state.mip == Sampler::MipFilter::None || shape.levels.size() == 1) {
+            // the base level in every lane, nothing to choose
+            for (int lane = 0; lane < 4; ++lane)
+                setLane(first, lane, shape.levels[0]);
+        } else {
+            for (int lane = 0; lane < 4; ++lane) {
+                const LevelChoice choice = chooseLevels(shape, state.mip, lod[lane]);
+                setLane(first, lane, shape.levels[choice.first]);
+                setLane(second, lane, shape.levels[choice.second]);
+                blend[lane] = choice.blend;
+                trilinear |= choice.blend != 0.0f;
+            }
+        }
+
+        const Footprint4 coarse = footprint4(shape.layout, state.wrap, first, u, v);
+        Footprint4 finer;
+        if (trilinear)
+            finer = footprint4(shape.layout, state.wrap, second, u, v);
+        const __m128 t = _mm_load_ps(blend);
+        for (int i = 0; i < count; ++i) {
+            out[i] = bilinear4(*images[i], coarse, gather);
+            if (!trilinear)
+                continue;
+            const Texels4 next = bilinear4(*images[i], finer, gather);
+            for (int c = 0; c < 4; ++c)
+                out[i].c[c] = _mm_add_ps(out[i].c[c], _mm_mul_ps(_mm_sub_ps(next.c[c], out[i].c[c]), t));
+        }
+    }
+
+    double since(std::chrono::high_resolution_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+}
+
+void Sampler::create(Image& image, Format format, Layout layout, const void* pixels, int width, int height, bool mipmaps) {
+    image.format = format;
+    image.layout = layout;
+    image.width = width;
+    image.height = height;
+    image.texelSize = format == Format::RGBA8 ? 4 : format == Format::RGBA16F ? 8 : 16;
+    image.levels.clear();
+    image.data.clear();
+
+    // decoded to float once, the mip chain is filtered from there
+    std::vector<glm::vec4> current(size_t(width) * height);
+    {
+        Image source;
+        source.format = format;
+        source.texelSize = image.texelSize;
+        source.data.assign(static_cast<const uint8_t*>(pixels), static_cast<const uint8_t*>(pixels) + current.size() * image.texelSize);
+        for (size_t i = 0; i < current.size(); ++i)
+            current[i] = fetch(source, i);
+    }
+
+    int levelWidth = width, levelHeight = height;
+    size_t texels = 0;
+    while (true) {
+        Level level;
+        level.width = levelWidth;
+        level.height = levelHeight;
+        level.offset = texels;
+        if (layout == Layout::Morton) {
+            level.tilesX = (levelWidth + TileSize - 1) / TileSize;
+            texels += size_t(level.tilesX) * ((levelHeight + TileSize - 1) / TileSize) * TileSize * TileSize;
+        } else {
+            texels += size_t(levelWidth) * levelHeight;
+        }
+        image.levels.push_back(level);
+        image.data.resize(texels * image.texelSize);
+
+        for (int y = 0; y < levelHeight; ++y)
+            for (int x = 0; x < levelWidth; ++x)
+                store(image, texelIndex(image, level, x, y), current[size_t(y) * levelWidth + x]);
+
+        if (!mipmaps || (levelWidth == 1 && levelHeight == 1))
+            break;
+
+        // 2x2 box filter, odd sizes drop their last row or column like most drivers
+        const int nextWidth = std::max(1, levelWidth / 2), nextHeight = std::max(1, levelHeight / 2);
+        std::vector<glm::vec4> next(size_t(nextWidth) * nextHeight);
+        for (int y = 0; y < nextHeight; ++y) {
+            const int y0 = std::min(2 * y, levelHeight - 1), y1 = std::min(2 * y + 1, levelHeight - 1);
+            for (int x = 0; x < nextWidth; ++x) {
+                const int x0 = std::min(2 * x, levelWidth - 1), x1 = std::min(2 * x + 1, levelWidth - 1);
+                next[size_t(y) * nextWidth + x] = 0.25f * (current[size_t(y0) * levelWidth + x0] + current[size_t(y0) * levelWidth + x1] +
+                                                           current[size_t(y1) * levelWidth + x0] + current[size_t(y1) * levelWidth + x1]);
+            }
+        }
+        current.swap(next);
+        levelWidth = nextWidth;
+        levelHeight = nextHeight;
+    }
+}
+
+float Sampler::lod(const Image& image, const glm::vec2& dx, const glm::vec2& dy) {
+    const glm::vec2 size(float(image.width), float(image.height));
+    const float rho = std::max(glm::length(dx * size), glm::length(dy * size));
+    return std::log2(std::max(rho, 1e-8f));
+}
+
+glm::vec4 Sampler::sample(const Image& image, const State& state, const glm::vec2& texcoord, float lod) {
+    const LevelChoice choice = chooseLevels(image, state.mip, lod);
+    const glm::vec4 first = bilinear(image, image.levels[choice.first], state.wrap, texcoord);
+    if (choice.blend == 0.0f)
+        return first;
+    return glm::mix(first, bilinear(image, image.levels[choice.second], state.wrap, texcoord), choice.blend);
+}
+
+void Sampler::sample4(const Image& image, const State& state, const float* u, const float* v, const float* lod, glm::vec4* out) {
+    const Image* images[1] = { &image };
+    Texels4 result;
+    sampleLanes(images, 1, state, _mm_loadu_ps(u), _mm_loadu_ps(v), lod, &result);
+    _MM_TRANSPOSE4_PS(result.c[0], result.c[1], result.c[2], result.c[3]);
+    for (int lane = 0; lane < 4; ++lane)
+        _mm_storeu_ps(&out[lane].x, result.c[lane]);
+}
+
+void Sampler::sample4Channels(const Image* const* images, int count, const State& state, const float* u, const float* v, const float* lod, float* out) {
+    const __m128 su = _mm_loadu_ps(u), sv = _mm_loadu_ps(v);
+    for (int i = 0; i < count;) {
+        // runs of images shaped like the first of the run share their footprints
+        int run = 1;
+        while (i + run < count && run < 4 && sameShape(*images[i], *images[i + run]))
+            ++run;
+        Texels4 results[4];
+        sampleLanes(images + i, run, state, su, sv, lod, results);
+        for (int k = 0; k < run; ++k)
+            for (int c = 0; c < 4; ++c)
+                _mm_storeu_ps(out + size_t(i + k) * 16 + c * 4, results[k].c[c]);
+        i += run;
+    }
+}
+
+bool Sampler::gatherSupported() {
+    static const bool supported = detectGather();
+    return supported;
+}
+
+void Sampler::benchmark() {
+    const int size = 1024;
+    const int screen = 512;
+    std::cout << "Texture sampling, million samples per second (" << size << "x" << size << ", "
+              << (gatherSupported() ? "AVX2 gathers" : "no AVX2") << ")" << std::endl;
+
+    // a noisy gradient, so the samples are not all one value
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::vector<glm::vec4> source(size_t(size) * size);
+    for (int y = 0; y < size; ++y)
+        for (int x = 0; x < size; ++x)
+            source[size_t(y) * size + x] = glm::vec4(float(x) / size, float(y) / size, unit(random), 1.0f);
+
+    struct Pattern { const char* name; MipFilter mip; float texelsPerPixel; bool random; };
+    const Pattern patterns[] = {
+        { "bilinear, 1:1", MipFilter::None, 1.0f, false },
+        { "trilinear, minified", MipFilter::Linear, 2.5f, false },
+        { "trilinear, random", MipFilter::Linear, 0.0f, true },
+    };
+
+    for (const Pattern& pattern : patterns) {
+        // a rotated view of the texture, scanline order like a rasterizer
+        const size_t count = size_t(screen) * screen;
+        std::vector<float> u(count), v(count), lods(count);
+        std::vector<glm::vec4> results(count);
+        const float angle = 1.0f;
+        const glm::vec2 stepX = glm::vec2(std::cos(angle), std::sin(angle)) * (pattern.texelsPerPixel / size);
+        const glm::vec2 stepY = glm::vec2(-stepX.y, stepX.x);
+        for (int y = 0; y < screen; ++y) {
+            for (int x = 0; x < screen; ++x) {
+                const size_t i = size_t(y) * screen + x;
+                const glm::vec2 uv = pattern.random ? glm::vec2(unit(random), unit(random))
+                                                    : glm::vec2(0.5f) + stepX * float(x - screen / 2) + stepY * float(y - screen / 2);
+                u[i] = uv.x;
+                v[i] = uv.y;
+                lods[i] = pattern.random ? unit(random) * 6.0f : std::log2(pattern.texelsPerPixel);
+            }
+        }
+
+        for (Format format : { Format::RGBA8, Format::RGBA16F, Format::RGBA32F }) {
+            std::cout << "  " << (format == Format::RGBA8 ? "RGBA8  " : format == Format::RGBA16F ? "RGBA16F" : "RGBA32F") << " " << pattern.name << ":";
+            for (Layout layout : { Layout::Linear, Layout::Morton }) {
+                // the sampler takes its pixels in the image's own format
+                Image staging;
+                staging.format = format;
+                staging.texelSize = format == Format::RGBA8 ? 4 : format == Format::RGBA16F ? 8 : 16;
+                staging.data.resize(source.size() * staging.texelSize);
+                for (size_t i = 0; i < source.size(); ++i)
+                    store(staging, i, source[i]);
+
+                Image image;
+                create(image, format, layout, staging.data.data(), size, size, pattern.mip != MipFilter::None);
+                State state;
+                state.mip = pattern.mip;
+
+                for (bool simd : { false, true }) {
+                    int runs = 0;
+                    double ms = 0.0;
+                    auto start = std::chrono::high_resolution_clock::now();
+                    while (runs < 3 || ms < 100.0) {
+                        if (simd) {
+                            for (size_t i = 0; i < count; i += 4)
+                                sample4(image, state, &u[i], &v[i], &lods[i], &results[i]);
+                        } else {
+                            for (size_t i = 0; i < count; ++i)
+                                results[i] = sample(image, state, glm::vec2(u[i], v[i]), lods[i]);
+                        }
+                        runs++;
+                        ms = since(start);
+                    }
+                    std::cout << " " << (layout == Layout::Linear ? "linear" : "Morton") << (simd ? " SIMD " : " scalar ")
+                              << std::round(double(count) * runs / ms / 100.0) / 10.0;
+                }
+            }
+            std::cout << std::endl;
+        }
+    }
+}
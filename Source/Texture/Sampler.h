@@ -0,0 +1,71 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Texture sampling on the CPU with GL's rules, for software rendering and
+// baking. The default state matches what loadTexture() sets, GL_LINEAR with
+// GL_CLAMP_TO_EDGE; mipmapped images also sample like
+// GL_LINEAR_MIPMAP_NEAREST/LINEAR. Texels can be stored row by row or in
+// 8x8 tiles with Morton order inside, which keeps a bilinear footprint and
+// its neighbours in one or two cache lines. sample4() does four lookups at
+// once, SSE for the addressing and filtering and AVX2 gathers for the
+// fetches when the CPU has them.
+namespace Sampler {
+
+    enum class Format { RGBA8, RGBA16F, RGBA32F };
+    enum class Layout { Linear, Morton };
+    enum class Wrap { ClampToEdge, Repeat };
+    enum class MipFilter { None, Nearest, Linear };
+
+    // Minification and magnification are always linear
+    struct State {
+        Wrap wrap = Wrap::ClampToEdge;
+        MipFilter mip = MipFilter::None;
+    };
+
+    const int TileSize = 8;
+
+    struct Level {
+        int width = 0;
+        int height = 0;
+        int tilesX = 0;             // Morton only
+        size_t offset = 0;          // in texels from the start of data
+    };
+
+    struct Image {
+        Format format = Format::RGBA8;
+        Layout layout = Layout::Linear;
+        int width = 0;
+        int height = 0;
+        size_t texelSize = 4;
+        std::vector<Level> levels;
+        std::vector<uint8_t> data;
+    };
+
+    // pixels are RGBA in the image's format, first row at t = 0. With
+    // mipmaps the chain down to 1x1 is built with a box filter.
+    void create(Image& image, Format format, Layout layout, const void* pixels, int width, int height, bool mipmaps);
+
+    // GL's level of detail from the texture coordinate derivatives across one pixel
+    float lod(const Image& image, const glm::vec2& dx, const glm::vec2& dy);
+
+    glm::vec4 sample(const Image& image, const State& state, const glm::vec2& texcoord, float lod = 0.0f);
+
+    // u, v and lod hold four values each
+    void sample4(const Image& image, const State& state, const float* u, const float* v, const float* lod, glm::vec4* out);
+
+    // The same four lookups into each of count images, without the
+    // transpose: out holds four reds, greens, blues and alphas per image, for
+    // callers shading in SSE lanes. Images of the same size, layout and
+    // format share the addressing and filter weights.
+    void sample4Channels(const Image* const* images, int count, const State& state, const float* u, const float* v, const float* lod, float* out);
+
+    bool gatherSupported();
+
+    // Samples per second across formats, layouts, filters and access patterns
+    void benchmark();
+}
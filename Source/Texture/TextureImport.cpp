@@ -0,0 +1,221 @@
+#include "TextureImport.h"
+#include "Ktx2.h"
+
+#include <SOIL.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+    const char* formatName(uint32_t vkFormat) {
+        switch (vkFormat) {
+        case Ktx2::FORMAT_R8_UNORM: return "R8";
+        case Ktx2::FORMAT_R8G8_UNORM: return "RG8";
+        case Ktx2::FORMAT_R5G6B5_UNORM_PACK16: return "RGB565";
+        case Ktx2::FORMAT_R8G8B8_UNORM: return "RGB8";
+        case Ktx2::FORMAT_R8G8B8_SRGB: return "SRGB8";
+        case Ktx2::FORMAT_R8G8B8A8_UNORM: return "RGBA8";
+        case Ktx2::FORMAT_R8G8B8A8_SRGB: return "SRGB8_ALPHA8";
+        case Ktx2::FORMAT_BC1_RGB_UNORM_BLOCK:
+        case Ktx2::FORMAT_BC1_RGB_SRGB_BLOCK:
+        case Ktx2::FORMAT_BC1_RGBA_UNORM_BLOCK: return "BC1";
+        case Ktx2::FORMAT_BC3_UNORM_BLOCK:
+        case Ktx2::FORMAT_BC3_SRGB_BLOCK: return "BC3";
+        case Ktx2::FORMAT_BC4_UNORM_BLOCK: return "BC4";
+        case Ktx2::FORMAT_BC5_UNORM_BLOCK: return "BC5";
+        case Ktx2::FORMAT_BC6H_UFLOAT_BLOCK: return "BC6H";
+        case Ktx2::FORMAT_BC7_UNORM_BLOCK:
+        case Ktx2::FORMAT_BC7_SRGB_BLOCK: return "BC7";
+        case Ktx2::FORMAT_R16_SFLOAT: return "R16F";
+        case Ktx2::FORMAT_R16G16_SFLOAT: return "RG16F";
+        case Ktx2::FORMAT_R16G16B16A16_SFLOAT: return "RGBA16F";
+        case Ktx2::FORMAT_R32G32B32A32_SFLOAT: return "RGBA32F";
+        default: return "?";
+        }
+    }
+
+    bool isCompressed(uint32_t vkFormat) {
+        return Ktx2::formatInfo(vkFormat)->format == 0;
+    }
+
+    // Repacks RGBA8 into the channel layout the chosen format is encoded from.
+    // Gray formats keep luminance in red and alpha in green, two channel color
+    // keeps red and green.
+    std::vector<unsigned char> extractChannels(const unsigned char* rgba, size_t count, uint32_t vkFormat, bool grayscale) {
+        const int channels = Ktx2::sourceChannels(vkFormat);
+        std::vector<unsigned char> out(count * channels);
+        for (size_t i = 0; i < count; ++i) {
+            const unsigned char* src = &rgba[i * 4];
+            unsigned char* dst = &out[i * channels];
+            switch (channels) {
+            case 1: dst[0] = src[0]; break;
+            case 2: dst[0] = src[0]; dst[1] = grayscale ? src[3] : src[1]; break;
+            case 3: dst[0] = src[0]; dst[1] = src[1]; dst[2] = src[2]; break;
+            default: dst[0] = src[0]; dst[1] = src[1]; dst[2] = src[2]; dst[3] = src[3]; break;
+            }
+        }
+        return out;
+    }
+
+    void account(TextureImport::Budget& budget, uint32_t vkFormat, size_t bytes, size_t rgba8Bytes) {
+        budget.used += bytes;
+        budget.baseline += rgba8Bytes;
+        budget.textures++;
+        if (isCompressed(vkFormat))
+            budget.compressed++;
+        if (budget.used > budget.limit)
+            budget.overBudget++;
+    }
+}
+
+TextureImport::Analysis TextureImport::analyze(const unsigned char* rgba, int width, int height, const Options& options) {
+    Analysis analysis;
+    const size_t count = size_t(width) * height;
+
+    for (size_t i = 0; i < count; ++i) {
+        const unsigned char* p = &rgba[i * 4];
+        for (int c = 0; c < 4; ++c) {
+            analysis.minValue[c] = std::min(analysis.minValue[c], p[c]);
+            analysis.maxValue[c] = std::max(analysis.maxValue[c], p[c]);
+        }
+        if (std::abs(p[0] - p[1]) > options.grayTolerance || std::abs(p[0] - p[2]) > options.grayTolerance)
+            analysis.grayscale = false;
+
+        // expand the 5/6-bit values back to 8 bits the way the GPU does
+        int r = p[0] >> 3, g = p[1] >> 2, b = p[2] >> 3;
+        int error = std::max({ std::abs(p[0] - ((r << 3) | (r >> 2))),
+                               std::abs(p[1] - ((g << 2) | (g >> 4))),
+                               std::abs(p[2] - ((b << 3) | (b >> 2))) });
+        analysis.max565Error = std::max(analysis.max565Error, error);
+    }
+    analysis.hasAlpha = analysis.minValue[3] < 255;
+
+    return analysis;
+}
+
+uint32_t TextureImport::chooseFormat(const Analysis& analysis, int width, int height, const Budget& budget,
+                                     const Options& options, bool allowCompressed) {
+    uint32_t candidates[2];
+
+    if (analysis.grayscale && !analysis.hasAlpha) {
+        candidates[0] = Ktx2::FORMAT_R8_UNORM;
+        candidates[1] = Ktx2::FORMAT_BC4_UNORM_BLOCK;
+    } else if (analysis.grayscale) {
+        candidates[0] = Ktx2::FORMAT_R8G8_UNORM;
+        candidates[1] = options.srgb ? Ktx2::FORMAT_BC3_SRGB_BLOCK : Ktx2::FORMAT_BC3_UNORM_BLOCK;
+    } else if (!analysis.hasAlpha && analysis.maxValue[1] <= options.zeroTolerance && analysis.maxValue[2] <= options.zeroTolerance) {
+        // only red carries anything, R8 samples green and blue as zero
+        candidates[0] = Ktx2::FORMAT_R8_UNORM;
+        candidates[1] = Ktx2::FORMAT_BC4_UNORM_BLOCK;
+    } else if (!analysis.hasAlpha && analysis.maxValue[2] <= options.zeroTolerance) {
+        // no BC5 encoder here, RG8 is already half of RGBA8
+        candidates[0] = Ktx2::FORMAT_R8G8_UNORM;
+        candidates[1] = Ktx2::FORMAT_R8G8_UNORM;
+    } else if (!analysis.hasAlpha) {
+        if (analysis.max565Error <= options.max565Error)
+            candidates[0] = Ktx2::FORMAT_R5G6B5_UNORM_PACK16;
+        else
+            candidates[0] = options.srgb ? Ktx2::FORMAT_R8G8B8_SRGB : Ktx2::FORMAT_R8G8B8_UNORM;
+        candidates[1] = options.srgb ? Ktx2::FORMAT_BC1_RGB_SRGB_BLOCK : Ktx2::FORMAT_BC1_RGB_UNORM_BLOCK;
+    } else {
+        candidates[0] = options.srgb ? Ktx2::FORMAT_R8G8B8A8_SRGB : Ktx2::FORMAT_R8G8B8A8_UNORM;
+        candidates[1] = options.srgb ? Ktx2::FORMAT_BC3_SRGB_BLOCK : Ktx2::FORMAT_BC3_UNORM_BLOCK;
+    }
+
+    const size_t remaining = budget.limit > budget.used ? budget.limit - budget.used : 0;
+    const size_t size = Ktx2::levelSize(*Ktx2::formatInfo(candidates[0]), width, height);
+    const bool fallbackSupported = allowCompressed || candidates[1] == Ktx2::FORMAT_BC4_UNORM_BLOCK;
+    if (size <= remaining || !fallbackSupported)
+        return candidates[0];
+    return candidates[1];
+}
+
+GLuint TextureImport::importTexture(const char* path, Budget& budget, const Options& options) {
+    int width, height;
+    unsigned char* image = SOIL_load_image(path, &width, &height, 0, SOIL_LOAD_RGBA);
+    if (!image) {
+        std::cout << "ERROR::TEXTURE::LOAD_FAILED\n" << path << ": " << SOIL_last_result() << std::endl;
+        return 0;
+    }
+
+    // BC4 (RGTC) is core since GL 3.0, BC1/BC3 still need S3TC
+    const bool allowCompressed = GLEW_EXT_texture_compression_s3tc;
+    const Analysis analysis = analyze(image, width, height, options);
+    const uint32_t vkFormat = chooseFormat(analysis, width, height, budget, options, allowCompressed);
+    const Ktx2::FormatInfo* info = Ktx2::formatInfo(vkFormat);
+
+    std::vector<unsigned char> source = extractChannels(image, size_t(width) * height, vkFormat, analysis.grayscale);
+    SOIL_free_image_data(image);
+    std::vector<uint8_t> level = Ktx2::encodeLevel(vkFormat, source.data(), width, height);
+
+    GLuint textureID;
+    glGenTextures(1, &textureID);
+    glBindTexture(GL_TEXTURE_2D, textureID);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    if (GLEW_ARB_texture_storage) {
+        glTexStorage2D(GL_TEXTURE_2D, 1, info->internalFormat, width, height);
+        if (info->format == 0)
+            glCompressedTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, info->internalFormat, GLsizei(level.size()), level.data());
+        else
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, info->format, info->type, level.data());
+    } else {
+        if (info->format == 0)
+            glCompressedTexImage2D(GL_TEXTURE_2D, 0, info->internalFormat, width, height, 0, GLsizei(level.size()), level.data());
+        else
+            glTexImage2D(GL_TEXTURE_2D, 0, info->internalFormat, width, height, 0, info->format, info->type, level.data());
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    // gray formats still sample as gray RGB(A) in the shaders
+    if (analysis.grayscale && Ktx2::sourceChannels(vkFormat) <= 2) {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_G, GL_RED);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_B, GL_RED);
+        if (vkFormat == Ktx2::FORMAT_R8G8_UNORM)
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_A, GL_GREEN);
+    }
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    account(budget, vkFormat, level.size(), size_t(width) * height * 4);
+
+    std::cout << "Imported " << path << " as " << formatName(vkFormat) << " (" << width << "x" << height
+              << (analysis.hasAlpha ? ", alpha" : "") << (analysis.grayscale ? ", gray" : "") << ")" << std::endl;
+
+    return textureID;
+}
+
+GLuint TextureImport::importKtx2(const char* path, Budget& budget) {
+    Ktx2::Resident resident;
+    const GLuint textureID = Ktx2::loadTexture(path, &resident);
+    if (!textureID)
+        return 0;
+
+    // compare against the same mip chain in RGBA8
+    size_t rgba8Bytes = 0;
+    for (uint32_t i = 0; i < resident.levels; ++i)
+        rgba8Bytes += size_t(std::max(1u, resident.width >> i)) * std::max(1u, resident.height >> i) * 4;
+    account(budget, resident.vkFormat, resident.bytes, rgba8Bytes);
+
+    std::cout << "Loaded " << path << " as " << formatName(resident.vkFormat) << " (" << resident.width << "x" << resident.height
+              << ", " << resident.levels << " levels)" << std::endl;
+
+    return textureID;
+}
+
+void TextureImport::printReport(const Budget& budget) {
+    std::cout << "Textures: " << budget.textures << " loaded, " << budget.compressed << " compressed, "
+              << budget.used / 1024 << " KB of " << budget.limit / 1024 << " KB budget, "
+              << std::abs(budget.saved()) / 1024 << (budget.saved() >= 0 ? " KB saved" : " KB more") << " vs RGBA8";
+    if (budget.overBudget > 0)
+        std::cout << " (" << budget.overBudget << " over budget)";
+    std::cout << std::endl;
+}
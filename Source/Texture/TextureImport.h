@@ -0,0 +1,60 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstddef>
+#include <cstdint>
+
+// Texture import stage: looks at the decoded pixels and picks the smallest
+// internal format that still represents them, instead of RGBA8 for everything.
+// Green and blue that stay near zero are dropped (R8, RG8), since those read
+// back as zero anyway. Cooked KTX2 files are loaded as they are but still
+// count against the budget.
+namespace TextureImport {
+
+    struct Analysis {
+        bool hasAlpha = false;      // some alpha below 255
+        bool grayscale = true;      // r, g and b agree within Options::grayTolerance
+        uint8_t minValue[4] = { 255, 255, 255, 255 };   // per channel
+        uint8_t maxValue[4] = { 0, 0, 0, 0 };
+        int max565Error = 0;        // worst per-channel error of an RGB565 round trip
+    };
+
+    struct Options {
+        int grayTolerance = 2;
+        int zeroTolerance = 2;      // channels that never go above this are dropped
+        int max565Error = 2;        // RGB565 only for content that already is that coarse
+        bool srgb = false;          // color textures as SRGB8 (needs an sRGB-aware pipeline)
+    };
+
+    // Global VRAM budget shared by every imported texture
+    struct Budget {
+        size_t limit = 256u << 20;
+        size_t used = 0;
+        size_t baseline = 0;        // what RGBA8 would have cost
+        int textures = 0;
+        int compressed = 0;
+        int overBudget = 0;
+
+        // negative when float KTX2 textures cost more than RGBA8 would have
+        int64_t saved() const { return int64_t(baseline) - int64_t(used); }
+    };
+
+    Analysis analyze(const unsigned char* rgba, int width, int height, const Options& options);
+
+    // Candidates from best quality to smallest, the first one that fits the
+    // remaining budget wins. allowCompressed gates the S3TC fallbacks.
+    // Returns a Ktx2::Format value.
+    uint32_t chooseFormat(const Analysis& analysis, int width, int height, const Budget& budget,
+                          const Options& options, bool allowCompressed);
+
+    // Decodes with SOIL, chooses a format and uploads into immutable storage.
+    // Returns 0 on failure.
+    GLuint importTexture(const char* path, Budget& budget, const Options& options = Options());
+
+    // Loads a cooked KTX2 file in its own format and mip chain, and charges
+    // it to the budget. Returns 0 on failure.
+    GLuint importKtx2(const char* path, Budget& budget);
+
+    void printReport(const Budget& budget);
+}